@@ -0,0 +1,79 @@
+#!/bin/bash
+
+# Runs several simulations at the same time, each one with its own access key, logging file and error files.
+# Every run gets a directory «outdir»/«run» and a line "run,status,wall_ms" in «outdir»/summary.csv; «outdir» must
+# not exist or be empty.
+# Shared memory and semaphores left behind by a run (crash or timeout) are removed when it ends.
+
+usage() {
+    echo "USAGE: $0 [-j «jobs»] [-o «outdir»] [-T «timeout-s»] [-x «program»] «number-of-runs» [«generator-options»...]"
+    exit 1
+}
+
+jobs=$(nproc)
+out=batch
+limit=60
+prog=./probSemSharedMemRestaurant
+while getopts "j:o:T:x:" opt; do
+    case $opt in
+        j) jobs=$OPTARG;;
+        o) out=$OPTARG;;
+        T) limit=$OPTARG;;
+        x) prog=$OPTARG;;
+        *) usage;;
+    esac
+done
+shift $((OPTIND-1))
+[ $# -ge 1 ] || usage
+n=$1; shift
+
+if ! [ $n -gt 0 ] 2>/dev/null || ! [ $jobs -gt 0 ] 2>/dev/null; then
+    echo "Wrong argument value. Aborting."
+    exit 1
+fi
+
+# keys of this batch: 0x40000000 | «pid» << 8 | «slot», with the whole pid (Linux pids fit 22 bits), so that two
+# batches never share a key, and a slot per job, locked while its run goes on, so that two runs never do
+base=$(( 0x40000000 | (($$ & 0x3FFFFF) << 8) ))
+if [ $jobs -gt 256 ]; then
+    echo "At most 256 jobs per batch. Aborting."
+    exit 1
+fi
+
+if [ -e "$out" ] && ! [ -d "$out" -a -z "$(ls -A "$out" 2>/dev/null)" ]; then
+    echo "Output directory \"$out\" exists and is not empty. Aborting."
+    exit 1
+fi
+mkdir -p "$out"
+
+runOne() {
+    local i=$1 slot=0 key dir=$(printf "%s/%05d" "$out" $1) t0 t1 rc
+    # at most «jobs» runs go on at the same time, so a slot is soon free; its lock goes with this process
+    until exec {lock}>"$out/.slot$slot" && flock -n $lock; do
+        exec {lock}>&-
+        slot=$(( (slot + 1) % jobs ))
+    done
+    key=$(( base + slot ))
+    mkdir -p "$dir"
+    t0=$(date +%s%N)
+    timeout -k 1 $limit "$prog" "${opts[@]}" -k $key -e "$dir/error_" "$dir/log.txt" >"$dir/stdout" 2>"$dir/stderr"
+    rc=$?
+    t1=$(date +%s%N)
+    # a generator that crashes or times out leaves its entities and the IPC objects behind
+    pkill -KILL -f -- "$dir/log.txt" 2>/dev/null
+    ipcrm -M $key 2>/dev/null
+    ipcrm -S $key 2>/dev/null
+    echo "$i,$rc,$(( (t1 - t0) / 1000000 ))" >> "$out/summary.tmp"
+}
+
+opts=("$@")
+export out base limit prog jobs
+export -f runOne
+seq 1 $n | xargs -P $jobs -I{} bash -c "opts=($(printf '%q ' "${opts[@]}")); runOne {}"
+
+echo "run,status,wall_ms" > "$out/summary.csv"
+sort -t, -n -k1 "$out/summary.tmp" >> "$out/summary.csv"
+rm -f "$out/summary.tmp" "$out"/.slot*
+
+awk -F, 'NR > 1 { n++; if ($2 != 0) f++; s += $3; if ($3 > m) m = $3 }
+         END { printf "%d runs, %d failed, wall time mean %.1f ms, max %d ms\n", n, f, s / n, m }' "$out/summary.csv"
@@ -1,5 +1,11 @@
 #!/bin/bash
 
+# with -d, the delta logging mode of the generator writes unchanged entity states as "." (no filtering needed)
+if [ "$1" = "-d" ]; then
+    ./probSemSharedMemRestaurant -d
+    exit
+fi
+
 ngroups=$( head -2 config.txt | tail -1 )
 
 ./probSemSharedMemRestaurant | awk -f filter_log.awk -v ngroups=$ngroups
@@ -0,0 +1,87 @@
+#!/bin/bash
+
+# Scalability sweep: the simulation is run over a grid of groups x tables x waiters x chefs, several seeds per cell.
+# Groups arrive as a Poisson process of «rate» groups per second and eat for an exponential time of mean «eat-us»
+# microseconds; seed s (1 .. «seeds») draws both the schedule and the entities' random numbers.
+# Results are written to stdout as CSV, one line per cell, with the mean over the seeds of:
+#   makespan_ms          wall time of the generator
+#   table_wait_*_us      time a group waits at the reception for a table (mean and 99th percentile)
+#   food_wait_*_us       time a group waits for its food (mean and 99th percentile)
+#   lock_held_frac       time the locks were held over the makespan; with -g every lock is the same mutex, otherwise
+#                        the lock domains add up and the fraction may go over 1
+# The times are taken from the latency report the generator writes with -L.
+# Generator options (e.g. -- -b -g) follow a "--" and are passed on to every run.
+
+usage() {
+    echo "USAGE: $0 [-G «groups-list»] [-T «tables-list»] [-W «waiters-list»] [-C «chefs-list»] [-n «seeds»]"
+    echo "       [-a «rate»] [-e «eat-us»] [-L «timeout-s»] [-x «program»] [-- «generator-options»...]"
+    exit 1
+}
+
+groups="16 64 256"
+tables="2 8 32"
+waiters="1 2"
+chefs="1 2"
+seeds=3
+rate=2000
+eat=5000
+limit=60
+prog=probSemSharedMemRestaurant
+while getopts "G:T:W:C:n:a:e:L:x:" opt; do
+    case $opt in
+        G) groups=$OPTARG;;
+        T) tables=$OPTARG;;
+        W) waiters=$OPTARG;;
+        C) chefs=$OPTARG;;
+        n) seeds=$OPTARG;;
+        a) rate=$OPTARG;;
+        e) eat=$OPTARG;;
+        L) limit=$OPTARG;;
+        x) prog=${OPTARG#./};;
+        *) usage;;
+    esac
+done
+shift $((OPTIND-1))
+
+if ! [ $seeds -gt 0 ] 2>/dev/null; then
+    echo "Wrong number of seeds. Aborting." >&2
+    exit 1
+fi
+
+here=$(pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+for p in $prog group waiter chef receptionist; do
+    ln -s "$here/$p" "$work/$p"
+done
+
+key=$(( 0x5C000000 | (($$ & 0xFFFF) << 8) ))
+echo "groups,tables,waiters,chefs,seeds,makespan_ms,table_wait_mean_us,table_wait_p99_us,food_wait_mean_us,food_wait_p99_us,lock_held_frac"
+for g in $groups; do
+    for t in $tables; do
+        for w in $waiters; do
+            for c in $chefs; do
+                for s in $(seq 1 $seeds); do
+                    { echo "#workload"; echo "$g poisson $rate exp $eat $s"; echo "#ntables"; echo $t; } > "$work/config.txt"
+                    t0=$(date +%s%N)
+                    if ! (cd "$work" && timeout $limit ./$prog "$@" -w $w -c $c -k $key -e "$work/error_" \
+                          -L "$work/report.txt" "$work/log.txt" >/dev/null 2>&1); then
+                        echo "Run with $g groups, $t tables, $w waiters, $c chefs and seed $s failed. Aborting." >&2
+                        exit 1
+                    fi
+                    t1=$(date +%s%N)
+                    # one line per run: makespan (ns) and the figures of the latency report
+                    awk -v ns=$(( t1 - t0 )) '
+                        $1 == "wait" && $2 == "waitForTable" { tm = $4; tp = $6 }
+                        $1 == "wait" && $2 == "foodArrived"  { fm = $4; fp = $6 }
+                        $1 == "hold"                         { held += $3 * $4 }
+                        END { printf "%d %f %f %f %f %f\n", ns, tm, tp, fm, fp, held * 1000 / ns }' "$work/report.txt"
+                done | awk -v g=$g -v t=$t -v w=$w -v c=$c '
+                    { for (i = 1; i <= NF; i++) sum[i] += $i; n++ }
+                    END { if (n > 0) printf "%d,%d,%d,%d,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.4f\n", g, t, w, c, n,
+                              sum[1] / n / 1e6, sum[2] / n, sum[3] / n, sum[4] / n, sum[5] / n, sum[6] / n }'
+                [ ${PIPESTATUS[0]} -eq 0 ] || exit 1
+            done
+        done
+    done
+done
@@ -0,0 +1,381 @@
+/**
+ *  \file config.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Loading of the simulation configuration.
+ *
+ *  Defined operations:
+ *     \li loading of a configuration file
+ *     \li saving of a configuration as a binary schedule
+ *     \li release of a loaded configuration.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "probConst.h"
+#include "config.h"
+#include "workload.h"
+
+/**
+ *  \brief Definition of the scanning state of a text configuration.
+ */
+typedef struct {
+    /** \brief name of the file (for the error messages) */
+    char *path;
+    /** \brief next character */
+    const char *p;
+    /** \brief end of the text */
+    const char *end;
+    /** \brief line of the next character */
+    unsigned int line;
+} SCAN;
+
+/* internal functions */
+
+/** \brief reporting of an error at the present line */
+static int scanError (SCAN *sc, char *what, int n)
+{
+    fprintf (stderr, "%s:%u: ", sc->path, sc->line);
+    fprintf (stderr, what, n);
+    fprintf (stderr, "!\n");
+    return -1;
+}
+
+/** \brief skipping of white space and comments */
+static void skipBlank (SCAN *sc)
+{
+    while (sc->p < sc->end) {
+        if (*sc->p == '#') {
+            while ((sc->p < sc->end) && (*sc->p != '\n')) {
+                sc->p++;
+            }
+        }
+        else if ((*sc->p == ' ') || (*sc->p == '\t') || (*sc->p == '\r')) {
+            sc->p++;
+        }
+        else if (*sc->p == '\n') {
+            sc->p++;
+            sc->line++;
+        }
+        else break;
+    }
+}
+
+/**
+ *  \brief scanning of the next integer
+ *
+ *  \return 1, if an integer was read; 0, at the end of the text; -1, if the next word is not an integer
+ */
+static int scanInt (SCAN *sc, int *v)
+{
+    long long n = 0;
+    bool neg = false;
+    const char *start;
+
+    skipBlank (sc);
+    if (sc->p == sc->end) {
+        return 0;
+    }
+    if (*sc->p == '-') {
+        neg = true;
+        sc->p++;
+    }
+    start = sc->p;
+    while ((sc->p < sc->end) && (*sc->p >= '0') && (*sc->p <= '9')) {
+        n = n * 10 + (*sc->p++ - '0');
+        if (n > INT_MAX) {
+            return -1;
+        }
+    }
+    if ((sc->p == start) ||
+        ((sc->p < sc->end) && !strchr (" \t\r\n#", *sc->p))) {                          /* not a whole number */
+        return -1;
+    }
+    *v = (int) (neg ? -n : n);
+    return 1;
+}
+
+/** \brief parsing of a text configuration */
+static int parseText (SCAN *sc, CONFIG *cf)
+{
+    char spec[256];
+    size_t len;
+    int g, t, stat;
+
+    cf->generated = ((size_t) (sc->end - sc->p) >= 9) && (strncmp (sc->p, "#workload", 9) == 0);
+    if (cf->generated) {
+        while ((sc->p < sc->end) && (*sc->p++ != '\n')) ;                           /* the specification line */
+        sc->line++;
+        for (len = 0; (sc->p + len < sc->end) && (sc->p[len] != '\n') && (len < sizeof (spec) - 1); len++) {
+            spec[len] = sc->p[len];
+        }
+        spec[len] = '\0';
+        if (workloadParse (spec, &cf->wl) == -1) {
+            return scanError (sc, "Wrong workload specification", 0);
+        }
+        while ((sc->p < sc->end) && (*sc->p != '\n')) {
+            sc->p++;
+        }
+        cf->nGroups = cf->wl.nGroups;
+    }
+    else if ((scanInt (sc, &cf->nGroups) != 1) || (cf->nGroups < 1) || (cf->nGroups > MAXGROUPS)) {
+        return scanError (sc, "Number of groups must be in 1 .. %d", MAXGROUPS);
+    }
+
+    if (((cf->startTime = malloc (cf->nGroups * sizeof (int))) == NULL) ||
+        ((cf->eatTime = malloc (cf->nGroups * sizeof (int))) == NULL) ||
+        ((cf->groupSize = malloc (cf->nGroups * sizeof (int))) == NULL)) {
+        perror ("error on allocating the group times");
+        return -1;
+    }
+    if (cf->generated) {
+        workloadSchedule (&cf->wl, cf->startTime, cf->eatTime, cf->groupSize);
+    }
+    else {
+        for (g = 0; g < cf->nGroups; g++) {
+            if ((stat = scanInt (sc, &cf->startTime[g])) == 0) {
+                return scanError (sc, "Missing start time of group %d", g);
+            }
+            if ((stat == -1) || (cf->startTime[g] < 0)) {
+                return scanError (sc, "Start time of group %d must be a non negative number", g);
+            }
+            if ((stat = scanInt (sc, &cf->eatTime[g])) == 0) {
+                return scanError (sc, "Missing eat time of group %d", g);
+            }
+            if ((stat == -1) || (cf->eatTime[g] < 0)) {
+                return scanError (sc, "Eat time of group %d must be a non negative number", g);
+            }
+        }
+    }
+
+    cf->nTables = DEFTABLES;                                          /* optional number of tables, after the groups */
+    if (((stat = scanInt (sc, &cf->nTables)) == -1) || (cf->nTables < 1) || (cf->nTables > MAXGROUPS)) {
+        return scanError (sc, "Number of tables must be in 1 .. %d", MAXGROUPS);
+    }
+    if ((cf->tableCap = malloc (cf->nTables * sizeof (int))) == NULL) {
+        perror ("error on allocating the table seats");
+        return -1;
+    }
+    for (t = 0; t < cf->nTables; t++) {
+        cf->tableCap[t] = DEFCAPACITY;
+    }
+    if (!cf->generated) {
+        for (g = 0; g < cf->nGroups; g++) {
+            cf->groupSize[g] = 1;
+        }
+    }
+
+    for (t = 0; (stat == 1) && (t < cf->nTables); t++) {           /* optional seats of the tables, after their number */
+        if ((stat = scanInt (sc, &cf->tableCap[t])) == 0) {
+            if (t == 0) {
+                break;
+            }
+            return scanError (sc, "Missing number of seats of table %d", t);
+        }
+        if ((stat == -1) || (cf->tableCap[t] < 1)) {
+            return scanError (sc, "Number of seats of table %d must be a positive number", t);
+        }
+    }
+    for (g = 0; (stat == 1) && !cf->generated && (g < cf->nGroups); g++) {   /* optional group sizes, after the seats */
+        if ((stat = scanInt (sc, &cf->groupSize[g])) == 0) {
+            if (g == 0) {
+                break;
+            }
+            return scanError (sc, "Missing number of people of group %d", g);
+        }
+        if ((stat == -1) || (cf->groupSize[g] < 1)) {
+            return scanError (sc, "Number of people of group %d must be a positive number", g);
+        }
+    }
+    skipBlank (sc);
+    if (sc->p != sc->end) {
+        return scanError (sc, "Unexpected text after the tables and the groups", 0);
+    }
+    return 0;
+}
+
+/** \brief checking of the seats for every group */
+static int checkFit (char path[], CONFIG *cf)
+{
+    int g, t, most = 0;
+
+    for (t = 0; t < cf->nTables; t++) {
+        if (cf->tableCap[t] > most) {
+            most = cf->tableCap[t];
+        }
+    }
+    for (g = 0; g < cf->nGroups; g++) {
+        if (cf->groupSize[g] > most) {
+            fprintf (stderr, "%s: group %d has %d people, more than the seats of any table!\n", path, g,
+                     cf->groupSize[g]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/** \brief validation of a binary schedule */
+static int checkSchedule (char path[], CONFIG *cf)
+{
+    SCHED_HEADER *hd = cf->map;
+    int g, t;
+
+    if ((hd->nTables < 1) || (hd->nTables > MAXGROUPS)) {
+        fprintf (stderr, "%s: number of tables must be in 1 .. %d!\n", path, MAXGROUPS);
+        return -1;
+    }
+    if ((hd->nGroups < 1) || (hd->nGroups > MAXGROUPS) ||
+        (cf->mapLen != sizeof (SCHED_HEADER) + (3 * (size_t) hd->nGroups + hd->nTables) * sizeof (int))) {
+        fprintf (stderr, "%s: the size of the binary schedule does not match its number of groups and tables!\n",
+                 path);
+        return -1;
+    }
+    cf->nGroups = hd->nGroups;
+    cf->nTables = hd->nTables;
+    cf->startTime = (int *) (hd + 1);
+    cf->eatTime = cf->startTime + cf->nGroups;
+    cf->groupSize = cf->eatTime + cf->nGroups;
+    cf->tableCap = cf->groupSize + cf->nGroups;
+    for (g = 0; g < cf->nGroups; g++) {
+        if ((cf->startTime[g] < 0) || (cf->eatTime[g] < 0)) {
+            fprintf (stderr, "%s: times of group %d must be non negative!\n", path, g);
+            return -1;
+        }
+        if (cf->groupSize[g] < 1) {
+            fprintf (stderr, "%s: number of people of group %d must be positive!\n", path, g);
+            return -1;
+        }
+    }
+    for (t = 0; t < cf->nTables; t++) {
+        if (cf->tableCap[t] < 1) {
+            fprintf (stderr, "%s: number of seats of table %d must be positive!\n", path, t);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* external functions */
+
+/**
+ *  \brief Loading of a configuration file.
+ *
+ *  \param path name of the configuration file
+ *  \param cf pointer to the location where the configuration is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the file could not be read or is wrong (the error is reported on stderr)
+ */
+int configLoad (char path[], CONFIG *cf)
+{
+    struct stat st;
+    SCAN sc;
+    int fd, status;
+
+    memset (cf, 0, sizeof (CONFIG));
+    if ((fd = open (path, O_RDONLY)) == -1) {
+        perror ("Could not open config file");
+        return -1;
+    }
+    if (fstat (fd, &st) == -1) {
+        perror ("Could not read config file");
+        close (fd);
+        return -1;
+    }
+    if (st.st_size == 0) {
+        fprintf (stderr, "%s: config file is empty!\n", path);
+        close (fd);
+        return -1;
+    }
+    cf->mapLen = st.st_size;
+    if ((cf->map = mmap (NULL, cf->mapLen, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+        perror ("Could not map config file");
+        cf->map = NULL;
+        close (fd);
+        return -1;
+    }
+    close (fd);
+
+    if ((cf->mapLen >= sizeof (SCHED_HEADER)) && (memcmp (cf->map, SCHEDMAGIC, strlen (SCHEDMAGIC)) == 0)) {
+        if ((checkSchedule (path, cf) == -1) || (checkFit (path, cf) == -1)) {
+            configFree (cf);
+            return -1;
+        }
+        return 0;                                                   /* the arrays stay in the mapping */
+    }
+
+    sc.path = path;
+    sc.p = cf->map;
+    sc.end = sc.p + cf->mapLen;
+    sc.line = 1;
+    status = parseText (&sc, cf);
+    munmap (cf->map, cf->mapLen);
+    cf->map = NULL;
+    if ((status == 0) && (checkFit (path, cf) == -1)) {
+        status = -1;
+    }
+    if (status == -1) {
+        configFree (cf);
+    }
+    return status;
+}
+
+/**
+ *  \brief Saving of a configuration as a binary schedule.
+ *
+ *  \param path name of the binary schedule
+ *  \param cf pointer to the configuration
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int configSave (char path[], CONFIG *cf)
+{
+    SCHED_HEADER hd;
+    FILE *fp;
+
+    memcpy (hd.magic, SCHEDMAGIC, sizeof (hd.magic));
+    hd.nGroups = cf->nGroups;
+    hd.nTables = cf->nTables;
+    if ((fp = fopen (path, "w")) == NULL) {
+        return -1;
+    }
+    if ((fwrite (&hd, sizeof (hd), 1, fp) != 1) ||
+        (fwrite (cf->startTime, sizeof (int), cf->nGroups, fp) != (size_t) cf->nGroups) ||
+        (fwrite (cf->eatTime, sizeof (int), cf->nGroups, fp) != (size_t) cf->nGroups) ||
+        (fwrite (cf->groupSize, sizeof (int), cf->nGroups, fp) != (size_t) cf->nGroups) ||
+        (fwrite (cf->tableCap, sizeof (int), cf->nTables, fp) != (size_t) cf->nTables)) {
+        fclose (fp);
+        return -1;
+    }
+    return (fclose (fp) == EOF) ? -1 : 0;
+}
+
+/**
+ *  \brief Release of a loaded configuration.
+ *
+ *  \param cf pointer to the configuration
+ */
+void configFree (CONFIG *cf)
+{
+    if (cf->map != NULL) {
+        munmap (cf->map, cf->mapLen);
+    }
+    else {
+        free (cf->startTime);
+        free (cf->eatTime);
+        free (cf->groupSize);
+        free (cf->tableCap);
+    }
+    cf->map = NULL;
+    cf->startTime = cf->eatTime = cf->groupSize = cf->tableCap = NULL;
+}
@@ -0,0 +1,106 @@
+/**
+ *  \file config.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Loading of the simulation configuration.
+ *
+ *  Defined operations:
+ *     \li loading of a configuration file
+ *     \li saving of a configuration as a binary schedule
+ *     \li release of a loaded configuration.
+ *
+ *  A configuration file is either a text file or a binary schedule.
+ *
+ *  A text file has the number of groups, the start and eat time (in us) of each group and, optionally, the number
+ *  of tables (DEFTABLES if absent), the number of seats of each table (DEFCAPACITY if absent) and, when the seats
+ *  are there, the number of people of each group (1 if absent), all separated by white space; a <tt>#</tt> starts a
+ *  comment that goes to the end of the line. If the first line is <tt>#workload</tt>, the next one is a workload
+ *  specification from which the number of groups, their times and their sizes are generated (see workload.h), and
+ *  only the number of tables and their seats may follow. The file is mapped and parsed in a single pass; errors
+ *  are reported on stderr with the line they were found at. Every group must fit at some table.
+ *
+ *  A binary schedule is a SCHED_HEADER followed by the start times, the eat times and the sizes of the groups and
+ *  the seats of the tables, as arrays of int in the byte order of the machine. It is mapped and its arrays are used
+ *  in place, with no parsing.
+ */
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "workload.h"
+
+/** \brief first bytes of a binary schedule */
+#define  SCHEDMAGIC        "RSTSCHD2"
+
+/**
+ *  \brief Definition of the header of a binary schedule.
+ */
+typedef struct {
+    /** \brief SCHEDMAGIC, without the terminating null character */
+    char magic[8];
+    /** \brief number of groups */
+    int nGroups;
+    /** \brief number of tables */
+    int nTables;
+} SCHED_HEADER;
+
+/**
+ *  \brief Definition of a loaded configuration.
+ */
+typedef struct {
+    /** \brief number of groups */
+    int nGroups;
+    /** \brief number of tables */
+    int nTables;
+    /** \brief start time of each group (in us) */
+    int *startTime;
+    /** \brief eat time of each group (in us) */
+    int *eatTime;
+    /** \brief number of people of each group */
+    int *groupSize;
+    /** \brief number of seats of each table */
+    int *tableCap;
+    /** \brief generated workload flag */
+    bool generated;
+    /** \brief workload the times were generated from (if generated) */
+    WORKLOAD wl;
+    /** \brief mapping of the binary schedule the arrays are in (NULL if they were allocated) */
+    void *map;
+    /** \brief length of the mapping */
+    size_t mapLen;
+} CONFIG;
+
+/**
+ *  \brief Loading of a configuration file.
+ *
+ *  \param path name of the configuration file
+ *  \param cf pointer to the location where the configuration is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the file could not be read or is wrong (the error is reported on stderr)
+ */
+extern int configLoad (char path[], CONFIG *cf);
+
+/**
+ *  \brief Saving of a configuration as a binary schedule.
+ *
+ *  \param path name of the binary schedule
+ *  \param cf pointer to the configuration
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int configSave (char path[], CONFIG *cf);
+
+/**
+ *  \brief Release of a loaded configuration.
+ *
+ *  \param cf pointer to the configuration
+ */
+extern void configFree (CONFIG *cf);
+
+#endif /* CONFIG_H_ */
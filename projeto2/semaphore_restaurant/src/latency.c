@@ -0,0 +1,327 @@
+/**
+ *  \file latency.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Latency instrumentation.
+ *
+ *  Defined operations:
+ *     \li instrumentation data initialization
+ *     \li binding of an entity to the instrumentation data
+ *     \li <em>down</em> of a semaphore, recording the time spent blocked
+ *     \li <em>up</em> of a lock, recording the time it was held
+ *     \li batch of semaphore operations, recording both
+ *     \li recording of the depth of a queue
+ *     \li reading of the totals of an instrumentation point
+ *     \li printing of the latency percentiles of every instrumentation point.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "latency.h"
+#include "semaphore.h"
+#include "replay.h"
+
+/** \brief maximum number of locks held at the same time by an entity */
+#define  LATNEST            4
+
+/** \brief histogram of instrumentation point i */
+#define  LATHIST(l,i)       (SHARRAY(l, (l)->offHist, LAT_HIST) + (i))
+
+/** \brief names of the instrumentation points */
+static const char *pointName[LATPOINTS] = {
+    "wait receptionistRequestPossible", "wait waitForTable", "wait waiterRequestPossible", "wait foodArrived",
+    "wait tableDone", "wait receptionistReq", "wait waiterRequest", "wait waitOrder", "wait orderRequestPossible",
+    "wait groupLock", "wait receptionLock", "wait kitchenLock",
+    "hold checkInAtReception", "hold orderFood", "hold waitFood", "hold checkOutAtReception",
+    "hold waitForClientOrChef", "hold informChef", "hold takeFoodToTable", "hold waitForOrder",
+    "hold processOrder", "hold waitForGroup", "hold provideTableOrWaitingRoom", "hold receivePayment",
+    "depth orderQueue", "depth waiterQueue", "depth readyQueue"
+};
+
+/** \brief instrumentation data the calling entity is bound to (NULL if none) */
+static __thread LAT_SHARED *lat = NULL;
+
+/** \brief locks held by the calling entity */
+static __thread unsigned int heldSem[LATNEST];
+
+/** \brief acquisition time of the locks held by the calling entity (in ns) */
+static __thread unsigned long long heldSince[LATNEST];
+
+/** \brief number of locks held by the calling entity */
+static __thread int nHeld = 0;
+
+/* internal functions */
+
+/** \brief monotonic clock (in ns) */
+static unsigned long long nowNs (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/** \brief bucket of a latency */
+static unsigned int bucketOf (unsigned long long v)
+{
+    unsigned int e, i;
+
+    if (v < 2 * LATSUB) {
+        return (unsigned int) v;
+    }
+    e = 63 - __builtin_clzll (v);                                                     /* 2^e <= v < 2^(e+1) */
+    i = (e - 3) * LATSUB + ((v >> (e - 4)) & (LATSUB - 1));
+    return (i < LATBUCKETS) ? i : LATBUCKETS - 1;
+}
+
+/** \brief largest latency of a bucket */
+static unsigned long long bucketTop (unsigned int i)
+{
+    unsigned int e;
+
+    if (i < 2 * LATSUB) {
+        return i;
+    }
+    e = i / LATSUB + 3;
+    return ((unsigned long long) (LATSUB + i % LATSUB + 1) << (e - 4)) - 1;
+}
+
+/** \brief recording of a latency */
+static void record (unsigned int point, unsigned long long v)
+{
+    LAT_HIST *h = LATHIST(lat, point);
+    unsigned long long m;
+
+    __atomic_fetch_add (&h->bucket[bucketOf (v)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&h->sum, v, __ATOMIC_RELAXED);
+    m = __atomic_load_n (&h->max, __ATOMIC_RELAXED);
+    while ((v > m) && !__atomic_compare_exchange_n (&h->max, &m, v, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) ;
+}
+
+/** \brief recording of the hold time of a lock about to be released (if taken by latDown) */
+static void release (unsigned int sindex, unsigned int point)
+{
+    int i;
+
+    for (i = nHeld - 1; i >= 0; i--) {
+        if (heldSem[i] == sindex) {
+            record (point, nowNs () - heldSince[i]);
+            heldSem[i] = heldSem[nHeld-1];
+            heldSince[i] = heldSince[nHeld-1];
+            nHeld -= 1;
+            break;
+        }
+    }
+}
+
+/** \brief latency of a percentile (q in 0 .. 1) */
+static unsigned long long percentile (LAT_HIST *h, double q)
+{
+    unsigned long long rank, n = 0, top;
+    unsigned int i;
+
+    rank = (unsigned long long) (q * h->count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    for (i = 0; i < LATBUCKETS; i++) {
+        if ((n += h->bucket[i]) >= rank) {
+            break;
+        }
+    }
+    top = bucketTop (i);
+    return (top < h->max) ? top : h->max;
+}
+
+/* external functions */
+
+/**
+ *  \brief Size of the area that holds the histograms.
+ *
+ *  \return size in bytes, multiple of CACHELINE
+ */
+size_t latSize (void)
+{
+    return LATPOINTS * sizeof (LAT_HIST);
+}
+
+/**
+ *  \brief Instrumentation data initialization.
+ *
+ *  Must be called by the generator before any entity is launched. The area must be in the same shared region as
+ *  the instrumentation data.
+ *
+ *  \param l pointer to the instrumentation data
+ *  \param area pointer to a location with latSize() bytes
+ */
+void latInit (LAT_SHARED *l, void *area)
+{
+    l->offHist = (char *) area - (char *) l;
+    memset (area, 0, latSize ());
+}
+
+/**
+ *  \brief Binding of the calling entity to the instrumentation data.
+ *
+ *  \param l pointer to the instrumentation data
+ */
+void latAttach (LAT_SHARED *l)
+{
+    lat = l;
+    nHeld = 0;
+}
+
+/**
+ *  \brief <em>Down</em> of a semaphore, recording the time spent on it.
+ *
+ *  If the point is a lock point (LAT_GROUPLOCK, LAT_RECEPTIONLOCK or LAT_KITCHENLOCK), the time the lock is
+ *  acquired is kept until the matching <tt>latUp</tt>.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sindex semaphore index
+ *  \param point instrumentation point
+ *
+ *  \return as <tt>semDown</tt>
+ */
+int latDown (int semgid, unsigned int sindex, unsigned int point)
+{
+    unsigned long long t0, t1;
+    int stat;
+
+    if (lat == NULL) {
+        return replayDown (semgid, sindex);
+    }
+    t0 = nowNs ();
+    if ((stat = replayDown (semgid, sindex)) == -1) {
+        return -1;
+    }
+    t1 = nowNs ();
+    record (point, t1 - t0);
+    if ((point >= LAT_GROUPLOCK) && (point <= LAT_KITCHENLOCK) && (nHeld < LATNEST)) {
+        heldSem[nHeld] = sindex;
+        heldSince[nHeld++] = t1;
+    }
+    return stat;
+}
+
+/**
+ *  \brief <em>Up</em> of a lock, recording the time it was held since the matching <tt>latDown</tt>.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sindex semaphore index
+ *  \param point instrumentation point the hold time is recorded at
+ *
+ *  \return as <tt>semUp</tt>
+ */
+int latUp (int semgid, unsigned int sindex, unsigned int point)
+{
+    if (lat != NULL) {
+        release (sindex, point);
+    }
+    return semUp (semgid, sindex);
+}
+
+/**
+ *  \brief Batch of semaphore operations (see semOps), recording the time held of the locks it releases and the
+ *  time spent on it.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param ops operations
+ *  \param n number of operations
+ *  \param holdPoint instrumentation point the hold times are recorded at
+ *  \param waitPoint instrumentation point the time spent is recorded at (LAT_NONE if not to be recorded)
+ *
+ *  \return as <tt>semOps</tt>
+ */
+int latOps (int semgid, SEM_OP ops[], unsigned int n, unsigned int holdPoint, unsigned int waitPoint)
+{
+    unsigned long long t0;
+    unsigned int i;
+    int stat;
+
+    if (lat == NULL) {
+        return replayOps (semgid, ops, n);
+    }
+    for (i = 0; i < n; i++) {
+        if (ops[i].op > 0) {
+            release (ops[i].sindex, holdPoint);
+        }
+    }
+    t0 = nowNs ();
+    if (((stat = replayOps (semgid, ops, n)) != -1) && (waitPoint != LAT_NONE)) {
+        record (waitPoint, nowNs () - t0);
+    }
+    return stat;
+}
+
+/**
+ *  \brief Recording of the depth of a queue, at a queue depth point (LAT_DEPTHPOINTS and on).
+ *
+ *  Sampled by every insertion, its distribution is the one seen by the requests arriving at the queue.
+ *
+ *  \param point queue depth point
+ *  \param depth number of requests in the queue
+ */
+void latDepth (unsigned int point, unsigned int depth)
+{
+    if (lat != NULL) {
+        record (point, depth);
+    }
+}
+
+/**
+ *  \brief Reading of the totals of an instrumentation point, while the entities record.
+ *
+ *  \param l pointer to the instrumentation data
+ *  \param point instrumentation point
+ *  \param sum pointer to the location where the sum of the recorded latencies (in ns) or depths is stored
+ *
+ *  \return number of recorded latencies or depths
+ */
+unsigned long long latTotal (LAT_SHARED *l, unsigned int point, unsigned long long *sum)
+{
+    LAT_HIST *h = LATHIST(l, point);
+
+    *sum = __atomic_load_n (&h->sum, __ATOMIC_RELAXED);
+    return __atomic_load_n (&h->count, __ATOMIC_RELAXED);
+}
+
+/**
+ *  \brief Printing of count, mean, median, 99th percentile and maximum of every instrumentation point used.
+ *
+ *  The queue depth points are printed in a second table, without the count.
+ *
+ *  \param fp output stream
+ *  \param l pointer to the instrumentation data
+ */
+void latReport (FILE *fp, LAT_SHARED *l)
+{
+    LAT_HIST *h;
+    unsigned int p;
+
+    fprintf (fp, "%-36s %10s %12s %12s %12s %12s\n", "latency (us)", "count", "mean", "p50", "p99", "max");
+    for (p = 0; p < LAT_DEPTHPOINTS; p++) {
+        h = LATHIST(l, p);
+        if (h->count == 0) {
+            continue;
+        }
+        fprintf (fp, "%-36s %10llu %12.1f %12.1f %12.1f %12.1f\n", pointName[p], h->count,
+                 (double) h->sum / h->count / 1000.0, percentile (h, 0.5) / 1000.0, percentile (h, 0.99) / 1000.0,
+                 h->max / 1000.0);
+    }
+    fprintf (fp, "%-36s %10s %12s %12s %12s %12s\n", "queue depth (requests)", "", "mean", "p50", "p99", "max");
+    for (p = LAT_DEPTHPOINTS; p < LATPOINTS; p++) {
+        h = LATHIST(l, p);
+        if (h->count == 0) {
+            continue;
+        }
+        fprintf (fp, "%-36s %10s %12.2f %12llu %12llu %12llu\n", pointName[p], "", (double) h->sum / h->count,
+                 percentile (h, 0.5), percentile (h, 0.99), h->max);
+    }
+}
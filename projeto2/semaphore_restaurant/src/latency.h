@@ -0,0 +1,128 @@
+/**
+ *  \file latency.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Latency instrumentation.
+ *
+ *  Defined operations:
+ *     \li instrumentation data initialization
+ *     \li binding of an entity to the instrumentation data
+ *     \li <em>down</em> of a semaphore, recording the time spent blocked
+ *     \li <em>up</em> of a lock, recording the time it was held
+ *     \li batch of semaphore operations, recording both
+ *     \li recording of the depth of a queue
+ *     \li reading of the totals of an instrumentation point
+ *     \li printing of the latency percentiles of every instrumentation point.
+ *
+ *  Latencies are measured with the monotonic clock and added to a histogram with log buckets (about 6% relative
+ *  error) of each instrumentation point (see LATPOINTS), kept in shared memory and updated with atomic
+ *  operations, so that no lock is taken. The semaphore operations are recorded or replayed by the replay engine
+ *  (see replay.h).
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "probDataStruct.h"
+#include "semaphore.h"
+
+/**
+ *  \brief Size of the area that holds the histograms.
+ *
+ *  \return size in bytes, multiple of CACHELINE
+ */
+extern size_t latSize (void);
+
+/**
+ *  \brief Instrumentation data initialization.
+ *
+ *  Must be called by the generator before any entity is launched. The area must be in the same shared region as
+ *  the instrumentation data.
+ *
+ *  \param l pointer to the instrumentation data
+ *  \param area pointer to a location with latSize() bytes
+ */
+extern void latInit (LAT_SHARED *l, void *area);
+
+/**
+ *  \brief Binding of the calling entity to the instrumentation data.
+ *
+ *  \param l pointer to the instrumentation data
+ */
+extern void latAttach (LAT_SHARED *l);
+
+/**
+ *  \brief <em>Down</em> of a semaphore, recording the time spent on it.
+ *
+ *  If the point is a lock point (LAT_GROUPLOCK, LAT_RECEPTIONLOCK or LAT_KITCHENLOCK), the time the lock is
+ *  acquired is kept until the matching <tt>latUp</tt>.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sindex semaphore index
+ *  \param point instrumentation point
+ *
+ *  \return as <tt>semDown</tt>
+ */
+extern int latDown (int semgid, unsigned int sindex, unsigned int point);
+
+/**
+ *  \brief <em>Up</em> of a lock, recording the time it was held since the matching <tt>latDown</tt>.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sindex semaphore index
+ *  \param point instrumentation point the hold time is recorded at
+ *
+ *  \return as <tt>semUp</tt>
+ */
+extern int latUp (int semgid, unsigned int sindex, unsigned int point);
+
+/**
+ *  \brief Batch of semaphore operations (see semOps), recording the time held of the locks it releases and the
+ *  time spent on it.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param ops operations
+ *  \param n number of operations
+ *  \param holdPoint instrumentation point the hold times are recorded at
+ *  \param waitPoint instrumentation point the time spent is recorded at (LAT_NONE if not to be recorded)
+ *
+ *  \return as <tt>semOps</tt>
+ */
+extern int latOps (int semgid, SEM_OP ops[], unsigned int n, unsigned int holdPoint, unsigned int waitPoint);
+
+/**
+ *  \brief Recording of the depth of a queue, at a queue depth point (LAT_DEPTHPOINTS and on).
+ *
+ *  Sampled by every insertion, its distribution is the one seen by the requests arriving at the queue.
+ *
+ *  \param point queue depth point
+ *  \param depth number of requests in the queue
+ */
+extern void latDepth (unsigned int point, unsigned int depth);
+
+/**
+ *  \brief Reading of the totals of an instrumentation point, while the entities record.
+ *
+ *  \param l pointer to the instrumentation data
+ *  \param point instrumentation point
+ *  \param sum pointer to the location where the sum of the recorded latencies (in ns) or depths is stored
+ *
+ *  \return number of recorded latencies or depths
+ */
+extern unsigned long long latTotal (LAT_SHARED *l, unsigned int point, unsigned long long *sum);
+
+/**
+ *  \brief Printing of count, mean, median, 99th percentile and maximum of every instrumentation point used.
+ *
+ *  The queue depth points are printed in a second table, without the count.
+ *
+ *  \param fp output stream
+ *  \param l pointer to the instrumentation data
+ */
+extern void latReport (FILE *fp, LAT_SHARED *l);
+
+#endif /* LATENCY_H_ */
@@ -0,0 +1,225 @@
+/**
+ *  \file launcher.c (implementation file)
+ *
+ *  \brief Launching of the intervening entities.
+ *
+ *  Operations defined on entities:
+ *     \li launching of an entity program
+ *     \li launching of a helper task
+ *     \li waiting for the termination of any entity
+ *     \li checking for the termination of any entity, without waiting
+ *     \li waiting for the termination of a helper task
+ *     \li forced termination of every entity and helper task.
+ *
+ *  Implementation with processes: entities are generated by fork and execv, helper tasks by fork.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "launcher.h"
+
+/** \brief maximum number of helper tasks not yet waited for */
+#define  MAXTASKS       8
+
+/** \brief process identifiers of the helper tasks */
+static int tasks[MAXTASKS];
+
+/** \brief helper tasks already waited for by waitEntity */
+static int reaped[MAXTASKS];
+
+/** \brief number of launched helper tasks */
+static int nTasks = 0;
+
+/** \brief process identifiers of the launched entities (0 once waited for) */
+static int *entities = NULL;
+
+/** \brief number of launched entities */
+static int nEntities = 0;
+
+/* internal functions */
+
+static int taskIndex (int pid)
+{
+  int t;
+
+  for (t = 0; t < nTasks; t++)
+    if (tasks[t] == pid)
+       return t;
+  return -1;
+}
+
+/** \brief bookkeeping of the termination of process pid: returns 1 if it is an entity, 0 if it is a helper task */
+static int reap (int pid)
+{
+  int t, e;
+
+  if ((t = taskIndex (pid)) != -1)
+     { reaped[t] = 1;
+       return 0;
+     }
+  for (e = 0; e < nEntities; e++)
+    if (entities[e] == pid)
+       { entities[e] = 0;
+         break;
+       }
+  return 1;
+}
+
+/* external functions */
+
+/**
+ *  \brief Launching of an entity program.
+ *
+ *  \param path path name of the entity program
+ *  \param argv argument list (argv[0] included), terminated by a null pointer; it is copied
+ *
+ *  \return entity identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int launchEntity (char *path, char *argv[])
+{
+  int *grown;
+  int pid;
+
+  if ((grown = realloc (entities, (nEntities + 1) * sizeof (int))) == NULL)
+     return -1;
+  entities = grown;
+  if ((pid = fork ()) != 0)
+     { if (pid != -1)
+          entities[nEntities++] = pid;
+       return pid;
+     }
+  execv (path, argv);
+  perror ("error on the generation of the entity process");
+  exit (EXIT_FAILURE);
+}
+
+/**
+ *  \brief Launching of a helper task.
+ *
+ *  The task runs concurrently with the caller until the function returns. Helper tasks are not entities: they
+ *  are only waited for by <tt>waitTask</tt>.
+ *
+ *  \param task function to be run
+ *  \param arg argument of the function
+ *
+ *  \return task identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int launchTask (void (*task) (void *), void *arg)
+{
+  int pid;
+
+  if (nTasks == MAXTASKS)
+     { errno = EAGAIN;
+       return -1;
+     }
+  if ((pid = fork ()) != 0)
+     { if (pid != -1)
+          { tasks[nTasks] = pid;
+            reaped[nTasks++] = 0;
+          }
+       return pid;
+     }
+  task (arg);
+  exit (EXIT_SUCCESS);
+}
+
+/**
+ *  \brief Waiting for the termination of any launched entity.
+ *
+ *  Helper tasks that terminate meanwhile are not reported: their termination is kept for <tt>waitTask</tt>.
+ *
+ *  \param status pointer to the location where the termination status is stored (as by <tt>wait</tt>)
+ *
+ *  \return identifier of the terminated entity, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int waitEntity (int *status)
+{
+  int pid;
+
+  while (((pid = wait (status)) != -1) && !reap (pid)) ;
+  return pid;
+}
+
+/**
+ *  \brief Checking for the termination of any launched entity, without waiting.
+ *
+ *  Helper tasks that terminate meanwhile are not reported: their termination is kept for <tt>waitTask</tt>.
+ *
+ *  \param status pointer to the location where the termination status is stored (as by <tt>wait</tt>)
+ *
+ *  \return identifier of the terminated entity, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>; EAGAIN if no entity
+ *          terminated)
+ */
+
+int pollEntity (int *status)
+{
+  int pid;
+
+  while (((pid = waitpid (-1, status, WNOHANG)) > 0) && !reap (pid)) ;
+  if (pid == 0)
+     { errno = EAGAIN;
+       return -1;
+     }
+  return pid;
+}
+
+/**
+ *  \brief Waiting for the termination of a helper task.
+ *
+ *  \param id task identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int waitTask (int id)
+{
+  int status, t;
+
+  if ((t = taskIndex (id)) == -1)
+     { errno = EINVAL;
+       return -1;
+     }
+  if (!reaped[t] && (waitpid (id, &status, 0) == -1))
+     return -1;
+  tasks[t] = tasks[nTasks-1];                                                  /* the slot may be taken again */
+  reaped[t] = reaped[nTasks-1];
+  nTasks -= 1;
+  return 0;
+}
+
+/**
+ *  \brief Forced termination of every launched entity and helper task not yet waited for.
+ *
+ *  Meant to be called when the simulation is aborted; the terminated entities and tasks are waited for.
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if entities cannot be terminated before the calling process exits (<tt>errno</tt> is ENOTSUP)
+ */
+
+int killEntities (void)
+{
+  int e, t;
+
+  for (e = 0; e < nEntities; e++)
+    if ((entities[e] != 0) && (kill (entities[e], SIGKILL) == 0))
+       waitpid (entities[e], NULL, 0);
+  for (t = 0; t < nTasks; t++)
+    if (!reaped[t] && (kill (tasks[t], SIGKILL) == 0))
+       waitpid (tasks[t], NULL, 0);
+  nEntities = nTasks = 0;
+  return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ *  \file launcher.h (interface file)
+ *
+ *  \brief Launching of the intervening entities.
+ *
+ *  Operations defined on entities:
+ *     \li launching of an entity program
+ *     \li launching of a helper task
+ *     \li waiting for the termination of any entity
+ *     \li checking for the termination of any entity, without waiting
+ *     \li waiting for the termination of a helper task
+ *     \li forced termination of every entity and helper task.
+ *
+ *  Two implementations are available, selected at build time:
+ *     \li launcher.c - each entity is a process, generated by fork and execv
+ *     \li launcherThread.c - each entity is a thread of the calling process, running the main function of the
+ *         entity program linked into the same binary.
+ */
+
+#ifndef LAUNCHER_H_
+#define LAUNCHER_H_
+
+/**
+ *  \brief Launching of an entity program.
+ *
+ *  \param path path name of the entity program
+ *  \param argv argument list (argv[0] included), terminated by a null pointer; it is copied
+ *
+ *  \return entity identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int launchEntity (char *path, char *argv[]);
+
+/**
+ *  \brief Launching of a helper task.
+ *
+ *  The task runs concurrently with the caller until the function returns. Helper tasks are not entities: they
+ *  are only waited for by <tt>waitTask</tt>.
+ *
+ *  \param task function to be run
+ *  \param arg argument of the function
+ *
+ *  \return task identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int launchTask (void (*task) (void *), void *arg);
+
+/**
+ *  \brief Waiting for the termination of any launched entity.
+ *
+ *  \param status pointer to the location where the termination status is stored (as by <tt>wait</tt>)
+ *
+ *  \return identifier of the terminated entity, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int waitEntity (int *status);
+
+/**
+ *  \brief Checking for the termination of any launched entity, without waiting.
+ *
+ *  \param status pointer to the location where the termination status is stored (as by <tt>wait</tt>)
+ *
+ *  \return identifier of the terminated entity, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>; EAGAIN if no entity
+ *          terminated)
+ */
+
+extern int pollEntity (int *status);
+
+/**
+ *  \brief Waiting for the termination of a helper task.
+ *
+ *  \param id task identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int waitTask (int id);
+
+/**
+ *  \brief Forced termination of every launched entity and helper task not yet waited for.
+ *
+ *  Meant to be called when the simulation is aborted; the terminated entities and tasks are waited for.
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if entities cannot be terminated before the calling process exits (<tt>errno</tt> is ENOTSUP)
+ */
+
+extern int killEntities (void);
+
+#endif /* LAUNCHER_H_ */
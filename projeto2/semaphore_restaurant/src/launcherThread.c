@@ -0,0 +1,272 @@
+/**
+ *  \file launcherThread.c (implementation file)
+ *
+ *  \brief Launching of the intervening entities.
+ *
+ *  Operations defined on entities:
+ *     \li launching of an entity program
+ *     \li launching of a helper task
+ *     \li waiting for the termination of any entity
+ *     \li checking for the termination of any entity, without waiting
+ *     \li waiting for the termination of a helper task
+ *     \li forced termination of every entity and helper task.
+ *
+ *  Implementation with threads: the entity programs are linked into the calling binary, with their main function
+ *  renamed after the source file (see the <tt>threads</tt> target of the Makefile), and each entity or helper task
+ *  runs in a thread of its own. Entities are waited for in launching order. Threads cannot be terminated one by
+ *  one: they all end with the process.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "launcher.h"
+
+/* main functions of the entity programs */
+extern int semSharedMemGroupMain (int argc, char *argv[]);
+extern int semSharedMemWaiterMain (int argc, char *argv[]);
+extern int semSharedMemChefMain (int argc, char *argv[]);
+extern int semSharedMemReceptionistMain (int argc, char *argv[]);
+
+/**
+ *  \brief Definition of an entity program linked into the binary.
+ */
+typedef struct {
+    /** \brief path name the program is launched by */
+    char *path;
+    /** \brief main function of the program */
+    int (*main) (int, char *[]);
+} PROGRAM;
+
+/** \brief entity programs */
+static PROGRAM programs[] = {
+    { "./group",        semSharedMemGroupMain },
+    { "./waiter",       semSharedMemWaiterMain },
+    { "./chef",         semSharedMemChefMain },
+    { "./receptionist", semSharedMemReceptionistMain },
+};
+
+/**
+ *  \brief Definition of a launched thread.
+ */
+typedef struct {
+    /** \brief thread handle */
+    pthread_t thread;
+    /** \brief main function, if the thread runs an entity program */
+    int (*main) (int, char *[]);
+    /** \brief argument count (entity) */
+    int argc;
+    /** \brief copy of the argument list (entity) */
+    char **argv;
+    /** \brief function to be run (helper task) */
+    void (*task) (void *);
+    /** \brief argument of the function (helper task) */
+    void *arg;
+    /** \brief termination status (entity) */
+    int status;
+    /** \brief the thread terminated */
+    bool done;
+    /** \brief the entity was already waited for */
+    bool waited;
+} LAUNCHED;
+
+/** \brief launched threads */
+static LAUNCHED **launched = NULL;
+
+/** \brief number of launched threads */
+static int nLaunched = 0;
+
+/** \brief next launched thread to be checked by waitEntity */
+static int nextWait = 0;
+
+/* internal functions */
+
+static void *run (void *p)
+{
+  LAUNCHED *l = p;
+
+  if (l->main != NULL)
+     l->status = (l->main (l->argc, l->argv) & 0xff) << 8;              /* same encoding as wait for a normal exit */
+     else l->task (l->arg);
+  __atomic_store_n (&l->done, true, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+static int join (int id, int *status)
+{
+  LAUNCHED *l = launched[id];
+  int i, err;
+
+  if ((err = pthread_join (l->thread, NULL)) != 0)
+     { errno = err;
+       return -1;
+     }
+  *status = l->status;
+  l->waited = true;
+  for (i = 0; i < l->argc; i++)
+    free (l->argv[i]);
+  free (l->argv);
+  return id;
+}
+
+static int launch (LAUNCHED *l)
+{
+  LAUNCHED **grown;
+  int err;
+
+  if ((grown = realloc (launched, (nLaunched + 1) * sizeof (LAUNCHED *))) == NULL)
+     return -1;
+  launched = grown;
+  if ((err = pthread_create (&l->thread, NULL, run, l)) != 0)
+     { errno = err;
+       return -1;
+     }
+  launched[nLaunched] = l;
+  return nLaunched++;
+}
+
+/* external functions */
+
+/**
+ *  \brief Launching of an entity program.
+ *
+ *  \param path path name of the entity program
+ *  \param argv argument list (argv[0] included), terminated by a null pointer; it is copied
+ *
+ *  \return entity identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int launchEntity (char *path, char *argv[])
+{
+  LAUNCHED *l;
+  unsigned int p;
+  int i;
+
+  for (p = 0; p < sizeof (programs) / sizeof (programs[0]); p++)
+    if (strcmp (programs[p].path, path) == 0)
+       break;
+  if (p == sizeof (programs) / sizeof (programs[0]))
+     { errno = ENOENT;
+       return -1;
+     }
+  if ((l = calloc (1, sizeof (LAUNCHED))) == NULL)
+     return -1;
+  l->main = programs[p].main;
+  for (l->argc = 0; argv[l->argc] != NULL; l->argc++) ;
+  if ((l->argv = calloc (l->argc + 1, sizeof (char *))) == NULL)
+     return -1;
+  for (i = 0; i < l->argc; i++)
+    if ((l->argv[i] = strdup (argv[i])) == NULL)
+       return -1;
+  return launch (l);
+}
+
+/**
+ *  \brief Launching of a helper task.
+ *
+ *  The task runs concurrently with the caller until the function returns. Helper tasks are not entities: they
+ *  are only waited for by <tt>waitTask</tt>.
+ *
+ *  \param task function to be run
+ *  \param arg argument of the function
+ *
+ *  \return task identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int launchTask (void (*task) (void *), void *arg)
+{
+  LAUNCHED *l;
+
+  if ((l = calloc (1, sizeof (LAUNCHED))) == NULL)
+     return -1;
+  l->task = task;
+  l->arg = arg;
+  return launch (l);
+}
+
+/**
+ *  \brief Waiting for the termination of any launched entity.
+ *
+ *  \param status pointer to the location where the termination status is stored (as by <tt>wait</tt>)
+ *
+ *  \return identifier of the terminated entity, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int waitEntity (int *status)
+{
+  while ((nextWait < nLaunched) && ((launched[nextWait]->main == NULL) || launched[nextWait]->waited))
+    nextWait += 1;
+  if (nextWait == nLaunched)
+     { errno = ECHILD;
+       return -1;
+     }
+  return join (nextWait++, status);
+}
+
+/**
+ *  \brief Checking for the termination of any launched entity, without waiting.
+ *
+ *  \param status pointer to the location where the termination status is stored (as by <tt>wait</tt>)
+ *
+ *  \return identifier of the terminated entity, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>; EAGAIN if no entity
+ *          terminated)
+ */
+
+int pollEntity (int *status)
+{
+  int id;
+
+  for (id = nextWait; id < nLaunched; id++)
+    if ((launched[id]->main != NULL) && !launched[id]->waited &&
+        __atomic_load_n (&launched[id]->done, __ATOMIC_ACQUIRE))
+       return join (id, status);
+  errno = (nextWait == nLaunched) ? ECHILD : EAGAIN;
+  return -1;
+}
+
+/**
+ *  \brief Waiting for the termination of a helper task.
+ *
+ *  \param id task identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int waitTask (int id)
+{
+  int err;
+
+  if ((id < 0) || (id >= nLaunched) || (launched[id]->main != NULL))
+     { errno = EINVAL;
+       return -1;
+     }
+  if ((err = pthread_join (launched[id]->thread, NULL)) != 0)
+     { errno = err;
+       return -1;
+     }
+  return 0;
+}
+
+/**
+ *  \brief Forced termination of every launched entity and helper task not yet waited for.
+ *
+ *  Threads cannot be terminated one by one: they end with the process, which is about to exit when the simulation
+ *  is aborted.
+ *
+ *  \return -\c 1, as entities cannot be terminated before the calling process exits (<tt>errno</tt> is ENOTSUP)
+ */
+
+int killEntities (void)
+{
+  errno = ENOTSUP;
+  return -1;
+}
@@ -0,0 +1,55 @@
+/**
+ *  \file liveStats.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Live counters of the simulation.
+ *
+ *  Defined operations:
+ *     \li counters initialization
+ *     \li update of a counter
+ *     \li reading of a counter.
+ */
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "liveStats.h"
+
+/**
+ *  \brief Counters initialization: every counter is zero.
+ *
+ *  \param s pointer to the counters
+ */
+void liveInit (LIVE_STATS *s)
+{
+    unsigned int c;
+
+    for (c = 0; c < LIVECOUNTERS; c++) {
+        __atomic_store_n (&s->counter[c].val, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ *  \brief Update of a counter.
+ *
+ *  \param s pointer to the counters
+ *  \param c counter id
+ *  \param n amount added to the counter (negative to decrease it)
+ */
+void liveAdd (LIVE_STATS *s, unsigned int c, long long n)
+{
+    __atomic_fetch_add (&s->counter[c].val, n, __ATOMIC_RELAXED);
+}
+
+/**
+ *  \brief Reading of a counter.
+ *
+ *  \param s pointer to the counters
+ *  \param c counter id
+ *
+ *  \return value of the counter
+ */
+long long liveRead (LIVE_STATS *s, unsigned int c)
+{
+    return __atomic_load_n (&s->counter[c].val, __ATOMIC_RELAXED);
+}
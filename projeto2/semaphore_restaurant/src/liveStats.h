@@ -0,0 +1,49 @@
+/**
+ *  \file liveStats.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Live counters of the simulation.
+ *
+ *  Defined operations:
+ *     \li counters initialization
+ *     \li update of a counter
+ *     \li reading of a counter.
+ *
+ *  The counters (see LIVECOUNTERS) are kept in shared memory, each on a cache line of its own, and updated with
+ *  atomic operations, so that no lock is taken and they can be sampled at any time, by the monitor among others,
+ *  without stopping the entities. They do not depend on logging.
+ */
+
+#ifndef LIVESTATS_H_
+#define LIVESTATS_H_
+
+#include "probDataStruct.h"
+
+/**
+ *  \brief Counters initialization: every counter is zero.
+ *
+ *  \param s pointer to the counters
+ */
+extern void liveInit (LIVE_STATS *s);
+
+/**
+ *  \brief Update of a counter.
+ *
+ *  \param s pointer to the counters
+ *  \param c counter id
+ *  \param n amount added to the counter (negative to decrease it)
+ */
+extern void liveAdd (LIVE_STATS *s, unsigned int c, long long n);
+
+/**
+ *  \brief Reading of a counter.
+ *
+ *  \param s pointer to the counters
+ *  \param c counter id
+ *
+ *  \return value of the counter
+ */
+extern long long liveRead (LIVE_STATS *s, unsigned int c);
+
+#endif /* LIVESTATS_H_ */
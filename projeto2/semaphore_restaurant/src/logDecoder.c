@@ -0,0 +1,226 @@
+/**
+ *  \file logDecoder.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  Offline decoder of the binary trace of the internal state.
+ *
+ *  Rebuilds the text log, with the same layout written by <tt>saveState</tt>, from a binary trace
+ *  produced by <tt>probSemSharedMemRestaurant -t</tt>.
+ *
+ *  Upon execution, one parameter is accepted:
+ *    \li name of the binary trace file (stdin if missing).
+ *
+ *  Options:
+ *    \li -f unchanged columns of entity states are replaced by "." (as done by filter_log.awk)
+ *    \li -v each row is prefixed by the record time (in us) and the entity that saved the state.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "logging.h"
+
+/** \brief maximum length of a text log line of n groups */
+#define  LINEMAX(n)   (16 + 8*(n))
+
+/** \brief maximum number of columns of a text log line of n groups */
+#define  COLMAX(n)    (4 + 2*(n))
+
+/** \brief maximum length of a column of a text log line */
+#define  TOKMAX       16
+
+/** \brief replace unchanged columns by "." */
+static bool filter = false;
+
+/** \brief previous value of each column (filter mode) */
+static char (*prev)[TOKMAX];
+
+/**
+ *  \brief Writing a text log line, applying the dotted compression if requested.
+ *
+ *  Lines with the number of columns of a state row (header row included) are compressed: columns of
+ *  the chef, waiter, receptionist and groups that did not change are shown as "."; the other lines
+ *  are written as they are.
+ *
+ *  \param line text line (without new line)
+ *  \param nGroups number of groups
+ */
+static void writeLine (char *line, int nGroups)
+{
+    char copy[LINEMAX(nGroups)];
+    char *col[COLMAX(nGroups)+1];
+    int size[COLMAX(nGroups)];
+    int nCol = 0, i;
+    char *tok;
+
+    if (!filter) {
+        puts (line);
+        return;
+    }
+
+    strncpy (copy, line, LINEMAX(nGroups)-1);
+    copy[LINEMAX(nGroups)-1] = '\0';
+    for (tok = strtok (copy, " "); (tok != NULL) && (nCol <= COLMAX(nGroups)); tok = strtok (NULL, " ")) {
+        col[nCol++] = tok;
+    }
+    if (nCol != 2*nGroups + 4) {
+        puts (line);
+        return;
+    }
+
+    size[0] = 3;
+    size[1] = size[2] = 2;
+    for (i = 0; i < nGroups; i++) {
+        size[3+i] = 3;
+        size[4+nGroups+i] = 3;
+    }
+    size[3+nGroups] = 4;
+
+    for (i = 0; i < nCol; i++) {
+        if (i < nGroups + 3) {
+            printf ("%*s ", size[i], (strcmp (col[i], prev[i]) == 0) ? "." : col[i]);
+            strncpy (prev[i], col[i], TOKMAX-1);
+        }
+        else printf ("%*s ", size[i], col[i]);
+    }
+    printf ("\n");
+}
+
+/**
+ *  \brief Writing text produced by one of the log formatting functions, line by line.
+ */
+static void writeText (char *text, int nGroups)
+{
+    char *nl;
+
+    while ((nl = strchr (text, '\n')) != NULL) {
+        *nl = '\0';
+        writeLine (text, nGroups);
+        text = nl + 1;
+    }
+}
+
+/** \brief short name of entity that saved a state */
+static void entityName (unsigned int entity, char name[])
+{
+    switch (ENTITYKIND(entity)) {
+        case ENT_GROUP:        sprintf (name, "G%02u", ENTITYIDX(entity)); break;
+        case ENT_WAITER:       sprintf (name, "W%02u", ENTITYIDX(entity)); break;
+        case ENT_CHEF:         sprintf (name, "C%02u", ENTITYIDX(entity)); break;
+        case ENT_RECEPTIONIST: strcpy (name, "RC"); break;
+        default:               strcpy (name, "--"); break;
+    }
+}
+
+/**
+ *  \brief Main program.
+ *
+ *  Reads the trace header and then every record, applying the changed fields to a local copy of the
+ *  full state and writing it as a text line.
+ */
+int main (int argc, char *argv[])
+{
+    FILE *fic = stdin;                                                                      /* binary trace stream */
+    bool verbose = false;
+    int opt;
+    TRACE_HEADER hd;
+    TRACE_RECORD rec;
+    TRACE_CHANGE chg;
+    FULL_STAT *fSt;
+    char *text;
+    char name[8];
+    FILE *mem;
+    unsigned int c;
+    int n;
+
+    while ((opt = getopt (argc, argv, "fv")) != -1) {
+        switch (opt) {
+            case 'f':
+                filter = true;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            default:
+                fprintf (stderr, "USAGE: %s [-f] [-v] [tracefile]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind == argc-1) {
+        if ((fic = fopen (argv[optind], "r")) == NULL) {
+            perror ("error on opening trace file");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ((fread (&hd, sizeof (hd), 1, fic) != 1) || (memcmp (hd.magic, TRACEMAGIC, sizeof (hd.magic)) != 0)) {
+        fprintf (stderr, "Not a binary trace file!\n");
+        return EXIT_FAILURE;
+    }
+    if ((hd.version != TRACEVERSION) || (hd.nGroups < 1) || (hd.nGroups > MAXGROUPS)) {
+        fprintf (stderr, "Unsupported trace (version %u, %u groups)!\n", hd.version, hd.nGroups);
+        return EXIT_FAILURE;
+    }
+
+    n = hd.nGroups;
+    if (((fSt = aligned_alloc (CACHELINE, logSnapshotSize (n))) == NULL) || ((text = malloc (4*LINEMAX(n))) == NULL) ||
+        ((prev = calloc (COLMAX(n), TOKMAX)) == NULL)) {
+        perror ("error on allocating the decoder state");
+        return EXIT_FAILURE;
+    }
+    logSnapshotInit (fSt, n);
+
+    if ((mem = fmemopen (text, 4*LINEMAX(n), "w")) == NULL) {
+        perror ("error on opening memory stream");
+        return EXIT_FAILURE;
+    }
+    printLogHeader (mem, fSt);
+    fputc ('\0', mem);
+    fflush (mem);
+    writeText (text, n);
+
+    while (fread (&rec, sizeof (rec), 1, fic) == 1) {
+        for (c = 0; c < rec.nChanges; c++) {
+            if (fread (&chg, sizeof (chg), 1, fic) != 1) {
+                fprintf (stderr, "Truncated trace record!\n");
+                return EXIT_FAILURE;
+            }
+            if (chg.field == TF_CHEF) fSt->st.chefStat = chg.value;
+            else if (chg.field == TF_WAITER) fSt->st.waiterStat = chg.value;
+            else if (chg.field == TF_RECEPTIONIST) fSt->st.receptionistStat = chg.value;
+            else if (chg.field == TF_GWAITING) fSt->groupsWaiting = chg.value;
+            else if (chg.field < TF_TABLE(n,0)) GROUPSTAT(fSt,chg.field - TF_GROUP(0)) = chg.value;
+            else if (chg.field < TF_TABLE(n,n)) ASSIGNEDTABLE(fSt)[chg.field - TF_TABLE(n,0)] = chg.value;
+            else {
+                fprintf (stderr, "Invalid field %u in trace record!\n", chg.field);
+                return EXIT_FAILURE;
+            }
+        }
+
+        rewind (mem);
+        printLogState (mem, fSt);
+        fputc ('\0', mem);
+        fflush (mem);
+        if (verbose) {
+            entityName (rec.entity, name);
+            printf ("%10u %-4s", rec.time, name);
+        }
+        writeText (text, n);
+    }
+
+    fclose (mem);
+    free (prev);
+    free (text);
+    free (fSt);
+    if (fic != stdin) {
+        fclose (fic);
+    }
+
+    return EXIT_SUCCESS;
+}
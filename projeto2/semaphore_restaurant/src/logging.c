@@ -7,7 +7,16 @@
  *
  *  Defined operations:
  *     \li file initialization
- *     \li writing the present full state as a single line at the end of the file.
+ *     \li writing the present full state as a single line at the end of the file
+ *     \li buffered logging through a shared ring of snapshots emptied by a drainer
+ *     \li binary tracing of the fields changed by each state transition
+ *     \li memory mapped logging: records are formatted in place, in a preallocated log file
+ *     \li delta logging: only the entity states changed since the previous line are written
+ *     \li sequence counters that allow saveState to take consistent snapshots without a global lock
+ *     \li summary of the states saved in a run.
+ *
+ *  The functions replaced by macros at the chosen logging level (see logging.h) are defined with their names in
+ *  parentheses, so that the library provides all of them at any level.
  *
  *  \author Nuno Lau - December 2023
  */
@@ -16,13 +25,57 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+#include <errno.h>
 
 #include <sys/types.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
 
 
 #include "probConst.h"
 #include "probDataStruct.h"
+#include "logging.h"
+#include "semaphore.h"
+#include "replay.h"
+
+/** \brief shared logging control data the calling process is bound to (NULL if none) */
+static LOG_SHARED *logSh = NULL;
+
+/** \brief id of the calling entity (entities may be threads of the same process) */
+static __thread unsigned int logEntity = ENTITYID(ENT_GENERATOR, 0);
+
+/** \brief binary trace file descriptor of the calling process (-1 if not open) */
+static __thread int traceFd = -1;
+
+/** \brief binary trace record being built by the calling process */
+static __thread unsigned char *traceRec = NULL;
+
+/** \brief snapshot of the state taken by the calling process */
+static __thread FULL_STAT *snap = NULL;
+
+/** \brief memory mapped log file descriptor of the calling process (-1 if not open) */
+static __thread int mapFd = -1;
+
+/** \brief mapping of the log file in the calling process (NULL if not mapped) */
+static __thread char *mapBase = NULL;
+
+/** \brief length of the mapping of the log file */
+static __thread size_t mapLen = 0;
+
+/** \brief text row being formatted by the calling process, and the stream that writes on it */
+static __thread char *rowBuf = NULL;
+static __thread FILE *rowFic = NULL;
+
+/** \brief slot t of the shared log buffer */
+#define  LOGSLOT(p_log,t)   SHARRAY(p_log, (p_log)->buf.offSlot + ((t) % LOGSLOTS) * (p_log)->buf.stride, LOG_SLOT)
+
+/** \brief last traced state */
+#define  TRACELAST(p_log)   SHARRAY(p_log, (p_log)->trace.offLast, FULL_STAT)
 
 /* internal functions */
 
@@ -60,6 +113,32 @@ static void closeLog(FILE *fic)
     }
 }
 
+/** \brief writes an entity state column, as "." if equal to the last one written */
+static void deltaField(FILE *fic, int width, unsigned int *last, unsigned int value)
+{
+    if (*last == value) {
+        fprintf(fic,"%*s",width,".");
+    }
+    else {
+        fprintf(fic,"%*u",width,value);
+        *last = value;
+    }
+}
+
+/** \brief resets the last traced (or written) state, so that the next record is a full one */
+static void resetLast(LOG_SHARED *p_log, int nGroups)
+{
+    FULL_STAT *last = TRACELAST(p_log);
+    int g;
+
+    last->st.chefStat = last->st.waiterStat = last->st.receptionistStat = UINT_MAX;
+    last->groupsWaiting = INT_MIN;
+    for (g = 0; g < nGroups; g++) {
+        GROUPSTAT(last,g) = UINT_MAX;
+        ASSIGNEDTABLE(last)[g] = INT_MIN;
+    }
+}
+
 static void printHeader(FILE *fic, FULL_STAT *p_fSt)
 {
     fprintf(fic,"%3s","CH");
@@ -80,6 +159,257 @@ static void printHeader(FILE *fic, FULL_STAT *p_fSt)
     fprintf(fic,"\n");
 }
 
+/**
+ *  \brief Consistent copy of the logged fields of the full state.
+ *
+ *  Seqlock read: the copy is retried until no lock domain was being updated before it started and no
+ *  domain changed while it was taking place.
+ */
+static void snapshotState(FULL_STAT *dst, FULL_STAT *src)
+{
+    int nDom = 2 + src->nGroups, d;
+    unsigned int seq[nDom];
+    bool changed;
+    int g;
+
+    do {
+        for (d = 0; d < nDom; d++) {
+            while ((seq[d] = __atomic_load_n (&DOMSEQ(src,d), __ATOMIC_ACQUIRE)) & 1) {
+                sched_yield ();
+            }
+        }
+        dst->st = src->st;
+        dst->groupsWaiting = src->groupsWaiting;
+        for (g = 0; g < src->nGroups; g++) {                              /* one cache line per group in the source */
+            GROUPSTAT(dst,g) = GROUPSTAT(src,g);
+        }
+        memcpy (ASSIGNEDTABLE(dst), ASSIGNEDTABLE(src), src->nGroups * sizeof (int));
+        __atomic_thread_fence (__ATOMIC_ACQUIRE);
+        changed = false;
+        for (d = 0; d < nDom; d++) {
+            if (__atomic_load_n (&DOMSEQ(src,d), __ATOMIC_RELAXED) != seq[d]) {
+                changed = true;
+            }
+        }
+    } while (changed);
+}
+
+/**
+ *  \brief Copy of the full state into the next slot of the shared log buffer.
+ *
+ *  Producers take a ticket with an atomic increment; the ticket fixes the position of the record in the log. The
+ *  caller holds the turn of its record ticket, so that the ring tickets are taken in the order of the snapshots.
+ *  If the drainer is lagging a whole ring behind, the producer yields until the slot is released.
+ */
+static void bufferState(LOG_SHARED *p_log, FULL_STAT *p_fSt)
+{
+    unsigned int t = __atomic_fetch_add (&p_log->buf.head, 1, __ATOMIC_ACQ_REL);
+    LOG_SLOT *slot = LOGSLOT(p_log, t);
+
+    while (__atomic_load_n (&slot->seq, __ATOMIC_ACQUIRE) != t) {
+        sched_yield ();
+    }
+    snapshotState (&slot->fSt, p_fSt);
+    __atomic_store_n (&slot->seq, t + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ *  \brief Waiting for the turn of the record of the calling entity (start) or handing it to the next one (end).
+ *
+ *  Records are written in the order of the tickets taken with an atomic increment (recorded or replayed): an
+ *  entity only waits for the records whose tickets were taken before its own, no system call is issued.
+ */
+static void orderLog(bool start)
+{
+    static __thread int t;
+
+    if ((logSh == NULL) || !logSh->ordered) {
+        return;
+    }
+    if (start) {
+        t = replayFetchAdd (&logSh->ticket, 1);
+        while (__atomic_load_n (&logSh->turn, __ATOMIC_ACQUIRE) != t) {
+            sched_yield ();
+        }
+    }
+    else __atomic_store_n (&logSh->turn, t + 1, __ATOMIC_RELEASE);
+}
+
+/** \brief monotonic clock (in ns) */
+static unsigned long long nowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + (unsigned long long) ts.tv_nsec;
+}
+
+/** \brief appends field change to record if value differs from the last traced one */
+static void traceField(TRACE_CHANGE *chg, uint16_t *n, int field, int *last, int value)
+{
+    if (*last != value) {
+        chg[*n].field = (uint16_t) field;
+        chg[*n].value = (int16_t) value;
+        *n += 1;
+        *last = value;
+    }
+}
+
+/**
+ *  \brief Writing a binary trace record with the fields changed since the last traced state.
+ *
+ *  Callers have the turn of their record (or hold the mutex), so the last traced state, kept in shared memory, is
+ *  consistent.
+ *  Each record is issued with a single write on a descriptor opened in append mode.
+ */
+static void traceState(char nFic[], LOG_SHARED *p_log, FULL_STAT *p_fSt)
+{
+    FULL_STAT *last = TRACELAST(p_log);
+    int n = p_fSt->nGroups, g;
+    TRACE_RECORD *hd;
+    TRACE_CHANGE *chg;
+
+    if (traceRec == NULL) {
+        if ((traceRec = malloc (sizeof (TRACE_RECORD) + (4 + 2*n) * sizeof (TRACE_CHANGE))) == NULL) {
+            perror ("error on allocating the trace record");
+            exit (EXIT_FAILURE);
+        }
+    }
+    hd = (TRACE_RECORD *) traceRec;
+    chg = (TRACE_CHANGE *) (traceRec + sizeof (TRACE_RECORD));
+
+    if (traceFd == -1) {
+        if ((nFic == NULL) || (strlen (nFic) == 0)) {
+            traceFd = STDOUT_FILENO;
+        }
+        else if ((traceFd = open (nFic, O_WRONLY | O_APPEND)) == -1) {
+            perror ("error on opening log file");
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    hd->time = (uint32_t) ((nowNs () - p_log->trace.t0) / 1000);
+    hd->entity = (uint16_t) logEntity;
+    hd->nChanges = 0;
+    traceField (chg, &hd->nChanges, TF_CHEF, (int *) &last->st.chefStat, p_fSt->st.chefStat);
+    traceField (chg, &hd->nChanges, TF_WAITER, (int *) &last->st.waiterStat, p_fSt->st.waiterStat);
+    traceField (chg, &hd->nChanges, TF_RECEPTIONIST, (int *) &last->st.receptionistStat, p_fSt->st.receptionistStat);
+    traceField (chg, &hd->nChanges, TF_GWAITING, &last->groupsWaiting, p_fSt->groupsWaiting);
+    for (g = 0; g < n; g++) {
+        traceField (chg, &hd->nChanges, TF_GROUP(g), (int *) &GROUPSTAT(last,g), GROUPSTAT(p_fSt,g));
+    }
+    for (g = 0; g < n; g++) {
+        traceField (chg, &hd->nChanges, TF_TABLE(n,g), &ASSIGNEDTABLE(last)[g], ASSIGNEDTABLE(p_fSt)[g]);
+    }
+
+    if (write (traceFd, traceRec, sizeof (TRACE_RECORD) + hd->nChanges * sizeof (TRACE_CHANGE)) == -1) {
+        perror ("error on writing to log file");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Binary trace file initialization.
+ *
+ *  The file header is written and the last traced state is reset, so that the first record is a full one.
+ */
+static void createTrace(char nFic[], LOG_SHARED *p_log, FULL_STAT *p_fSt)
+{
+    FILE *fic;                                                                                      /* file descriptor */
+    TRACE_HEADER hd;
+
+    fic = openLog(nFic,"w");
+
+    memcpy (hd.magic, TRACEMAGIC, sizeof (hd.magic));
+    hd.version = TRACEVERSION;
+    hd.nGroups = (uint16_t) p_fSt->nGroups;
+    fwrite (&hd, sizeof (hd), 1, fic);
+
+    closeLog(fic);
+
+    p_log->trace.t0 = nowNs ();
+    resetLast (p_log, p_fSt->nGroups);
+}
+
+/**
+ *  \brief Mapping of the whole preallocated log file onto the address space of the calling process.
+ *
+ *  The file is opened on the first call; later calls replace a mapping that became shorter than the file.
+ */
+static void mapLog(char nFic[], LOG_SHARED *p_log)
+{
+    if ((mapFd == -1) && ((mapFd = open (nFic, O_RDWR)) == -1)) {
+        perror ("error on opening log file");
+        exit (EXIT_FAILURE);
+    }
+    if ((mapBase != NULL) && (munmap (mapBase, mapLen) == -1)) {
+        perror ("error on unmapping the log file");
+        exit (EXIT_FAILURE);
+    }
+    mapLen = __atomic_load_n (&p_log->map.size, __ATOMIC_ACQUIRE);
+    if ((mapBase = mmap (NULL, mapLen, PROT_READ | PROT_WRITE, MAP_SHARED, mapFd, 0)) == MAP_FAILED) {
+        perror ("error on mapping the log file");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Growing of the preallocated log file until it holds <tt>end</tt> bytes.
+ *
+ *  The size is doubled; posix_fallocate never shrinks a file, so concurrent growths are harmless.
+ */
+static void growLog(LOG_SHARED *p_log, unsigned long long end)
+{
+    unsigned long long size = __atomic_load_n (&p_log->map.size, __ATOMIC_ACQUIRE), newSize;
+
+    while (end > size) {
+        for (newSize = 2 * size; newSize < end; newSize *= 2) ;
+        if ((errno = posix_fallocate (mapFd, 0, (off_t) newSize)) != 0) {
+            perror ("error on growing the log file");
+            exit (EXIT_FAILURE);
+        }
+        __atomic_compare_exchange_n (&p_log->map.size, &size, newSize, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    }
+}
+
+/**
+ *  \brief Writing the full state as a text line in the memory mapped log file.
+ *
+ *  The line is formatted in a private buffer, its room is reserved with an atomic increment of the shared end of
+ *  the records and it is copied in place. No lock is taken and no system call is issued, except when the file has
+ *  to grow. The caller holds the turn of its record ticket, so that the lines are reserved in the order of their
+ *  snapshots.
+ */
+static void mapState(char nFic[], LOG_SHARED *p_log, FULL_STAT *p_fSt)
+{
+    size_t rowSize = 64 + 16 * p_fSt->nGroups;
+    unsigned long long off;
+    long len;
+
+    if (rowFic == NULL) {
+        if (((rowBuf = malloc (rowSize)) == NULL) || ((rowFic = fmemopen (rowBuf, rowSize, "w")) == NULL)) {
+            perror ("error on allocating the log row");
+            exit (EXIT_FAILURE);
+        }
+    }
+    rewind (rowFic);
+    printLogState (rowFic, p_fSt);
+    fflush (rowFic);
+    len = ftell (rowFic);
+
+    off = __atomic_fetch_add (&p_log->map.off, (unsigned long long) len, __ATOMIC_ACQ_REL);
+    if (off + len > __atomic_load_n (&p_log->map.size, __ATOMIC_ACQUIRE)) {
+        if (mapFd == -1) {
+            mapLog (nFic, p_log);
+        }
+        growLog (p_log, off + len);
+    }
+    if ((mapBase == NULL) || (off + len > mapLen)) {
+        mapLog (nFic, p_log);
+    }
+    memcpy (mapBase + off, rowBuf, len);
+}
+
 /* external functions */
 
 /**
@@ -92,20 +422,45 @@ static void printHeader(FILE *fic, FULL_STAT *p_fSt)
  *       \li a title line
  *       \li a blank line.
  *
+ *  In binary trace mode, the header is a TRACE_HEADER.
+ *  In memory mapped mode, room for LOGMAPINIT bytes of records is preallocated after the header and the file is
+ *  mapped; it is truncated to the records written by <tt>logClose</tt>.
+ *
+ *  Below the full logging level, the logging mode is ignored: only the text log header is written.
+ *
  *  \param nFic name of the logging file
  */
 void createLog (char nFic[], FULL_STAT *p_fSt)
 {
     FILE *fic;                                                                                      /* file descriptor */
 
-    fic = openLog(nFic,"w");
+    if ((LOGLEVEL == LOGLEVEL_FULL) && (logSh != NULL) && (logSh->mode == LOGBINARY)) {
+        createTrace (nFic, logSh, p_fSt);
+        return;
+    }
 
-    /* title line + blank line */
+    fic = openLog(nFic,"w");
 
-    fprintf (fic, "%31cRestaurant - Description of the internal state\n\n", ' ');
-    printHeader(fic, p_fSt);
+    printLogHeader(fic, p_fSt);
 
     closeLog(fic);
+
+    if ((logSh != NULL) && (logSh->mode == LOGDELTA)) {
+        resetLast (logSh, p_fSt->nGroups);
+    }
+    if ((LOGLEVEL == LOGLEVEL_FULL) && (logSh != NULL) && (logSh->mode == LOGMAPPED)) {
+        if ((mapFd = open (nFic, O_RDWR)) == -1) {
+            perror ("error on opening log file");
+            exit (EXIT_FAILURE);
+        }
+        logSh->map.off = (unsigned long long) lseek (mapFd, 0, SEEK_END);
+        logSh->map.size = logSh->map.off + LOGMAPINIT;
+        if ((errno = posix_fallocate (mapFd, 0, (off_t) logSh->map.size)) != 0) {
+            perror ("error on preallocating the log file");
+            exit (EXIT_FAILURE);
+        }
+        mapLog (nFic, logSh);
+    }
 }
 
 /**
@@ -120,29 +475,196 @@ void createLog (char nFic[], FULL_STAT *p_fSt)
  *    \li groups state 
  *    \li table assigned to each group
  *
+ *  The snapshot of the full state is made consistent by the sequence counters of the lock domains, with no lock.
+ *  If buffered logging is enabled, the full state is only copied into the shared log buffer.
+ *  In binary trace mode, a record with the changed fields is written instead.
+ *  In memory mapped mode, the line is written in place in the mapped log file.
+ *  Every record is snapshot and written, or buffered, in the order of its record ticket (see logOrder).
+ *  In delta mode, the entity states that did not change since the previous line are written as ".".
+ *
  *  \param nFic name of the logging file
  *  \param p_fSt pointer to the location where the full internal state of the problem is stored
  */
-void saveState (char nFic[], FULL_STAT *p_fSt)
+void (saveState) (char nFic[], FULL_STAT *p_fSt)
+{
+    FILE *fic;                                                                                      /* file descriptor */
+
+    if ((logSh != NULL) && (logSh->mode == LOGBUFFERED)) {
+        orderLog (true);
+        bufferState (logSh, p_fSt);
+        orderLog (false);
+        return;
+    }
+
+    if (snap == NULL) {
+        if ((snap = aligned_alloc (CACHELINE, logSnapshotSize (p_fSt->nGroups))) == NULL) {
+            perror ("error on allocating the state snapshot");
+            exit (EXIT_FAILURE);
+        }
+        logSnapshotInit (snap, p_fSt->nGroups);
+    }
+
+    orderLog (true);
+
+    snapshotState (snap, p_fSt);
+    if ((logSh != NULL) && (logSh->mode == LOGMAPPED)) {
+        mapState (nFic, logSh, snap);
+    }
+    else if ((logSh != NULL) && (logSh->mode == LOGBINARY)) {
+        traceState (nFic, logSh, snap);
+    }
+    else {
+        fic = openLog(nFic,"a");
+
+        if ((logSh != NULL) && (logSh->mode == LOGDELTA)) {
+            printDeltaState(fic, snap, TRACELAST(logSh));
+        }
+        else {
+            printLogState(fic, snap);
+        }
+
+        closeLog(fic);
+    }
+
+    orderLog (false);
+}
+
+/**
+ *  \brief Counting of the present state of the calling entity (summary logging level).
+ *
+ *  The calling entity holds the lock of its own state, that can be read with no snapshot.
+ *
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ */
+void logCount (FULL_STAT *p_fSt)
+{
+    unsigned int kind = ENTITYKIND(logEntity),
+                 state;
+    int gw, max;
+
+    if ((logSh == NULL) || (kind == ENT_GENERATOR)) {
+        return;
+    }
+    switch (kind) {
+        case ENT_GROUP:
+            state = GROUPSTAT(p_fSt, ENTITYIDX(logEntity));
+            break;
+        case ENT_WAITER:
+            state = p_fSt->st.waiterStat;
+            break;
+        case ENT_CHEF:
+            state = p_fSt->st.chefStat;
+            break;
+        default:
+            state = p_fSt->st.receptionistStat;
+    }
+    if (state < LOGSTATES) {
+        __atomic_fetch_add (&logSh->saved[kind][state], 1, __ATOMIC_RELAXED);
+    }
+    gw = __atomic_load_n (&p_fSt->groupsWaiting, __ATOMIC_RELAXED);
+    max = __atomic_load_n (&logSh->maxGroupsWaiting, __ATOMIC_RELAXED);
+    while ((gw > max) && !__atomic_compare_exchange_n (&logSh->maxGroupsWaiting, &max, gw, true, __ATOMIC_RELAXED,
+                                                       __ATOMIC_RELAXED)) ;
+}
+
+/**
+ *  \brief Writing the counts of the states saved in the run at the end of the logging file (summary logging level).
+ *
+ *  A line per entity kind has the number of states saved in each of its states and their total.
+ *
+ *  \param nFic name of the logging file
+ *  \param p_log pointer to the shared logging control data
+ */
+void (logSummary) (char nFic[], LOG_SHARED *p_log)
 {
+    static const char *kindName[ENT_RECEPTIONIST+1] = { "GN", "G", "WT", "CH", "RC" };
     FILE *fic;                                                                                      /* file descriptor */
+    unsigned long long total;
+    unsigned int kind, state;
 
     fic = openLog(nFic,"a");
 
+    fprintf(fic,"\nStates saved in each state\n");
+    fprintf(fic,"%3s","");
+    for (state = 0; state < LOGSTATES; state++) {
+        fprintf(fic," %8u",state);
+    }
+    fprintf(fic," %10s\n","total");
+    for (kind = ENT_GROUP; kind <= ENT_RECEPTIONIST; kind++) {
+        fprintf(fic,"%3s",kindName[kind]);
+        total = 0;
+        for (state = 0; state < LOGSTATES; state++) {
+            fprintf(fic," %8llu",p_log->saved[kind][state]);
+            total += p_log->saved[kind][state];
+        }
+        fprintf(fic," %10llu\n",total);
+    }
+    fprintf(fic,"Largest number of groups waiting: %d\n",p_log->maxGroupsWaiting);
+
+    closeLog(fic);
+}
+
+/**
+ *  \brief Start of an update of the fields of a lock domain.
+ *
+ *  Must be called by the holder of the domain lock; the domain sequence counter becomes odd.
+ *
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ *  \param dom lock domain (DOM_RECEPTION, DOM_KITCHEN or DOM_GROUP(g))
+ */
+void stateBegin (FULL_STAT *p_fSt, unsigned int dom)
+{
+    __atomic_store_n (&DOMSEQ(p_fSt,dom), DOMSEQ(p_fSt,dom) + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence (__ATOMIC_RELEASE);
+}
+
+/**
+ *  \brief End of an update of the fields of a lock domain.
+ *
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ *  \param dom lock domain (DOM_RECEPTION, DOM_KITCHEN or DOM_GROUP(g))
+ */
+void stateEnd (FULL_STAT *p_fSt, unsigned int dom)
+{
+    __atomic_store_n (&DOMSEQ(p_fSt,dom), DOMSEQ(p_fSt,dom) + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ *  \brief Writing the text log header (title line, blank line and column names).
+ *
+ *  \param fic output stream
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ */
+void printLogHeader (FILE *fic, FULL_STAT *p_fSt)
+{
+    /* title line + blank line */
+
+    fprintf (fic, "%31cRestaurant - Description of the internal state\n\n", ' ');
+    printHeader(fic, p_fSt);
+}
+
+/**
+ *  \brief Writing the present full state as a single text line.
+ *
+ *  \param fic output stream
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ */
+void printLogState (FILE *fic, FULL_STAT *p_fSt)
+{
     fprintf(fic,"%3d",p_fSt->st.chefStat);
     fprintf(fic,"%3d",p_fSt->st.waiterStat);
     fprintf(fic,"%3d",p_fSt->st.receptionistStat);
     fprintf(fic," ");
     int g;
     for(g=0; g < p_fSt->nGroups; g++) {
-        fprintf(fic,"%4d",p_fSt->st.groupStat[g]);
+        fprintf(fic,"%4d",GROUPSTAT(p_fSt,g));
     }
 
     fprintf(fic,"%5d",p_fSt->groupsWaiting);
 
     for(g=0; g < p_fSt->nGroups; g++) {
-        if(p_fSt->assignedTable[g]!=-1)
-            fprintf(fic,"%4d",p_fSt->assignedTable[g]);
+        if(ASSIGNEDTABLE(p_fSt)[g]!=-1)
+            fprintf(fic,"%4d",ASSIGNEDTABLE(p_fSt)[g]);
         else {
             fprintf(fic,"%4s",".");
         }
@@ -150,7 +672,233 @@ void saveState (char nFic[], FULL_STAT *p_fSt)
 
 
     fprintf(fic,"\n");
+}
+
+/**
+ *  \brief Writing the present full state as a single text line, showing unchanged entity states as ".".
+ *
+ *  The layout is the one of printLogState. The states of the chef, waiter, receptionist and groups that are
+ *  equal to the ones of the last line are replaced by "."; the last line state is then updated.
+ *
+ *  \param fic output stream
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ *  \param last pointer to the state of the last line written
+ */
+void printDeltaState (FILE *fic, FULL_STAT *p_fSt, FULL_STAT *last)
+{
+    int g;
+
+    deltaField (fic, 3, &last->st.chefStat, p_fSt->st.chefStat);
+    deltaField (fic, 3, &last->st.waiterStat, p_fSt->st.waiterStat);
+    deltaField (fic, 3, &last->st.receptionistStat, p_fSt->st.receptionistStat);
+    fprintf(fic," ");
+    for(g=0; g < p_fSt->nGroups; g++) {
+        deltaField (fic, 4, &GROUPSTAT(last,g), GROUPSTAT(p_fSt,g));
+    }
+
+    fprintf(fic,"%5d",p_fSt->groupsWaiting);
+
+    for(g=0; g < p_fSt->nGroups; g++) {
+        if(ASSIGNEDTABLE(p_fSt)[g]!=-1)
+            fprintf(fic,"%4d",ASSIGNEDTABLE(p_fSt)[g]);
+        else {
+            fprintf(fic,"%4s",".");
+        }
+    }
+
+    fprintf(fic,"\n");
+}
+
+/**
+ *  \brief Size of a state snapshot (structure and group arrays).
+ *
+ *  \param nGroups number of groups
+ *
+ *  \return size in bytes, multiple of CACHELINE
+ */
+size_t logSnapshotSize (int nGroups)
+{
+    return ALIGNCL(sizeof (FULL_STAT) + 2 * nGroups * sizeof (int));
+}
+
+/**
+ *  \brief Initialization of a state snapshot.
+ *
+ *  Sets the offsets of the group state and assigned table arrays, that follow the structure; unlike in the shared
+ *  region, the group states are packed. The remaining group arrays are not part of a snapshot.
+ *
+ *  \param p_fSt pointer to a location with logSnapshotSize(nGroups) bytes
+ *  \param nGroups number of groups
+ */
+void logSnapshotInit (FULL_STAT *p_fSt, int nGroups)
+{
+    memset (p_fSt, 0, logSnapshotSize (nGroups));
+    p_fSt->nGroups = nGroups;
+    p_fSt->offGroupStat = sizeof (FULL_STAT);
+    p_fSt->stride = sizeof (unsigned int);
+    p_fSt->offAssignedTable = sizeof (FULL_STAT) + nGroups * sizeof (unsigned int);
+}
+
+/**
+ *  \brief Size of the area that holds the log buffer slots and the last traced state.
+ *
+ *  \param nGroups number of groups
+ *
+ *  \return size in bytes, multiple of CACHELINE
+ */
+size_t logSize (int nGroups)
+{
+    size_t stride = ALIGNCL(offsetof (LOG_SLOT, fSt) + logSnapshotSize (nGroups));
+
+    return LOGSLOTS * stride + logSnapshotSize (nGroups);
+}
+
+/**
+ *  \brief Initialization of the shared logging control data.
+ *
+ *  Must be called by the generator, before the log file is created and any entity is launched.
+ *  The area must be in the same shared region as the control data and start a cache line.
+ *
+ *  \param p_log pointer to the shared logging control data
+ *  \param mode logging mode (LOGTEXT, LOGBUFFERED, LOGBINARY, LOGMAPPED or LOGDELTA)
+ *  \param nGroups number of groups
+ *  \param area pointer to a location with logSize(nGroups) bytes
+ */
+void logInit (LOG_SHARED *p_log, unsigned int mode, int nGroups, void *area)
+{
+    unsigned int i;
+
+    p_log->mode = mode;
+    p_log->ordered = false;
+    p_log->ticket = p_log->turn = 0;
+    p_log->map.off = p_log->map.size = 0;
+    memset (p_log->saved, 0, sizeof (p_log->saved));
+    p_log->maxGroupsWaiting = 0;
+    p_log->buf.closed = false;
+    p_log->buf.head = 0;
+    p_log->buf.tail = 0;
+    p_log->buf.stride = ALIGNCL(offsetof (LOG_SLOT, fSt) + logSnapshotSize (nGroups));
+    p_log->buf.offSlot = (char *) area - (char *) p_log;
+    for (i = 0; i < LOGSLOTS; i++) {
+        LOGSLOT(p_log, i)->seq = i;
+        logSnapshotInit (&LOGSLOT(p_log, i)->fSt, nGroups);
+    }
+    p_log->trace.offLast = p_log->buf.offSlot + LOGSLOTS * p_log->buf.stride;
+    logSnapshotInit (TRACELAST(p_log), nGroups);
+    logAttach (p_log, ENTITYID(ENT_GENERATOR, 0));
+}
+
+/**
+ *  \brief Binding of the calling process to the shared logging control data.
+ *
+ *  From then on <tt>saveState</tt> follows the logging mode chosen by the generator. Log files left open by a
+ *  previous binding are closed, so that the next record goes to the logging file of the present run (server mode).
+ *
+ *  \param p_log pointer to the shared logging control data
+ *  \param entity id of the calling entity (see ENTITYID)
+ */
+void logAttach (LOG_SHARED *p_log, unsigned int entity)
+{
+    if ((traceFd != -1) && (traceFd != STDOUT_FILENO) && (close (traceFd) == -1)) {
+        perror ("error on closing of the binary trace file");
+        exit (EXIT_FAILURE);
+    }
+    traceFd = -1;
+    if ((mapBase != NULL) && (munmap (mapBase, mapLen) == -1)) {
+        perror ("error on unmapping the log file");
+        exit (EXIT_FAILURE);
+    }
+    mapBase = NULL;
+    mapLen = 0;
+    if ((mapFd != -1) && (close (mapFd) == -1)) {
+        perror ("error on closing of log file");
+        exit (EXIT_FAILURE);
+    }
+    mapFd = -1;
+    logSh = p_log;
+    logEntity = entity;
+}
+
+/**
+ *  \brief Setting whether records are written in the order of record tickets.
+ *
+ *  Needed when entities call saveState holding different domain locks: the snapshot and the writing of a record
+ *  then wait for the records whose tickets were taken before, in user space.
+ *
+ *  \param p_log pointer to the shared logging control data
+ *  \param ordered false if callers of saveState already exclude each other
+ */
+void logOrder (LOG_SHARED *p_log, bool ordered)
+{
+    p_log->ordered = ordered;
+}
+
+/**
+ *  \brief Drainer of the shared log buffer.
+ *
+ *  Formats the buffered snapshots and writes them, in large chunks, at the end of the logging file.
+ *  Returns after <tt>logClose</tt> has been called and the buffer is empty.
+ *
+ *  \param nFic name of the logging file
+ *  \param p_log pointer to the shared logging control data
+ */
+void logDrain (char nFic[], LOG_SHARED *p_log)
+{
+    FILE *fic;                                                                                      /* file descriptor */
+    static char chunk[LOGCHUNK];                                                              /* output stdio buffer */
+    LOG_SLOT *slot;
+    bool pending = false;                                                          /* records not yet flushed to file */
+
+    fic = openLog(nFic,"a");
+    setvbuf (fic, chunk, _IOFBF, LOGCHUNK);
+
+    while (true) {
+        slot = LOGSLOT(p_log, p_log->buf.tail);
+        if (__atomic_load_n (&slot->seq, __ATOMIC_ACQUIRE) == p_log->buf.tail + 1) {
+            printLogState (fic, &slot->fSt);
+            __atomic_store_n (&slot->seq, p_log->buf.tail + LOGSLOTS, __ATOMIC_RELEASE);
+            p_log->buf.tail += 1;
+            pending = true;
+        }
+        else if (__atomic_load_n (&p_log->buf.closed, __ATOMIC_ACQUIRE) &&
+                 (p_log->buf.tail == __atomic_load_n (&p_log->buf.head, __ATOMIC_ACQUIRE))) {
+            break;
+        }
+        else {
+            if (pending) {                                                /* idle: hand the pending chunk to the kernel */
+                fflush (fic);
+                pending = false;
+            }
+            usleep (1000);
+        }
+    }
 
     closeLog(fic);
 }
 
+/**
+ *  \brief Signalling the drainer that no more snapshots will be produced.
+ *
+ *  In memory mapped mode, the log file is unmapped and truncated to the records written; must be called by the
+ *  generator, after every entity has terminated.
+ *
+ *  \param p_log pointer to the shared logging control data
+ */
+void logClose (LOG_SHARED *p_log)
+{
+    __atomic_store_n (&p_log->buf.closed, true, __ATOMIC_RELEASE);
+
+    if ((p_log->mode == LOGMAPPED) && (mapFd != -1)) {
+        if ((mapBase != NULL) && (munmap (mapBase, mapLen) == -1)) {
+            perror ("error on unmapping the log file");
+            exit (EXIT_FAILURE);
+        }
+        if ((ftruncate (mapFd, (off_t) p_log->map.off) == -1) || (close (mapFd) == -1)) {
+            perror ("error on truncating the log file");
+            exit (EXIT_FAILURE);
+        }
+        mapBase = NULL;
+        mapLen = 0;
+        mapFd = -1;
+    }
+}
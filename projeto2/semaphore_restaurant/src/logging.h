@@ -7,7 +7,19 @@
  *
  *  Defined operations:
  *     \li file initialization
- *     \li writing the present full state as a single line at the end of the file.
+ *     \li writing the present full state as a single line at the end of the file
+ *     \li buffered logging through a shared ring of snapshots emptied by a drainer
+ *     \li binary tracing of the fields changed by each state transition
+ *     \li memory mapped logging: records are formatted in place, in a preallocated log file
+ *     \li delta logging: only the entity states changed since the previous line are written
+ *     \li sequence counters that allow saveState to take consistent snapshots without a global lock
+ *     \li summary of the states saved in a run.
+ *
+ *  The logging level is chosen at compile time, by LOGLEVEL (the LOG variable of the Makefile: none, summary or
+ *  full). At the full level, the default, <tt>saveState</tt> writes a record per call, following the logging mode.
+ *  At the summary level it only counts the state saved, in shared memory, and <tt>logSummary</tt> writes the counts
+ *  at the end of the run, after the log header. At the none level it compiles to nothing. Below the full level the
+ *  logging file only holds the text log header (and the summary), whatever the logging mode.
  *
  *  \author Nuno Lau - December 2023
  */
@@ -15,8 +27,79 @@
 #ifndef LOGGING_H_
 #define LOGGING_H_
 
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "probConst.h"
 #include "probDataStruct.h"
 
+#ifndef LOGLEVEL
+/** \brief logging level (LOGLEVEL_NONE, LOGLEVEL_SUMMARY or LOGLEVEL_FULL) */
+#define  LOGLEVEL        LOGLEVEL_FULL
+#endif
+
+/* Binary trace format:
+ *   file header, followed by records;
+ *   record header, followed by nChanges changes.
+ * Fields in a change are numbered
+ *   0 chef, 1 waiter, 2 receptionist, 3 groupsWaiting,
+ *   4 .. 4+nGroups-1 group states, 4+nGroups .. 4+2*nGroups-1 assigned tables.
+ */
+
+/** \brief binary trace magic number */
+#define  TRACEMAGIC      "RSTB"
+/** \brief binary trace format version */
+#define  TRACEVERSION    1
+
+/** \brief field number of chef state */
+#define  TF_CHEF         0
+/** \brief field number of waiter state */
+#define  TF_WAITER       1
+/** \brief field number of receptionist state */
+#define  TF_RECEPTIONIST 2
+/** \brief field number of groups waiting */
+#define  TF_GWAITING     3
+/** \brief field number of state of group g */
+#define  TF_GROUP(g)     (4+(g))
+/** \brief field number of table assigned to group g */
+#define  TF_TABLE(n,g)   (4+(n)+(g))
+
+/**
+ *  \brief Definition of the binary trace file header.
+ */
+typedef struct {
+    /** \brief magic number */
+    char magic[4];
+    /** \brief format version */
+    uint16_t version;
+    /** \brief number of groups */
+    uint16_t nGroups;
+} TRACE_HEADER;
+
+/**
+ *  \brief Definition of the binary trace record header.
+ */
+typedef struct {
+    /** \brief time since start of the trace (in us) */
+    uint32_t time;
+    /** \brief id of the entity that saved the state */
+    uint16_t entity;
+    /** \brief number of changed fields that follow */
+    uint16_t nChanges;
+} TRACE_RECORD;
+
+/**
+ *  \brief Definition of a changed field in a binary trace record.
+ */
+typedef struct {
+    /** \brief field number */
+    uint16_t field;
+    /** \brief new value */
+    int16_t value;
+} TRACE_CHANGE;
+
 /**
  *  \brief File initialization.
  *
@@ -27,6 +110,9 @@
  *       \li a title line
  *       \li a blank line.
  *
+ *  In memory mapped mode, room for LOGMAPINIT bytes of records is preallocated after the header and the file is
+ *  mapped; it is truncated to the records written by <tt>logClose</tt>.
+ *
  *  \param nFic name of the logging file
  */
 extern void createLog (char nFic[], FULL_STAT *p_fSt);
@@ -41,4 +127,158 @@ extern void createLog (char nFic[], FULL_STAT *p_fSt);
  */
 extern void saveState (char nFic[], FULL_STAT *p_fSt);
 
+/**
+ *  \brief Counting of the present state of the calling entity (summary logging level).
+ *
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ */
+extern void logCount (FULL_STAT *p_fSt);
+
+/**
+ *  \brief Writing the counts of the states saved in the run at the end of the logging file (summary logging level).
+ *
+ *  Must be called by the generator, after every entity finished the run.
+ *
+ *  \param nFic name of the logging file
+ *  \param p_log pointer to the shared logging control data
+ */
+extern void logSummary (char nFic[], LOG_SHARED *p_log);
+
+#if LOGLEVEL == LOGLEVEL_NONE
+#define  saveState(nFic,p_fSt)       ((void) 0)
+#elif LOGLEVEL == LOGLEVEL_SUMMARY
+#define  saveState(nFic,p_fSt)       logCount (p_fSt)
+#endif
+#if LOGLEVEL != LOGLEVEL_SUMMARY
+#define  logSummary(nFic,p_log)      ((void) 0)
+#endif
+
+/**
+ *  \brief Writing the text log header (title line, blank line and column names).
+ *
+ *  \param fic output stream
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ */
+extern void printLogHeader (FILE *fic, FULL_STAT *p_fSt);
+
+/**
+ *  \brief Writing the present full state as a single text line.
+ *
+ *  \param fic output stream
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ */
+extern void printLogState (FILE *fic, FULL_STAT *p_fSt);
+
+/**
+ *  \brief Writing the present full state as a single text line, showing unchanged entity states as ".".
+ *
+ *  \param fic output stream
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ *  \param last pointer to the state of the last line written (updated)
+ */
+extern void printDeltaState (FILE *fic, FULL_STAT *p_fSt, FULL_STAT *last);
+
+/**
+ *  \brief Start of an update of the fields of a lock domain.
+ *
+ *  Must be called by the holder of the domain lock; the domain sequence counter becomes odd.
+ *
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ *  \param dom lock domain (DOM_RECEPTION, DOM_KITCHEN or DOM_GROUP(g))
+ */
+extern void stateBegin (FULL_STAT *p_fSt, unsigned int dom);
+
+/**
+ *  \brief End of an update of the fields of a lock domain.
+ *
+ *  \param p_fSt pointer to the location where the full internal state of the problem is stored
+ *  \param dom lock domain (DOM_RECEPTION, DOM_KITCHEN or DOM_GROUP(g))
+ */
+extern void stateEnd (FULL_STAT *p_fSt, unsigned int dom);
+
+/**
+ *  \brief Size of a state snapshot (structure and group arrays).
+ *
+ *  \param nGroups number of groups
+ *
+ *  \return size in bytes, multiple of CACHELINE
+ */
+extern size_t logSnapshotSize (int nGroups);
+
+/**
+ *  \brief Initialization of a state snapshot.
+ *
+ *  Sets the offsets of the group state and assigned table arrays, that follow the structure.
+ *  The remaining group arrays are not part of a snapshot.
+ *
+ *  \param p_fSt pointer to a location with logSnapshotSize(nGroups) bytes
+ *  \param nGroups number of groups
+ */
+extern void logSnapshotInit (FULL_STAT *p_fSt, int nGroups);
+
+/**
+ *  \brief Size of the area that holds the log buffer slots and the last traced state.
+ *
+ *  \param nGroups number of groups
+ *
+ *  \return size in bytes, multiple of CACHELINE
+ */
+extern size_t logSize (int nGroups);
+
+/**
+ *  \brief Initialization of the shared logging control data.
+ *
+ *  Must be called by the generator, before the log file is created and any entity is launched.
+ *  The area must be in the same shared region as the control data and start a cache line.
+ *
+ *  \param p_log pointer to the shared logging control data
+ *  \param mode logging mode (LOGTEXT, LOGBUFFERED, LOGBINARY, LOGMAPPED or LOGDELTA)
+ *  \param nGroups number of groups
+ *  \param area pointer to a location with logSize(nGroups) bytes
+ */
+extern void logInit (LOG_SHARED *p_log, unsigned int mode, int nGroups, void *area);
+
+/**
+ *  \brief Binding of the calling process to the shared logging control data.
+ *
+ *  From then on <tt>saveState</tt> follows the logging mode chosen by the generator. Log files left open by a
+ *  previous binding are closed, so that the next record goes to the logging file of the present run (server mode).
+ *
+ *  \param p_log pointer to the shared logging control data
+ *  \param entity id of the calling entity (see ENTITYID)
+ */
+extern void logAttach (LOG_SHARED *p_log, unsigned int entity);
+
+/**
+ *  \brief Setting whether records are written in the order of record tickets.
+ *
+ *  Needed when entities call saveState holding different domain locks: the snapshot and the writing of a record
+ *  then wait for the records whose tickets were taken before, in user space.
+ *
+ *  \param p_log pointer to the shared logging control data
+ *  \param ordered false if callers of saveState already exclude each other
+ */
+extern void logOrder (LOG_SHARED *p_log, bool ordered);
+
+/**
+ *  \brief Drainer of the shared log buffer.
+ *
+ *  Formats the buffered snapshots and writes them, in large chunks, at the end of the logging file.
+ *  Returns after <tt>logClose</tt> has been called and the buffer is empty.
+ *
+ *  \param nFic name of the logging file
+ *  \param p_log pointer to the shared logging control data
+ */
+extern void logDrain (char nFic[], LOG_SHARED *p_log);
+
+/**
+ *  \brief Signalling the drainer that no more snapshots will be produced.
+ *
+ *  In memory mapped mode, the log file is unmapped and truncated to the records written; must be called by the
+ *  generator, after every entity has terminated.
+ *
+ *  \param p_log pointer to the shared logging control data
+ */
+extern void logClose (LOG_SHARED *p_log);
+
 #endif /* LOGGING_H_ */
@@ -0,0 +1,230 @@
+/**
+ *  \file monitor.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  Live monitor of a running simulation.
+ *
+ *  Attaches to the shared region of the simulation and samples, at a fixed period, the live counters (see
+ *  liveStats.h), the depths of the request queues, the number of groups waiting for a table and the cumulative time
+ *  the groups spent waiting for a table and for food (see latency.h). Nothing is locked and nothing is written:
+ *  the entities are never stopped, and the simulation may be run with any logging mode. The monitor ends when
+ *  every group of the last run has left, or when nobody else is attached to the shared region.
+ *
+ *  Each sample is printed as a dashboard, redrawn in place when the output is a terminal, or as a line in JSON
+ *  format. The simulation must run as processes (the shared region of the <tt>threads</tt> engine is private).
+ *
+ *  Options:
+ *    \li -k key access key to shared memory (default generated by ftok on the current directory, as the generator)
+ *    \li -i number sampling period (in ms, default 500)
+ *    \li -j one JSON object per sample, with the fields of the dashboard.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "sharedDataSync.h"
+#include "sharedMemory.h"
+#include "requestQueue.h"
+#include "latency.h"
+#include "liveStats.h"
+
+/**
+ *  \brief Definition of a sample of the simulation.
+ */
+typedef struct {
+    /** \brief present run (0 .. runs-1) */
+    int run;
+    /** \brief simulation time (in us) */
+    unsigned long long now;
+    /** \brief live counters */
+    long long counter[LIVECOUNTERS];
+    /** \brief groups waiting for a table */
+    int groupsWaiting;
+    /** \brief depths of the receptionist, waiter, order and ready queues */
+    unsigned int depth[4];
+    /** \brief number of waits for a table and for food */
+    unsigned long long waits[2];
+    /** \brief cumulative time of the waits for a table and for food (in ns) */
+    unsigned long long waitNs[2];
+} SAMPLE;
+
+/** \brief pointer to shared memory region */
+static SHARED_DATA *sh;
+
+/* internal functions */
+
+/** \brief monotonic clock (in ns) */
+static unsigned long long nowNs (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/** \brief sampling of the simulation */
+static void sample (SAMPLE *s)
+{
+    REQ_QUEUE *q[4] = { &sh->fSt.receptionistRequest, &sh->fSt.waiterRequest, &sh->fSt.orderRequest,
+                        &sh->fSt.readyRequest };
+    unsigned int points[2] = { LAT_WAITFORTABLE, LAT_FOODARRIVED };
+    unsigned long long t0;
+    int i;
+
+    s->run = __atomic_load_n (&sh->run.run, __ATOMIC_ACQUIRE);
+    if (sh->clock.virtualTime) {
+        s->now = __atomic_load_n (&sh->clock.now, __ATOMIC_RELAXED);
+    }
+    else {
+        t0 = __atomic_load_n (&sh->clock.t0, __ATOMIC_RELAXED);
+        s->now = (t0 == 0) ? 0 : (nowNs () - t0) / 1000;                        /* the clock may not be started yet */
+    }
+    for (i = 0; i < LIVECOUNTERS; i++) {
+        s->counter[i] = liveRead (&sh->live, i);
+    }
+    s->groupsWaiting = __atomic_load_n (&sh->fSt.groupsWaiting, __ATOMIC_RELAXED);
+    for (i = 0; i < 4; i++) {
+        s->depth[i] = queueDepth (q[i]);
+    }
+    for (i = 0; i < 2; i++) {
+        s->waits[i] = latTotal (&sh->lat, points[i], &s->waitNs[i]);
+    }
+}
+
+/** \brief the monitor is the only process attached to the shared region (the simulation ended) */
+static bool alone (int shmid)
+{
+    struct shmid_ds ds;
+
+    return (shmctl (shmid, IPC_STAT, &ds) == -1) || (ds.shm_nattch <= 1);
+}
+
+/** \brief mean of the waits (in us) */
+static double meanUs (SAMPLE *s, int i)
+{
+    return (s->waits[i] == 0) ? 0.0 : s->waitNs[i] / 1000.0 / s->waits[i];
+}
+
+/** \brief printing of a sample as a dashboard */
+static void printDashboard (SAMPLE *s, bool redraw)
+{
+    if (redraw) {
+        printf ("\033[H\033[J");                                               /* cursor home and clear the screen */
+    }
+    printf ("run %d/%u   time %.3f s\n", s->run + 1, sh->run.runs, s->now / 1e6);
+    printf ("  groups left        %6lld / %d\n", s->counter[LIVE_LEFT], sh->fSt.nGroups);
+    printf ("  tables occupied    %6lld / %d\n", s->counter[LIVE_TABLES], sh->fSt.nTables);
+    printf ("  groups waiting     %6d\n", s->groupsWaiting);
+    printf ("  requests served    receptionist %6lld   waiters %6lld   chefs %6lld\n",
+            s->counter[LIVE_RECEPTION], s->counter[LIVE_WAITER], s->counter[LIVE_CHEF]);
+    printf ("  queue depths       receptionist %6u   waiters %6u   orders %6u   ready %6u\n",
+            s->depth[0], s->depth[1], s->depth[2], s->depth[3]);
+    printf ("  wait for table     %10.3f ms total %10.1f us mean\n", s->waitNs[0] / 1e6, meanUs (s, 0));
+    printf ("  wait for food      %10.3f ms total %10.1f us mean\n", s->waitNs[1] / 1e6, meanUs (s, 1));
+    if (!redraw) {
+        printf ("\n");
+    }
+    fflush (stdout);
+}
+
+/** \brief printing of a sample as a JSON object */
+static void printJson (SAMPLE *s)
+{
+    printf ("{\"run\":%d,\"time_us\":%llu,\"groups\":%d,\"groups_left\":%lld,\"tables\":%d,\"tables_occupied\":%lld,"
+            "\"groups_waiting\":%d,\"served_receptionist\":%lld,\"served_waiters\":%lld,\"served_chefs\":%lld,"
+            "\"depth_receptionist\":%u,\"depth_waiters\":%u,\"depth_orders\":%u,\"depth_ready\":%u,"
+            "\"table_waits\":%llu,\"table_wait_ns\":%llu,\"food_waits\":%llu,\"food_wait_ns\":%llu}\n",
+            s->run + 1, s->now, sh->fSt.nGroups, s->counter[LIVE_LEFT], sh->fSt.nTables, s->counter[LIVE_TABLES],
+            s->groupsWaiting, s->counter[LIVE_RECEPTION], s->counter[LIVE_WAITER], s->counter[LIVE_CHEF],
+            s->depth[0], s->depth[1], s->depth[2], s->depth[3], s->waits[0], s->waitNs[0], s->waits[1],
+            s->waitNs[1]);
+    fflush (stdout);
+}
+
+/**
+ *  \brief Main program.
+ */
+int main (int argc, char *argv[])
+{
+    int key = -1;                                                                   /* access key to shared memory */
+    long period = 500;                                                                   /* sampling period (in ms) */
+    bool json = false,                                                                    /* JSON output format */
+         redraw;                                                                    /* dashboard redrawn in place */
+    SAMPLE s;
+    int shmid, opt;
+    char *tinp;                                                                /* numerical parameters test flag */
+
+    while ((opt = getopt (argc, argv, "k:i:j")) != -1) {
+        switch (opt) {
+            case 'k':
+                key = (int) strtol (optarg, &tinp, 0);
+                if (*tinp != '\0') {
+                    fprintf (stderr, "Access key must be a number!\n");
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'i':
+                period = strtol (optarg, &tinp, 0);
+                if ((*tinp != '\0') || (period < 1)) {
+                    fprintf (stderr, "Sampling period must be at least 1 ms!\n");
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'j':
+                json = true;
+                break;
+            default:
+                fprintf (stderr, "USAGE: %s [-k key] [-i period] [-j]\n", argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if (optind != argc) {
+        fprintf (stderr, "USAGE: %s [-k key] [-i period] [-j]\n", argv[0]);
+        exit (EXIT_FAILURE);
+    }
+
+    if ((key == -1) && ((key = ftok (".", 'a')) == -1)) {
+        perror ("error on generating the key");
+        exit (EXIT_FAILURE);
+    }
+    if ((shmid = shmemConnect (key)) == -1) {
+        perror ("error on connecting to the shared memory region");
+        exit (EXIT_FAILURE);
+    }
+    if (shmemAttach (shmid, (void **) &sh) == -1) {
+        perror ("error on mapping the shared region on the process address space");
+        exit (EXIT_FAILURE);
+    }
+
+    redraw = !json && isatty (STDOUT_FILENO);
+    do {
+        sample (&s);
+        if (json) {
+            printJson (&s);
+        }
+        else printDashboard (&s, redraw);
+        if ((s.run == (int) sh->run.runs - 1) && (s.counter[LIVE_LEFT] == sh->fSt.nGroups)) {
+            break;                                                            /* every group of the last run left */
+        }
+        if (alone (shmid)) {
+            fprintf (stderr, "The simulation is no longer running!\n");
+            break;
+        }
+    } while (usleep ((useconds_t) (period * 1000)) == 0);
+
+    if (shmemDettach (sh) == -1) {
+        perror ("error on unmapping the shared region off the process address space");
+        exit (EXIT_FAILURE);
+    }
+
+    return EXIT_SUCCESS;
+}
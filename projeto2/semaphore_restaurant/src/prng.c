@@ -0,0 +1,92 @@
+/**
+ *  \file prng.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Seeded pseudo random number generators.
+ *
+ *  Defined operations:
+ *     \li seeding of a generator for one stream of a run
+ *     \li uniform, exponential and normal samples.
+ */
+
+#include <math.h>
+
+#include "prng.h"
+
+/* internal functions */
+
+/** \brief splitmix64 step, spreads close seeds all over the state space */
+static unsigned long long splitmix (unsigned long long x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/* external functions */
+
+/**
+ *  \brief Seeding of a generator.
+ *
+ *  \param r pointer to the generator
+ *  \param seed run seed
+ *  \param stream stream number
+ */
+void prngSeed (PRNG *r, unsigned long long seed, unsigned int stream)
+{
+    r->s = splitmix (splitmix (seed) ^ stream);
+    if (r->s == 0) {
+        r->s = 0x9E3779B97F4A7C15ULL;
+    }
+}
+
+/**
+ *  \brief Next 64 bit number.
+ *
+ *  \param r pointer to the generator
+ *
+ *  \return pseudo random number
+ */
+unsigned long long prngNext (PRNG *r)
+{
+    r->s ^= r->s >> 12;
+    r->s ^= r->s << 25;
+    r->s ^= r->s >> 27;
+    return r->s * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ *  \brief Uniform sample in [0, 1).
+ *
+ *  \param r pointer to the generator
+ */
+double prngUniform (PRNG *r)
+{
+    return (prngNext (r) >> 11) * (1.0 / 9007199254740992.0);                                 /* 53 bit mantissa */
+}
+
+/**
+ *  \brief Exponential sample.
+ *
+ *  \param r pointer to the generator
+ *  \param mean mean of the distribution
+ */
+double prngExp (PRNG *r, double mean)
+{
+    return -mean * log (1.0 - prngUniform (r));
+}
+
+/**
+ *  \brief Normal sample with zero mean (Box-Muller).
+ *
+ *  \param r pointer to the generator
+ *  \param stddev standard deviation of the distribution
+ */
+double prngNormal (PRNG *r, double stddev)
+{
+    double u = 1.0 - prngUniform (r), v = prngUniform (r);
+
+    return stddev * sqrt (-2.0 * log (u)) * cos (2.0 * M_PI * v);
+}
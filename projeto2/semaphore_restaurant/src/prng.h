@@ -0,0 +1,68 @@
+/**
+ *  \file prng.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Seeded pseudo random number generators.
+ *
+ *  Defined operations:
+ *     \li seeding of a generator for one stream of a run
+ *     \li uniform, exponential and normal samples.
+ *
+ *  Each entity owns its generator (xorshift64*), seeded from the run seed and a stream number (the entity id), so
+ *  that every entity draws the same numbers on every run with the same seed, whatever the interleaving.
+ */
+
+#ifndef PRNG_H_
+#define PRNG_H_
+
+/**
+ *  \brief Definition of the state of a generator.
+ */
+typedef struct {
+    /** \brief xorshift state (never 0) */
+    unsigned long long s;
+} PRNG;
+
+/**
+ *  \brief Seeding of a generator.
+ *
+ *  \param r pointer to the generator
+ *  \param seed run seed
+ *  \param stream stream number
+ */
+extern void prngSeed (PRNG *r, unsigned long long seed, unsigned int stream);
+
+/**
+ *  \brief Next 64 bit number.
+ *
+ *  \param r pointer to the generator
+ *
+ *  \return pseudo random number
+ */
+extern unsigned long long prngNext (PRNG *r);
+
+/**
+ *  \brief Uniform sample in [0, 1).
+ *
+ *  \param r pointer to the generator
+ */
+extern double prngUniform (PRNG *r);
+
+/**
+ *  \brief Exponential sample.
+ *
+ *  \param r pointer to the generator
+ *  \param mean mean of the distribution
+ */
+extern double prngExp (PRNG *r, double mean);
+
+/**
+ *  \brief Normal sample with zero mean (Box-Muller).
+ *
+ *  \param r pointer to the generator
+ *  \param stddev standard deviation of the distribution
+ */
+extern double prngNormal (PRNG *r, double stddev);
+
+#endif /* PRNG_H_ */
@@ -13,18 +13,60 @@
 
 /* Generic parameters */
 
-/** \brief maximum number of groups */
-#define  MAXGROUPS       16 
-/** \brief number of tables */
-#define  NUMTABLES        2 
+/** \brief maximum number of groups (entity index range) */
+#define  MAXGROUPS     4095
+/** \brief number of tables when the configuration file does not set it */
+#define  DEFTABLES        2 
+/** \brief number of seats of a table when the configuration file does not set them */
+#define  DEFCAPACITY      4
 /** \brief controls time taken to cook */
 #define  MAXCOOK        100
+/** \brief size of a cache line (bytes); fields written by different entities never share one */
+#define  CACHELINE       64
+/** \brief maximum number of requests served by a waiter in a single wake up (batched dispatch) */
+#define  WAITERBATCH     32
 
 /** \brief controls start time standard deviation */
 #define  STARTDEV         4 
 /** \brief controls eat time standard deviation */
 #define  EATDEV           4 
 
+/* Lock domains of the shared state (index of the domain sequence counter) */
+
+/** \brief reception domain: receptionist state, groups waiting and assigned tables */
+#define  DOM_RECEPTION     0
+/** \brief kitchen domain: waiter and chef states and food order */
+#define  DOM_KITCHEN       1
+/** \brief group domain: state of group g */
+#define  DOM_GROUP(g)      (2+(g))
+
+/** \brief text log: each state is formatted and written by the entity itself */
+#define  LOGTEXT           0
+/** \brief buffered log: states are copied to a shared buffer and written by a drainer */
+#define  LOGBUFFERED       1
+/** \brief binary trace: each record holds only the fields changed since the previous one */
+#define  LOGBINARY         2
+/** \brief memory mapped log: each entity formats its state in place, in a preallocated and mapped log file */
+#define  LOGMAPPED         3
+/** \brief delta log: unchanged entity state columns are written as "." (as done by filter_log.awk) */
+#define  LOGDELTA          4
+
+/** \brief logging level (LOGLEVEL, set by the LOG variable of the Makefile): no log record at all */
+#define  LOGLEVEL_NONE     0
+/** \brief logging level: aggregates of the states saved, written at the end of each run */
+#define  LOGLEVEL_SUMMARY  1
+/** \brief logging level: a log record per state transition (default) */
+#define  LOGLEVEL_FULL     2
+/** \brief number of states of an entity counted by the summary logging level (group states are 1 .. 7) */
+#define  LOGSTATES         8
+
+/** \brief number of state snapshots held by the shared log buffer (power of 2) */
+#define  LOGSLOTS      1024
+/** \brief size of the stdio buffer used by the log drainer (bytes) */
+#define  LOGCHUNK     65536
+/** \brief initial room for records of the memory mapped log file (bytes; doubled whenever it is full) */
+#define  LOGMAPINIT (1 << 20)
+
 /** \brief id of table request (group->receptionist) */
 #define TABLEREQ   1
 /** \brief id of bill request (group->receptionist) */
@@ -34,6 +76,161 @@
 /** \brief id of food ready (chef->waiter) */
 #define FOODREADY 4
 
+/* Entity identification (logging) */
+
+/** \brief entity id composed of entity kind and index */
+#define  ENTITYID(kind,idx)   (((kind) << 12) | (idx))
+/** \brief entity kind of an entity id */
+#define  ENTITYKIND(id)       ((id) >> 12)
+/** \brief entity index of an entity id */
+#define  ENTITYIDX(id)        ((id) & 0xFFF)
+
+/** \brief entity kind of generator */
+#define  ENT_GENERATOR     0
+/** \brief entity kind of groups */
+#define  ENT_GROUP         1
+/** \brief entity kind of waiter */
+#define  ENT_WAITER        2
+/** \brief entity kind of chef */
+#define  ENT_CHEF          3
+/** \brief entity kind of receptionist */
+#define  ENT_RECEPTIONIST  4
+
+/* Latency instrumentation points (see latency.h) */
+
+/** \brief number of linear sub-buckets per power of two of the latency histograms */
+#define  LATSUB            16
+/** \brief number of buckets of a latency histogram (latencies below 2^41 ns) */
+#define  LATBUCKETS        (LATSUB * 38)
+
+/** \brief group waits for a free receptionist queue slot */
+#define  LAT_RECEPTIONISTREQUESTPOSSIBLE  0
+/** \brief group waits for a table */
+#define  LAT_WAITFORTABLE                 1
+/** \brief group or chef waits for a free waiter queue slot */
+#define  LAT_WAITERREQUESTPOSSIBLE        2
+/** \brief group waits for food */
+#define  LAT_FOODARRIVED                  3
+/** \brief group waits for payment completed */
+#define  LAT_TABLEDONE                    4
+/** \brief receptionist waits for a request */
+#define  LAT_RECEPTIONISTREQ              5
+/** \brief waiter waits for a request */
+#define  LAT_WAITERREQUEST                6
+/** \brief chef waits for an order */
+#define  LAT_WAITORDER                    7
+/** \brief waiter waits for a free order queue slot */
+#define  LAT_ORDERREQUESTPOSSIBLE         8
+/** \brief entity waits for a group domain lock */
+#define  LAT_GROUPLOCK                    9
+/** \brief entity waits for the reception domain lock */
+#define  LAT_RECEPTIONLOCK               10
+/** \brief entity waits for the kitchen domain lock */
+#define  LAT_KITCHENLOCK                 11
+/** \brief lock held by checkInAtReception */
+#define  LAT_HOLD_CHECKIN                12
+/** \brief lock held by orderFood */
+#define  LAT_HOLD_ORDERFOOD              13
+/** \brief lock held by waitFood */
+#define  LAT_HOLD_WAITFOOD               14
+/** \brief lock held by checkOutAtReception */
+#define  LAT_HOLD_CHECKOUT               15
+/** \brief lock held by waitForClientOrChef */
+#define  LAT_HOLD_WAITFORCLIENT          16
+/** \brief lock held by informChef */
+#define  LAT_HOLD_INFORMCHEF             17
+/** \brief lock held by takeFoodToTable */
+#define  LAT_HOLD_TAKEFOOD               18
+/** \brief lock held by waitForOrder */
+#define  LAT_HOLD_WAITFORORDER           19
+/** \brief lock held by processOrder */
+#define  LAT_HOLD_PROCESSORDER           20
+/** \brief lock held by waitForGroup */
+#define  LAT_HOLD_WAITFORGROUP           21
+/** \brief lock held by provideTableOrWaitingRoom */
+#define  LAT_HOLD_PROVIDETABLE           22
+/** \brief lock held by receivePayment */
+#define  LAT_HOLD_RECEIVEPAYMENT         23
+/** \brief depth of the order queue seen by each new order */
+#define  LAT_DEPTH_ORDER                 24
+/** \brief depth of the waiter request queue seen by each new request */
+#define  LAT_DEPTH_WAITER                25
+/** \brief depth of the ready queue seen by each dish put in it (pipelined kitchen) */
+#define  LAT_DEPTH_READY                 26
+/** \brief first queue depth point: the points from it on record queue depths, not latencies */
+#define  LAT_DEPTHPOINTS                 LAT_DEPTH_ORDER
+/** \brief number of instrumentation points */
+#define  LATPOINTS                       27
+/** \brief no instrumentation point */
+#define  LAT_NONE                        LATPOINTS
+
+/* Replay engine (see replay.h) */
+
+/** \brief nothing is recorded or replayed */
+#define  REPLAY_OFF         0
+/** \brief the order of the semaphore grants and of the other races is recorded */
+#define  REPLAY_RECORD      1
+/** \brief a recorded order is enforced */
+#define  REPLAY_PLAY        2
+/** \brief room for the events of a group and of its share of the other entities, in a run (record mode) */
+#define  REPLAYPERGROUP   256
+/** \brief largest number of events of a trace */
+#define  REPLAYMAXEVENTS  (1 << 24)
+
+/* Profiling spans (see profile.h) */
+
+/** \brief group goes to the restaurant */
+#define  PROF_GOTORESTAURANT    0
+/** \brief group checks in at the reception */
+#define  PROF_CHECKIN           1
+/** \brief group orders food */
+#define  PROF_ORDERFOOD         2
+/** \brief group waits for food */
+#define  PROF_WAITFOOD          3
+/** \brief group eats */
+#define  PROF_EAT               4
+/** \brief group checks out at the reception */
+#define  PROF_CHECKOUT          5
+/** \brief waiter waits for requests */
+#define  PROF_WAITFORCLIENT     6
+/** \brief waiter takes food orders to the chefs */
+#define  PROF_INFORMCHEF        7
+/** \brief waiter takes food to tables */
+#define  PROF_TAKEFOOD          8
+/** \brief chef waits for an order */
+#define  PROF_WAITFORORDER      9
+/** \brief chef cooks an order */
+#define  PROF_PROCESSORDER     10
+/** \brief receptionist waits for requests */
+#define  PROF_WAITFORGROUP     11
+/** \brief receptionist provides a table or the waiting room */
+#define  PROF_PROVIDETABLE     12
+/** \brief receptionist receives a payment */
+#define  PROF_RECEIVEPAYMENT   13
+/** \brief receptionist serves a burst of requests (event loop) */
+#define  PROF_SERVEREQUESTS    14
+/** \brief number of profiling spans */
+#define  PROFSPANS             15
+/** \brief room for the spans of a group and of its share of the other entities, in a run */
+#define  PROFPERGROUP          32
+/** \brief largest number of spans kept */
+#define  PROFMAXSPANS     (1 << 22)
+
+/* Live counters (see liveStats.h) */
+
+/** \brief requests served by the receptionist */
+#define  LIVE_RECEPTION     0
+/** \brief requests served by the waiters */
+#define  LIVE_WAITER        1
+/** \brief orders cooked by the chefs */
+#define  LIVE_CHEF          2
+/** \brief tables occupied */
+#define  LIVE_TABLES        3
+/** \brief groups that left the restaurant */
+#define  LIVE_LEFT          4
+/** \brief number of live counters */
+#define  LIVECOUNTERS       5
+
 /* Client state constants */
 
 /** \brief group initial state */
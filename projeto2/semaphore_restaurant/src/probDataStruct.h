@@ -17,6 +17,15 @@
 
 #include "probConst.h"
 
+/** \brief address of the array located at byte offset <tt>off</tt> from structure <tt>base</tt> */
+#define  SHARRAY(base,off,type)   ((type *) ((char *) (base) + (off)))
+
+/** \brief size <tt>n</tt> rounded up to a whole number of cache lines */
+#define  ALIGNCL(n)               (((n) + CACHELINE - 1) & ~(size_t) (CACHELINE - 1))
+
+/** \brief a field that starts a cache line of its own (the next field starts another one) */
+#define  CACHEALIGNED             __attribute__ ((aligned (CACHELINE)))
+
 /**
  *  \brief Definition of requests to receptionist and waiter 
  */
@@ -27,57 +36,389 @@ typedef struct {
     int reqGroup;
 } request;
 
+/**
+ *  \brief Definition of a slot of a request queue.
+ */
+typedef struct {
+    /** \brief slot sequence number (slot is full when equal to ticket+1) */
+    unsigned int seq;
+    /** \brief request stored in the slot */
+    request req;
+} REQ_SLOT;
+
+/**
+ *  \brief Definition of a bounded request queue (many producers, many consumers).
+ *
+ *  The slots are located outside the structure, at byte offset <tt>offSlot</tt> from it. Producers and consumers
+ *  do not share the cache line of their ticket counter.
+ */
+typedef struct {
+    /** \brief number of slots */
+    unsigned int size;
+    /** \brief offset of the request slots */
+    unsigned int offSlot;
+    /** \brief next ticket to be taken by a producer (cache line of its own) */
+    unsigned int head CACHEALIGNED;
+    /** \brief next ticket to be taken by a consumer (cache line of its own) */
+    unsigned int tail CACHEALIGNED;
+} REQ_QUEUE;
+
 
 /**
  *  \brief Definition of <em>state of the intervening entities</em> data type.
+ *
+ *  The state of the groups is kept in an array of FULL_STAT (see GROUPSTAT). Each entity state sits on a cache line
+ *  of its own.
  */
 typedef struct {
-    /** \brief receptionist state */
-    unsigned int receptionistStat;
-    /** \brief waiter state */
-    unsigned int waiterStat;
-    /** \brief chef state */
-    unsigned int chefStat;
-    /** \brief group state array */
-    unsigned int groupStat[MAXGROUPS];
+    /** \brief receptionist state (cache line of its own) */
+    unsigned int receptionistStat CACHEALIGNED;
+    /** \brief waiter state (cache line of its own) */
+    unsigned int waiterStat CACHEALIGNED;
+    /** \brief chef state (cache line of its own) */
+    unsigned int chefStat CACHEALIGNED;
 
 } STAT;
 
 
 /**
  *  \brief Definition of <em>full state of the problem</em> data type.
+ *
+ *  Arrays sized by the number of groups or tables are located outside the structure, at the byte offsets kept in
+ *  it, so that their size is only known at run time. They are accessed through GROUPSTAT, DOMSEQ, STARTTIME,
+ *  EATTIME, GROUPSIZE, TABLECAP and ASSIGNEDTABLE. Snapshots used for logging only hold the state of the groups and
+ *  the assigned tables.
+ *
+ *  The fields that are only read after the initialization fill the first cache line; each field, or set of fields,
+ *  written by a different entity or lock domain starts a line of its own. In the shared region the state of group g
+ *  and the sequence counter of its domain share a line, which is not shared with any other group (<tt>stride</tt> is
+ *  the size of a line); the start and eat times, the group sizes and the table capacities are in a read only area.
  */
 typedef struct
-{   /** \brief state of all intervening entities */
-    STAT st;
-
-    /** \brief number of groups */
+{   /** \brief number of groups */
     int nGroups;
-    /** \brief number of groups waiting for table */
-    int groupsWaiting;
+    /** \brief number of tables */
+    int nTables;
+    /** \brief number of waiters */
+    int nWaiters;
+    /** \brief number of chefs */
+    int nChefs;
 
-    /** \brief estimated start time of groups */
-    int startTime[MAXGROUPS];
-    /** \brief estimated eat time of groups */
-    int eatTime[MAXGROUPS];
+    /** \brief offset of group state array */
+    unsigned int offGroupStat;
+    /** \brief offset of sequence counter of each lock domain (2+nGroups, odd while the domain is being updated) */
+    unsigned int offSeq;
+    /** \brief distance between the states of consecutive groups and the counters of consecutive domains (bytes) */
+    unsigned int stride;
+    /** \brief offset of estimated start time of groups */
+    unsigned int offStartTime;
+    /** \brief offset of estimated eat time of groups */
+    unsigned int offEatTime;
+    /** \brief offset of the number of people of each group */
+    unsigned int offGroupSize;
+    /** \brief offset of the number of seats of each table */
+    unsigned int offTableCap;
+    /** \brief offset of the table that is being used by each group */
+    unsigned int offAssignedTable;
 
-    /** \brief saves the table that is being used by each group */
-    int assignedTable[MAXGROUPS];
+    /** \brief state of all intervening entities */
+    STAT st;
+
+    /** \brief number of groups waiting for table (cache line of its own) */
+    int groupsWaiting CACHEALIGNED;
 
-    /** \brief flag of food request from waiter to chef */
-    int foodOrder;
-    /** \brief group associated to food request from waiter to chef */
-    int foodGroup;
+    /** \brief number of requests claimed by the waiters (each waiter claims a request before waiting for it; in
+        batched dispatch, number of requests served) */
+    int waiterClaims CACHEALIGNED;
+    /** \brief number of orders claimed by the chefs (each chef claims an order before waiting for it) */
+    int chefClaims CACHEALIGNED;
 
+    /** \brief used by groups to queue requests to receptionist */
+    REQ_QUEUE receptionistRequest;
 
-    /** \brief used by groups to store request to receptionist */
-    request receptionistRequest;
+    /** \brief used by groups and chefs to queue requests to waiters */
+    REQ_QUEUE waiterRequest;
 
-    /** \brief used by groups and chef to store request to waiter */
-    request waiterRequest;
+    /** \brief used by waiters to queue food orders to chefs */
+    REQ_QUEUE orderRequest;
 
+    /** \brief used by chefs to queue the dishes they finish to waiters (pipelined kitchen) */
+    REQ_QUEUE readyRequest;
 
 } FULL_STAT;
 
+/** \brief state of group g */
+#define  GROUPSTAT(p,g)      (*SHARRAY(p, (p)->offGroupStat + (g) * (p)->stride, unsigned int))
+/** \brief sequence counter of lock domain d */
+#define  DOMSEQ(p,d)         (*SHARRAY(p, (p)->offSeq + (d) * (p)->stride, unsigned int))
+/** \brief estimated start time of groups */
+#define  STARTTIME(p)        SHARRAY(p, (p)->offStartTime, int)
+/** \brief estimated eat time of groups */
+#define  EATTIME(p)          SHARRAY(p, (p)->offEatTime, int)
+/** \brief number of people of each group */
+#define  GROUPSIZE(p)        SHARRAY(p, (p)->offGroupSize, int)
+/** \brief number of seats of each table */
+#define  TABLECAP(p)         SHARRAY(p, (p)->offTableCap, int)
+/** \brief table that is being used by each group */
+#define  ASSIGNEDTABLE(p)    SHARRAY(p, (p)->offAssignedTable, int)
+
+/**
+ *  \brief Definition of a slot of the shared log buffer.
+ *
+ *  The snapshot arrays follow the structure.
+ */
+typedef struct {
+    /** \brief slot sequence number (slot is full when equal to ticket+1) */
+    unsigned int seq;
+    /** \brief snapshot of the full state */
+    FULL_STAT fSt;
+} LOG_SLOT;
+
+/**
+ *  \brief Definition of the shared log buffer.
+ *
+ *  Ring of state snapshots filled by the entities and emptied by the log drainer.
+ */
+typedef struct {
+    /** \brief no more snapshots will be produced */
+    bool closed;
+    /** \brief size of a slot in bytes (snapshot arrays included) */
+    unsigned int stride;
+    /** \brief offset of the LOGSLOTS slots from the logging control data */
+    unsigned int offSlot;
+    /** \brief next ticket to be taken by a producer (cache line of its own) */
+    unsigned int head CACHEALIGNED;
+    /** \brief next ticket to be written by the drainer (cache line of its own) */
+    unsigned int tail CACHEALIGNED;
+} LOG_BUFFER;
+
+/**
+ *  \brief Definition of the shared binary trace state.
+ */
+typedef struct {
+    /** \brief start of the trace (monotonic clock, in ns) */
+    unsigned long long t0;
+    /** \brief offset of the last traced state (records only carry the fields that differ from it; also used by
+               the delta log) */
+    unsigned int offLast;
+} LOG_TRACE;
+
+/**
+ *  \brief Definition of the shared memory mapped log state.
+ */
+typedef struct {
+    /** \brief end of the records written so far (byte offset in the log file; cache line of its own) */
+    unsigned long long off CACHEALIGNED;
+    /** \brief size of the preallocated log file (bytes) */
+    unsigned long long size;
+} LOG_MAP;
+
+/**
+ *  \brief Definition of the shared logging control data.
+ *
+ *  The log buffer slots and the last traced state are located after the structure (see logSize).
+ */
+typedef struct {
+    /** \brief logging mode (LOGTEXT, LOGBUFFERED, LOGBINARY, LOGMAPPED or LOGDELTA) */
+    unsigned int mode;
+    /** \brief buffer of state snapshots waiting to be logged */
+    LOG_BUFFER buf;
+    /** \brief binary trace state */
+    LOG_TRACE trace;
+    /** \brief memory mapped log state */
+    LOG_MAP map;
+    /** \brief records are written in the order of their tickets (false if callers of saveState already exclude
+               each other) */
+    bool ordered;
+    /** \brief next record ticket to be taken (cache line of its own) */
+    int ticket CACHEALIGNED;
+    /** \brief ticket of the record whose turn it is to be written (cache line of its own) */
+    int turn CACHEALIGNED;
+    /** \brief number of states saved by each entity kind in each of its states (summary logging level; a cache line
+               per entity kind) */
+    unsigned long long saved[ENT_RECEPTIONIST+1][LOGSTATES] CACHEALIGNED;
+    /** \brief largest number of groups waiting for a table in the states saved (summary logging level; cache line of
+               its own) */
+    int maxGroupsWaiting CACHEALIGNED;
+} LOG_SHARED;
+
+/**
+ *  \brief Definition of the simulation clock.
+ *
+ *  In virtual time mode the wake up time of each entity that is sleeping is kept in an array located after
+ *  the structure, at byte offset <tt>offWake</tt> from it (see clockSize).
+ */
+typedef struct {
+    /** \brief virtual time mode */
+    bool virtualTime;
+    /** \brief semaphore set used by the entities */
+    int semgid;
+    /** \brief start of the simulation (monotonic clock, in ns) */
+    unsigned long long t0;
+    /** \brief number of entity slots */
+    int nSlots;
+    /** \brief offset of the wake up time of each entity slot */
+    unsigned int offWake;
+    /** \brief present virtual time (in us; the fields that change start a cache line) */
+    unsigned long long now CACHEALIGNED;
+    /** \brief incremented when virtual time advances (futex word) */
+    int tick;
+    /** \brief incremented whenever an entity starts sleeping or terminates */
+    unsigned int epoch;
+    /** \brief number of entities that did not terminate yet */
+    int live;
+    /** \brief next entity slot to be taken */
+    int nextSlot;
+} SIM_CLOCK;
+
+/**
+ *  \brief Definition of the latency histogram of an instrumentation point.
+ *
+ *  Bucket i counts the latencies v (in ns) with i == v, for v < 2*LATSUB, and otherwise with
+ *  (2^e)*(LATSUB+s)/LATSUB <= v < (2^e)*(LATSUB+s+1)/LATSUB, where i == (e-3)*LATSUB + s (see latency.c).
+ */
+typedef struct {
+    /** \brief number of recorded latencies (histograms do not share cache lines) */
+    unsigned long long count CACHEALIGNED;
+    /** \brief sum of the recorded latencies (in ns) */
+    unsigned long long sum;
+    /** \brief largest recorded latency (in ns) */
+    unsigned long long max;
+    /** \brief number of latencies in each bucket */
+    unsigned long long bucket[LATBUCKETS];
+} LAT_HIST;
+
+/**
+ *  \brief Definition of the latency instrumentation data.
+ *
+ *  The LATPOINTS histograms are located after the structure, at byte offset <tt>offHist</tt> from it
+ *  (see latSize).
+ */
+typedef struct {
+    /** \brief offset of the histogram of each instrumentation point */
+    unsigned int offHist;
+} LAT_SHARED;
+
+/**
+ *  \brief Definition of a live counter.
+ */
+typedef struct {
+    /** \brief value (cache line of its own) */
+    long long val CACHEALIGNED;
+} LIVE_COUNTER;
+
+/**
+ *  \brief Definition of the live counters of the simulation (see liveStats.h).
+ */
+typedef struct {
+    /** \brief counters, indexed by counter id (LIVE_RECEPTION .. LIVE_LEFT) */
+    LIVE_COUNTER counter[LIVECOUNTERS];
+} LIVE_STATS;
+
+/**
+ *  \brief Definition of an event of the replay engine: a semaphore grant or the outcome of another race.
+ */
+typedef struct {
+    /** \brief entity slot of the entity the event took place at (see replay.c) */
+    unsigned int who;
+    /** \brief kind of event (bits 24 and up) and object it took place on (low 24 bits) */
+    unsigned int what;
+    /** \brief outcome of the event (ticket, counter value, success flag or virtual time) */
+    long long value;
+} REPLAY_EVENT;
+
+/**
+ *  \brief Definition of the control data of the replay engine (see replay.h).
+ *
+ *  The events are located after the structure, at byte offset <tt>offEvent</tt> from it (see replaySize).
+ */
+typedef struct {
+    /** \brief REPLAY_OFF, REPLAY_RECORD or REPLAY_PLAY */
+    unsigned int mode;
+    /** \brief lock that serializes the recording (record mode) */
+    unsigned int lock;
+    /** \brief turn semaphore of entity slot 0, the other ones follow it (replay mode) */
+    unsigned int turn;
+    /** \brief number of entity slots */
+    int nSlots;
+    /** \brief number of waiters (slot mapping) */
+    int nWaiters;
+    /** \brief number of chefs (slot mapping) */
+    int nChefs;
+    /** \brief room for events */
+    unsigned int capacity;
+    /** \brief offset of the events */
+    unsigned int offEvent;
+    /** \brief number of events recorded, or to be replayed (cache line of its own) */
+    unsigned int nEvents CACHEALIGNED;
+    /** \brief the trace was full and some events were not recorded */
+    bool overflow;
+    /** \brief next event to be replayed (cache line of its own) */
+    unsigned int next CACHEALIGNED;
+} REPLAY_SHARED;
+
+/**
+ *  \brief Definition of a profiling span: a call of a life cycle operation by an entity (see profile.h).
+ *
+ *  It takes a cache line, so that entities that store spans at the same time do not share one.
+ */
+typedef struct {
+    /** \brief entity id (see ENTITYID) */
+    unsigned int who CACHEALIGNED;
+    /** \brief profiling span (see PROFSPANS) */
+    unsigned int span;
+    /** \brief run (0 .. runs - 1) */
+    unsigned int run;
+    /** \brief voluntary context switches (the entity blocked) */
+    unsigned int nvcsw;
+    /** \brief involuntary context switches (the entity was preempted) */
+    unsigned int nivcsw;
+    /** \brief start (monotonic clock, in ns) */
+    unsigned long long start;
+    /** \brief elapsed time (in ns) */
+    unsigned long long wall;
+    /** \brief time spent in user mode (in ns) */
+    unsigned long long user;
+    /** \brief time spent in system calls (in ns) */
+    unsigned long long sys;
+} PROF_SPAN;
+
+/**
+ *  \brief Definition of the profiling data (see profile.h).
+ *
+ *  The spans are located after the structure, at byte offset <tt>offSpan</tt> from it (see profSize).
+ */
+typedef struct {
+    /** \brief room for spans (0 if the entities are not profiled) */
+    unsigned int capacity;
+    /** \brief offset of the spans */
+    unsigned int offSpan;
+    /** \brief number of waiters */
+    int nWaiters;
+    /** \brief number of chefs */
+    int nChefs;
+    /** \brief number of groups */
+    int nGroups;
+    /** \brief number of runs */
+    unsigned int runs;
+    /** \brief number of spans taken, some of them not kept if above capacity (cache line of its own) */
+    unsigned int nSpans CACHEALIGNED;
+} PROF_SHARED;
+
+/**
+ *  \brief Definition of the control data of the runs (server mode).
+ */
+typedef struct {
+    /** \brief number of runs */
+    unsigned int runs;
+    /** \brief number of entities */
+    int nEntities;
+    /** \brief name of the logging file of the present run */
+    char logName[51];
+    /** \brief present run (futex word; cache line of its own) */
+    int run CACHEALIGNED;
+    /** \brief number of entities that finished the present run (futex word; cache line of its own) */
+    int done CACHEALIGNED;
+} RUN_CONTROL;
 
 #endif /* PROBDATASTRUCT_H_ */
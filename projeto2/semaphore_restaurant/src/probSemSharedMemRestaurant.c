@@ -7,22 +7,90 @@
  *  Implementation with SVIPC.
  *
  *  Generator process of the intervening entities.
+ *  Entities are processes; in the binary built by the <tt>threads</tt> target of the Makefile they are threads
+ *  of the generator instead (see launcher.h).
  *
  *  Upon execution, one parameter is requested:
  *    \li name of the logging file.
  *
+ *  The number of groups, their start and eat times and, optionally, the number of tables (DEFTABLES if
+ *  absent), their seats and the number of people of each group are read from config.txt; the shared region is
+ *  sized accordingly (see config.h). Instead of the number of groups, their times and their sizes, config.txt may
+ *  have a line <tt>#workload</tt> followed by a workload specification, from which they are generated (see
+ *  workload.h). It may also be a binary schedule made by schedCompiler.
+ *
+ *  Each group sits at a table of its own: the receptionist gives it the vacant table with the fewest seats that
+ *  holds it (best fit).
+ *
+ *  Options:
+ *    \li -b buffered logging: entities copy their state into a shared buffer, emptied by a drainer process
+ *    \li -t binary trace: only the changed fields are logged, in binary form (see logDecoder)
+ *    \li -m memory mapped logging: entities write their state in place, in a preallocated and mapped logging file
+ *    \li -d delta logging: entity states that did not change since the previous line are written as "."
+ *    \li -q size number of slots of the receptionist and waiter request queues (default number of groups + 1)
+ *    \li -g global lock: every lock domain of the shared state is protected by the same mutex
+ *    \li -p pipelined kitchen: chefs put the dishes they finish in a ready queue of their own, that never fills up, so
+ *        that they never wait for the waiters
+ *    \li -D batched dispatch: a waiter that wakes up serves every request pending at the time (up to WAITERBATCH),
+ *        taking the dishes to their tables before taking the new orders to the chefs, all of them in a single trip
+ *    \li -a seating ahead: when the group that has been waiting for longer does not fit any vacant table, a group
+ *        that came later and fits one is seated (by default, groups are seated in arrival order)
+ *    \li -E event loop receptionist: a receptionist that wakes up takes every request pending at the time, frees the
+ *        tables of the check outs, seats the waiting groups and the new ones at once and only then wakes them up
+ *    \li -w number number of waiter processes (default 1)
+ *    \li -c number number of chef processes (default 1)
+ *    \li -k key access key to shared memory and semaphore set (default generated by ftok on the current directory)
+ *    \li -e prefix prefix of the names of the error files (default "error_"), which end with GR, WT, CH or RT and
+ *        the index of the entity, two digits (the index is left out when there is a single waiter or chef)
+ *    \li -s seed seed of the random numbers drawn by the entities (default the workload seed, if any, or drawn
+ *        from the clock); it heads the latency report (see -L)
+ *    \li -v virtual time: sleeps take no real time, the clock jumps to the next wake up time whenever every entity
+ *        is sleeping or blocked (futex semaphores only: the binaries built with make SEM=futex and the threads
+ *        binary; it is rejected before any resource is created otherwise, see simClock.h)
+ *    \li -f file configuration file (default config.txt)
+ *    \li -r number server mode: number of simulations run back to back by the same entities, on the same shared
+ *        region and semaphore set, reset in place between runs (default 1, see runControl.h); run r (1 .. number)
+ *        logs to the logging file name followed by ".r" and its entities use seed + r - 1
+ *    \li -R file record: the seed and the order of the semaphore grants and of the other races among the entities
+ *        are saved in a trace file (see replay.h)
+ *    \li -P file replay: the simulation recorded in a trace file is run again, with its seed and in its order; the
+ *        configuration and the other options must be the ones it was recorded with. With -v it takes no real time.
+ *    \li -T file profiling trace: every call of a life cycle operation by an entity is timed and its CPU times and
+ *        context switches sampled; the calls of every entity of every run are written as Chrome trace events, for a
+ *        timeline viewer (see profile.h)
+ *    \li -F file profiling folded stacks: the same calls are written as folded stacks of user, system and off CPU
+ *        time, for flamegraph.pl (-T and -F may be given together)
+ *    \li -L file latency report: when the simulation ends, the seed and the mean, median, 99th percentile and maximum
+ *        of the time spent blocked at each semaphore and of the time each lock is held, and the depths of the kitchen
+ *        queues, are written to a file (see latency.h); in server mode they cover every run
+ *
+ *  Options -k and -e allow simultaneous runs in the same directory (see batch.sh).
+ *
+ *  A replay repeats the states the entities go through, and hence their log records, but for the fields of other
+ *  lock domains a record may hold, which are copied while the simulation goes on: with -g every record is repeated.
+ *
+ *  While a run goes on, the generator checks the entities every SUPERVISEPERIOD ms: when one of them fails, or the
+ *  generator catches SIGINT, SIGTERM or SIGHUP, the simulation is aborted. Whatever the way the generator exits,
+ *  the remaining entities are terminated and the shared region and the semaphore set are destroyed. A region and a
+ *  semaphore set left over with the same key by a simulation whose processes were all killed are destroyed when
+ *  the next one starts.
+ *
  *  \author Nuno Lau - December 2023
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <sys/wait.h>
+#include <signal.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
 
 #include "probConst.h"
 #include "probDataStruct.h"
@@ -30,6 +98,16 @@
 #include "sharedDataSync.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "requestQueue.h"
+#include "launcher.h"
+#include "simClock.h"
+#include "latency.h"
+#include "liveStats.h"
+#include "workload.h"
+#include "config.h"
+#include "runControl.h"
+#include "replay.h"
+#include "profile.h"
 
 /** \brief name of chef process */
 #define   CHEF               "./chef"
@@ -42,6 +120,177 @@
 
 /** \brief name of chef process */
 #define   RECEPTIONIST       "./receptionist"
+
+/** \brief period of the checks of the entities by the generator while a run goes on (in ms) */
+#define   SUPERVISEPERIOD    100
+/** \brief logging file name of the present run (used by the log drainer) */
+static char nFic[51];
+
+/** \brief log drainer task */
+static void drainer (void *p_log)
+{
+    logDrain (nFic, p_log);
+}
+
+/** \brief clock task */
+static void ticker (void *p_sh)
+{
+    SHARED_DATA *sh = p_sh;
+
+    replayAttach (&sh->replay, sh->clock.semgid, ENTITYID(ENT_GENERATOR, 0));
+    clockRun (&sh->clock);
+}
+
+/** \brief identifiers of the shared region and the semaphore set to be destroyed at exit (-1 if none) */
+static int shmidAtExit = -1, semgidAtExit = -1;
+
+/** \brief process identifier of the generator (helper tasks are forked from it, with its exit handler) */
+static pid_t generator;
+
+/** \brief number of entities that terminated before the end of the last run */
+static unsigned int nEnded = 0;
+
+/** \brief termination signal caught (0 if none) */
+static volatile sig_atomic_t interrupted = 0;
+
+/** \brief catching of a termination signal */
+static void onSignal (int sig)
+{
+    interrupted = sig;
+}
+
+/**
+ *  \brief release of the simulation upon exit of the generator, whatever the cause
+ *
+ *  The entities still running are terminated and the shared region and the semaphore set are destroyed, so that
+ *  they do not prevent the next simulation with the same key from starting.
+ */
+static void cleanup (void)
+{
+    if (getpid () != generator) {                                                                   /* a helper task */
+        return;
+    }
+    if (killEntities () == -1) {                                 /* entities are threads: all goes with the process */
+        return;
+    }
+    if (semgidAtExit != -1) {
+        semDestroy (semgidAtExit);
+    }
+    if (shmidAtExit != -1) {
+        shmemDestroy (shmidAtExit);
+    }
+}
+
+/**
+ *  \brief checking of the entities while a run goes on
+ *
+ *  An entity that fails, or a termination signal, aborts the simulation: the generator exits and the remaining
+ *  entities are terminated by cleanup.
+ */
+static void supervise (void)
+{
+    int status, id;
+
+    while ((id = pollEntity (&status)) != -1) {
+        if (WIFSIGNALED (status)) {
+            fprintf (stderr, "Entity %d was killed by signal %d: the simulation is aborted!\n", id, WTERMSIG (status));
+            exit (EXIT_FAILURE);
+        }
+        if (WEXITSTATUS (status) != EXIT_SUCCESS) {
+            fprintf (stderr, "Entity %d failed with status %d: the simulation is aborted!\n", id, WEXITSTATUS (status));
+            exit (EXIT_FAILURE);
+        }
+        nEnded += 1;                                                 /* the last run of the entity is already over */
+    }
+    if ((errno != EAGAIN) && (errno != ECHILD)) {
+        perror ("error on checking the intervening entities");
+        exit (EXIT_FAILURE);
+    }
+    if (interrupted != 0) {
+        fprintf (stderr, "Signal %d caught: the simulation is aborted!\n", (int) interrupted);
+        exit (EXIT_FAILURE);
+    }
+}
+
+/** \brief setting of the variable part of the full state to its initial value */
+static void resetState (SHARED_DATA *sh)
+{
+    REQ_QUEUE *q[4] = { &sh->fSt.receptionistRequest, &sh->fSt.waiterRequest, &sh->fSt.orderRequest,
+                        &sh->fSt.readyRequest };
+    int g, i;
+
+    sh->fSt.st.chefStat         = WAIT_FOR_ORDER;                     /* the chef waits for an order */
+    sh->fSt.st.waiterStat       = WAIT_FOR_REQUEST;                /* the waiter waits for a request */
+    sh->fSt.st.receptionistStat = WAIT_FOR_REQUEST;          /* the receptionist waits for a request */
+    for (g = 0; g < sh->fSt.nGroups; g++) {
+        GROUPSTAT(&sh->fSt,g) = GOTOREST;                                  /* groups are initialized */
+        ASSIGNEDTABLE(&sh->fSt)[g] = -1;                                   /* groups are initialized */
+    }
+    sh->fSt.groupsWaiting = 0;
+    sh->fSt.waiterClaims = 0;
+    sh->fSt.chefClaims = 0;
+    liveInit (&sh->live);
+    for (g = 0; g < 2+sh->fSt.nGroups; g++) {
+        DOMSEQ(&sh->fSt,g) = 0;                                        /* no lock domain is being updated */
+    }
+    for (i = 0; i < 4; i++) {                                                        /* every request queue is empty */
+        queueInit (q[i], q[i]->size, SHARRAY(q[i], q[i]->offSlot, REQ_SLOT));
+    }
+}
+
+/**
+ *  \brief setting of the semaphores to their initial value
+ *
+ *  The locks are free, every request queue slot is free and no other semaphore has been signalled but, when
+ *  replaying, the turn of the entity of the next event.
+ */
+static void resetSemaphores (SHARED_DATA *sh, int semgid)
+{
+    unsigned int i;
+    int g;
+
+    for (i = 1; i <= SEM_NU; i++) {
+        if (semSet (semgid, i, 0) == -1) {
+            perror ("error on setting the value of a semaphore");
+            exit (EXIT_FAILURE);
+        }
+    }
+    if ((semSet (semgid, sh->mutex, 1) == -1) ||                          /* enabling access to critical region */
+        (semSet (semgid, sh->orderRequestPossible, sh->fSt.nGroups) == -1) ||   /* every order queue slot is free */
+        (semSet (semgid, sh->waiterRequestPossible, sh->fSt.waiterRequest.size) == -1) ||  /* and every request */
+        (semSet (semgid, sh->receptionistRequestPossible, sh->fSt.receptionistRequest.size) == -1)) {  /* slot */
+        perror ("error on setting the value of a semaphore");
+        exit (EXIT_FAILURE);
+    }
+    if (!sh->globalLock) {                                                       /* enabling access to lock domains */
+        if ((semSet (semgid, sh->receptionLock, 1) == -1) || (semSet (semgid, sh->kitchenLock, 1) == -1)) {
+            perror ("error on setting the value of a semaphore");
+            exit (EXIT_FAILURE);
+        }
+        for (g = 0; g < sh->fSt.nGroups; g++) {
+            if (semSet (semgid, GROUPLOCKSEM(g), 1) == -1) {
+                perror ("error on setting the value of a semaphore");
+                exit (EXIT_FAILURE);
+            }
+        }
+    }
+    if (replayReset (&sh->replay, semgid) == -1) {             /* the recording lock is free, or the turn is given */
+        perror ("error on setting the value of a semaphore");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/** \brief name of the logging file of run r (the name given, followed by the run number if there are several) */
+static void runLogName (char name[], char base[], unsigned int runs, unsigned int r)
+{
+    if ((runs > 1) && (strlen (base) > 0)) {
+        sprintf (name, "%s.%u", base, r + 1);
+    }
+    else {
+        strcpy (name, base);
+    }
+}
+
 /**
  *  \brief Main program.
  *
@@ -50,76 +299,346 @@
  */
 int main (int argc, char *argv[])
 {
-    char nFic[51];                                                                              /*name of logging file */
-    char nFicErr[] = "error_        ";                                                     /* base name of error files */
+    char nFicErr[51+8] = "error_";                                                         /* base name of error files */
+    int lErr;                                                                        /* length of error files prefix */
     int shmid,                                                                      /* shared memory access identifier */
         semgid;                                                                     /* semaphore set access identifier */
     unsigned int  m;                                                                             /* counting variables */
     SHARED_DATA *sh;                                                                /* pointer to shared memory region */
-    int pidCH,                                                                             /* pilot process identifier */
-        pidWT,                                                                     /* hostess process identifier array */
-        pidRT,                                                                     /* hostess process identifier array */
-        pidGR[MAXGROUPS];                                                     /* passengers processes identifier array */
-    int key;                                                           /*access key to shared memory and semaphore set */
+    int pidLG,                                                                       /* log drainer process identifier */
+        pidCK;                                                                             /* clock task identifier */
+    int key = -1;                                  /*access key to shared memory and semaphore set (-1 if from ftok) */
     char num[2][12];                                                     /* numeric value conversion (up to 10 digits) */
     int status,                                                                                    /* execution status */
         info;                                                                                               /* info id */
-    int g, t;
+    int g, w, c;
+    int nWaiters = 1, nChefs = 1;                                               /* number of waiters and chefs */
+    unsigned int logMode = LOGTEXT;                                                                  /* logging mode */
+    int opt;                                                                                          /* option code */
+    unsigned int qSize = 0;                                                 /* request queues size (0 if default) */
+    bool globalLock = false;                                                 /* single lock for all domains flag */
+    bool pipelined = false;                                                        /* pipelined kitchen flag */
+    bool batched = false;                                                        /* batched dispatch flag */
+    bool seatAhead = false;                                                          /* seating ahead flag */
+    bool eventLoop = false;                                                 /* event loop receptionist flag */
+    bool virtualTime = false;                                                             /* virtual time flag */
+    unsigned int se;                                                       /* semaphore set activity counter */
+    unsigned long long seed = 0;                                                         /* entities random seed */
+    bool seeded = false;                                                                /* seed given flag */
+    unsigned int runs = 1, r;                                                   /* number of runs and run number */
+    char nFicBase[51];                                                            /* logging file name as given */
+    char *nCfg = "config.txt";                                                                /* config file name */
+    char *nTrace = NULL;                                                        /* trace file name (NULL if none) */
+    unsigned int replayMode = REPLAY_OFF;                                                     /* replay engine mode */
+    unsigned long long capacity = 0;                                              /* room for events of the trace */
+    REPLAY_HEADER rh;                                                                          /* trace file header */
+    REPLAY_EVENT *rev = NULL;                                                                  /* events to replay */
+    char *nProfTrace = NULL;                                         /* profiling trace file name (NULL if none) */
+    char *nProfFolded = NULL;                                 /* profiling folded stacks file name (NULL if none) */
+    char *nLatReport = NULL;                                           /* latency report file name (NULL if none) */
+    FILE *fpLat;                                                                           /* latency report file */
+    unsigned long long spans = 0;                                               /* room for profiling spans */
+    CONFIG cf;                                                                                /* configuration */
+    char *tinp;                                                                /* numerical parameters test flag */
+    int nGroups, nTables;                                                          /* number of groups and tables */
+    size_t offLines, offGroupStat, offSeq, offStartTime, offEatTime, offGroupSize, offTableCap,  /* shared region layout */
+           offAssignedTable, offRecSlots, offWtSlots, offOrdSlots, offRdySlots, offLog, offClock, offLat, offReplay, offProf,
+           offSemWords,
+           size;
 
-    /* getting log file name */
-    if(argc==2) {
-        strcpy(nFic, argv[1]);
+    /* getting options and log file name */
+    while ((opt = getopt (argc, argv, "btmdq:gpDaEw:c:k:e:s:vr:f:R:P:T:F:L:")) != -1) {
+        switch (opt) {
+            case 'b':
+                logMode = LOGBUFFERED;
+                break;
+            case 't':
+                logMode = LOGBINARY;
+                break;
+            case 'm':
+                logMode = LOGMAPPED;
+                break;
+            case 'd':
+                logMode = LOGDELTA;
+                break;
+            case 'q':
+                qSize = (unsigned int) strtol (optarg, &tinp, 0);
+                if ((*tinp != '\0') || (qSize < 1)) {
+                    fprintf (stderr, "Request queue size must be positive!\n");
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'g':
+                globalLock = true;
+                break;
+            case 'p':
+                pipelined = true;
+                break;
+            case 'D':
+                batched = true;
+                break;
+            case 'a':
+                seatAhead = true;
+                break;
+            case 'E':
+                eventLoop = true;
+                break;
+            case 'w':
+                nWaiters = (int) strtol (optarg, &tinp, 0);
+                if ((*tinp != '\0') || (nWaiters < 1) || (nWaiters > MAXGROUPS)) {
+                    fprintf (stderr, "Number of waiters must be in 1 .. %d!\n", MAXGROUPS);
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'c':
+                nChefs = (int) strtol (optarg, &tinp, 0);
+                if ((*tinp != '\0') || (nChefs < 1) || (nChefs > MAXGROUPS)) {
+                    fprintf (stderr, "Number of chefs must be in 1 .. %d!\n", MAXGROUPS);
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'k':
+                key = (int) strtol (optarg, &tinp, 0);
+                if ((*tinp != '\0') || (key <= 0)) {
+                    fprintf (stderr, "Access key must be positive!\n");
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'e':
+                if (strlen (optarg) > 50) {
+                    fprintf (stderr, "Error files prefix is too long!\n");
+                    exit (EXIT_FAILURE);
+                }
+                strcpy (nFicErr, optarg);
+                break;
+            case 's':
+                seed = strtoull (optarg, &tinp, 0);
+                if (*tinp != '\0') {
+                    fprintf (stderr, "Seed must be a number!\n");
+                    exit (EXIT_FAILURE);
+                }
+                seeded = true;
+                break;
+            case 'v':
+                if ((semEpoch (-1, &se) == -1) && (errno == ENOSYS)) {       /* SVIPC, told apart with no set */
+                    fprintf (stderr, "Virtual time needs the futex semaphores (make SEM=futex)!\n");
+                    exit (EXIT_FAILURE);
+                }
+                virtualTime = true;
+                break;
+            case 'r':
+                runs = (unsigned int) strtoul (optarg, &tinp, 0);
+                if ((*tinp != '\0') || (runs < 1) || (runs > 9999)) {
+                    fprintf (stderr, "Number of runs must be in 1 .. 9999!\n");
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'f':
+                nCfg = optarg;
+                break;
+            case 'R':
+            case 'P':
+                if (replayMode != REPLAY_OFF) {
+                    fprintf (stderr, "Only one trace file may be recorded or replayed!\n");
+                    exit (EXIT_FAILURE);
+                }
+                replayMode = (opt == 'R') ? REPLAY_RECORD : REPLAY_PLAY;
+                nTrace = optarg;
+                break;
+            case 'T':
+                nProfTrace = optarg;
+                break;
+            case 'F':
+                nProfFolded = optarg;
+                break;
+            case 'L':
+                nLatReport = optarg;
+                break;
+            default:
+                fprintf (stderr, "USAGE: %s [-b | -t | -m | -d] [-q size] [-g] [-p] [-D] [-a] [-E] [-w waiters] [-c chefs] [-k key] [-e prefix] [-s seed] [-v] [-r runs] [-f config] [-R trace | -P trace] [-T trace] [-F folded] [-L report] [logfile]\n",
+                         argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if(optind==argc-1) {
+        if (strlen (argv[optind]) > ((runs > 1) ? 45 : 50)) {                      /* room for the run number */
+            fprintf (stderr, "Logging file name is too long!\n");
+            exit (EXIT_FAILURE);
+        }
+        strcpy(nFicBase, argv[optind]);
+    }
+    else strcpy(nFicBase, "");
+    runLogName (nFic, nFicBase, runs, 0);
+    if ((logMode == LOGMAPPED) && (strlen (nFic) == 0)) {
+        fprintf (stderr, "Memory mapped logging needs a logging file!\n");
+        exit (EXIT_FAILURE);
     }
-    else strcpy(nFic, "");
 
     /* composing command line */
-    if ((key = ftok (".", 'a')) == -1) {
+    if ((key == -1) && ((key = ftok (".", 'a')) == -1)) {
         perror ("error on generating the key");
         exit (EXIT_FAILURE);
     }
     sprintf (num[1], "%d", key);
 
-    /* creating and initializing the shared memory region and the log file */
-    if ((shmid = shmemCreate (key, sizeof (SHARED_DATA))) == -1) { 
+    /* loading of the configuration */
+    if (configLoad (nCfg, &cf) == -1) {
+        exit (EXIT_FAILURE);
+    }
+    nGroups = cf.nGroups;
+    nTables = cf.nTables;
+    if (qSize == 0) {
+        qSize = nGroups + 1;                                    /* room for every group and the chef at the same time */
+    }
+
+    /* loading of the trace to be replayed, that sets the seed, or room for the trace to be recorded */
+    if (replayMode == REPLAY_PLAY) {
+        if (seeded) {
+            fprintf (stderr, "The seed of a replay is the one of its trace!\n");
+            exit (EXIT_FAILURE);
+        }
+        if (replayLoad (nTrace, &rh, &rev) == -1) {
+            exit (EXIT_FAILURE);
+        }
+        if ((rh.nGroups != nGroups) || (rh.nTables != nTables) || (rh.nWaiters != nWaiters) ||
+            (rh.nChefs != nChefs) || (rh.runs != runs)) {
+            fprintf (stderr, "%s: recorded with %d groups, %d tables, %d waiters, %d chefs and %u runs!\n", nTrace,
+                     rh.nGroups, rh.nTables, rh.nWaiters, rh.nChefs, rh.runs);
+            exit (EXIT_FAILURE);
+        }
+        seed = rh.seed;
+        seeded = true;
+        capacity = rh.nEvents;
+    }
+    else if (replayMode == REPLAY_RECORD) {
+        capacity = (unsigned long long) REPLAYPERGROUP * nGroups * runs;
+        if (capacity > REPLAYMAXEVENTS) {
+            capacity = REPLAYMAXEVENTS;
+        }
+    }
+
+    /* room for the profiling spans */
+    if ((nProfTrace != NULL) || (nProfFolded != NULL)) {
+        spans = (unsigned long long) PROFPERGROUP * nGroups * runs;
+        if (spans > PROFMAXSPANS) {
+            spans = PROFMAXSPANS;
+        }
+    }
+
+    /* layout of the shared region: header, one cache line per lock domain (word 0 holds the state of the group of
+       a group domain, word 1 the sequence counter), read only start and eat times, group sizes and table seats,
+       assigned tables, request queue slots, log area, clock area, latency histograms, replay events, profiling
+       spans, semaphore storage; every area starts a cache line */
+    offLines         = ALIGNCL(sizeof (SHARED_DATA));
+    offGroupStat     = offLines + DOM_GROUP(0) * CACHELINE;
+    offSeq           = offLines + sizeof (unsigned int);
+    offStartTime     = offLines + (2 + nGroups) * CACHELINE;
+    offEatTime       = offStartTime + ALIGNCL(nGroups * sizeof (int));
+    offGroupSize     = offEatTime + ALIGNCL(nGroups * sizeof (int));
+    offTableCap      = offGroupSize + ALIGNCL(nGroups * sizeof (int));
+    offAssignedTable = offTableCap + ALIGNCL(nTables * sizeof (int));
+    offRecSlots      = offAssignedTable + ALIGNCL(nGroups * sizeof (int));
+    offWtSlots       = offRecSlots + ALIGNCL(qSize * sizeof (REQ_SLOT));
+    offOrdSlots      = offWtSlots + ALIGNCL(qSize * sizeof (REQ_SLOT));
+    offRdySlots      = offOrdSlots + ALIGNCL(nGroups * sizeof (REQ_SLOT));
+    offLog           = offRdySlots + ALIGNCL(nGroups * sizeof (REQ_SLOT));
+    offClock         = offLog + logSize (nGroups);
+    offLat           = offClock + ALIGNCL(clockSize (1+nWaiters+nChefs+nGroups));
+    offReplay        = offLat + latSize ();
+    offProf          = offReplay + replaySize (capacity);
+    offSemWords      = offProf + profSize (spans);
+    size             = offSemWords + (SEM_COUNT(nGroups, nTables,                                     /* SEM_SLOTS */
+                                                REPLAYSEMS(replayMode, REPLAYSLOTS(nWaiters, nChefs, nGroups))) +
+                                      SEM_EXTRA) * sizeof (SEM_WORD);
+
+    /* whatever the way the generator exits, the entities are terminated and the IPC objects destroyed */
+    generator = getpid ();
+    if ((atexit (cleanup) != 0) ||
+        (sigaction (SIGINT, &(struct sigaction) { .sa_handler = onSignal }, NULL) == -1) ||
+        (sigaction (SIGTERM, &(struct sigaction) { .sa_handler = onSignal }, NULL) == -1) ||
+        (sigaction (SIGHUP, &(struct sigaction) { .sa_handler = onSignal }, NULL) == -1)) {
+        perror ("error on setting the release of the simulation");
+        exit (EXIT_FAILURE);
+    }
+
+    /* creating and initializing the shared memory region and the log file; a region and a semaphore set left over
+       with the same key by a simulation that did not end (no process has the region mapped) are destroyed first */
+    if (((shmid = shmemCreate (key, size)) == -1) && (errno == EEXIST)) {
+        if (shmemReclaim (key) == -1) {
+            if (errno == EBUSY) {
+                fprintf (stderr, "Access key 0x%x is in use by a running simulation!\n", key);
+            }
+            else perror ("error on destroying the left over shared memory region");
+            exit (EXIT_FAILURE);
+        }
+        if (semReclaim (key) == -1) {
+            perror ("error on destroying the left over semaphore set");
+            exit (EXIT_FAILURE);
+        }
+        fprintf (stderr, "IPC objects left over with access key 0x%x were destroyed\n", key);
+        shmid = shmemCreate (key, size);
+    }
+    if (shmid == -1) {
         perror ("error on creating the shared memory region");
         exit (EXIT_FAILURE);
     }
+    shmidAtExit = shmid;
     if (shmemAttach (shmid, (void **) &sh) == -1) { 
         perror ("error on mapping the shared region on the process address space");
         exit (EXIT_FAILURE);
     }
 
-    /* initialize random generator */
-    srandom ((unsigned int) getpid ());                                
-
-    /* initialize problem internal status */
-    sh->fSt.st.chefStat         = WAIT_FOR_ORDER;                     /* the chef waits for an order */
-    sh->fSt.st.waiterStat       = WAIT_FOR_REQUEST;                /* the waiter waits for a request */
-    sh->fSt.st.receptionistStat = WAIT_FOR_REQUEST;          /* the receptionist waits for a request */
-    for (g = 0; g < MAXGROUPS; g++) {
-        sh->fSt.st.groupStat[g] = GOTOREST;                                /* groups are initialized */
-        sh->fSt.assignedTable[g] = -1;                                     /* groups are initialized */
+    /* seed of the random generators of the entities */
+    if (!seeded) {
+        seed = cf.generated ? cf.wl.seed : (unsigned long long) time (NULL) * 1000003ULL ^ getpid ();
     }
-    sh->fSt.groupsWaiting=0;
+    sh->seed = seed;
 
-    FILE *fp = fopen("config.txt","r");
-    if(fp==NULL) {
-        perror("Could not open config file");
-        exit(EXIT_FAILURE);
-    }
+    /* initialize problem internal status */
+    sh->size = size;
+    sh->offSemWords = offSemWords;
+    sh->fSt.nGroups = nGroups;
+    sh->fSt.nTables = nTables;
+    sh->fSt.nWaiters = nWaiters;
+    sh->fSt.nChefs = nChefs;
+    sh->fSt.offGroupStat     = offGroupStat - offsetof (SHARED_DATA, fSt);              /* arrays follow the header */
+    sh->fSt.offSeq           = offSeq - offsetof (SHARED_DATA, fSt);
+    sh->fSt.stride           = CACHELINE;
+    sh->fSt.offStartTime     = offStartTime - offsetof (SHARED_DATA, fSt);
+    sh->fSt.offEatTime       = offEatTime - offsetof (SHARED_DATA, fSt);
+    sh->fSt.offGroupSize     = offGroupSize - offsetof (SHARED_DATA, fSt);
+    sh->fSt.offTableCap      = offTableCap - offsetof (SHARED_DATA, fSt);
+    sh->fSt.offAssignedTable = offAssignedTable - offsetof (SHARED_DATA, fSt);
+    memcpy (STARTTIME(&sh->fSt), cf.startTime, nGroups * sizeof (int));
+    memcpy (EATTIME(&sh->fSt), cf.eatTime, nGroups * sizeof (int));
+    memcpy (GROUPSIZE(&sh->fSt), cf.groupSize, nGroups * sizeof (int));
+    memcpy (TABLECAP(&sh->fSt), cf.tableCap, nTables * sizeof (int));
+    queueInit (&sh->fSt.receptionistRequest, qSize, SHARRAY(sh, offRecSlots, REQ_SLOT));
+    queueInit (&sh->fSt.waiterRequest, qSize, SHARRAY(sh, offWtSlots, REQ_SLOT));
+    latInit (&sh->lat, SHARRAY(sh, offLat, void));
+    replayInit (&sh->replay, replayMode, nWaiters, nChefs, nGroups, REPLAYLOCK, SHARRAY(sh, offReplay, void),
+                capacity, rev);
+    free (rev);
+    profInit (&sh->prof, nWaiters, nChefs, nGroups, runs, SHARRAY(sh, offProf, void), spans);
+    queueInit (&sh->fSt.orderRequest, nGroups, SHARRAY(sh, offOrdSlots, REQ_SLOT));  /* never full: one order per group */
+    queueInit (&sh->fSt.readyRequest, nGroups, SHARRAY(sh, offRdySlots, REQ_SLOT));   /* never full: one dish per group */
+    resetState (sh);
+    runInit (&sh->run, runs, 1+nWaiters+nChefs+nGroups, nFic);
+    configFree (&cf);
 
-    /* parse config file */
-    fscanf(fp,"%*[^\n]");
-    fscanf(fp,"%d ",&sh->fSt.nGroups);
-    fscanf(fp,"%*[^\n]");
-    for(g=0;g < sh->fSt.nGroups;g++) {
-       fscanf(fp,"%d %d", &sh->fSt.startTime[g], &sh->fSt.eatTime[g]);
-    }
-   
     /* create log file */
+    logInit (&sh->log, logMode, nGroups, SHARRAY(sh, offLog, void));
     createLog (nFic, &sh->fSt);                                  
     saveState(nFic,&sh->fSt);
 
+    /* log drainer process */
+    if (logMode == LOGBUFFERED) {
+        if ((pidLG = launchTask (drainer, &sh->log)) < 0) {
+            perror ("error on launching the log drainer");
+            exit (EXIT_FAILURE);
+        }
+    }
+
     /* initialize semaphore ids */
     sh->mutex                       = MUTEX;                                /* mutual exclusion semaphore id */
     sh->receptionistReq             = RECEPTIONISTREQ;                                                      
@@ -127,85 +646,85 @@ int main (int argc, char *argv[])
     sh->waiterRequest               = WAITERREQUEST;                                                      
     sh->waiterRequestPossible       = WAITERREQUESTPOSSIBLE;                                                      
     sh->waitOrder                   = WAITORDER;                                                      
-    sh->orderReceived               = ORDERRECEIVED;                                                      
-    for(g=0;g<sh->fSt.nGroups;g++) {
-       sh->waitForTable[g]          = WAITFORTABLE+g;                                                      
-    }
-    for(t=0;t<NUMTABLES;t++) {
-       sh->foodArrived[t]           = FOODARRIVED+t;                                                      
-       sh->tableDone[t]             = TABLEDONE+t;                                                      
-       sh->requestReceived[t]       = REQUESTRECEIVED+t;                              
-    }
+    sh->orderRequestPossible        = ORDERREQUESTPOSSIBLE;                                                      
+    sh->receptionLock               = globalLock ? MUTEX : RECEPTIONLOCK;                   /* domain locks */
+    sh->kitchenLock                 = globalLock ? MUTEX : KITCHENLOCK;
+    sh->globalLock                  = globalLock;
+    sh->pipelined                   = pipelined;
+    sh->batched                     = batched;
+    sh->seatAhead                   = seatAhead;
+    sh->eventLoop                   = eventLoop;
+    sh->groupLock                   = GROUPLOCK;                     /* first semaphore of each per-group or per-table range */
+    sh->waitForTable                = WAITFORTABLE;
+    sh->foodArrived                 = FOODARRIVED;
+    sh->tableDone                   = TABLEDONE;
+    sh->requestReceived             = REQUESTRECEIVED;
 
     /* creating and initializing the semaphore set */
-    if ((semgid = semCreate (key, SEM_NU)) == -1) { 
-        perror ("error on creating the semaphore set");
-        exit (EXIT_FAILURE);
-    }
-    if (semUp (semgid, sh->mutex) == -1) {                   /* enabling access to critical region */
-        perror ("error on executing the up operation for semaphore access");
-        exit (EXIT_FAILURE);
+    semBind (SEMWORDS, SEM_SLOTS);
+    if (((semgid = semCreate (key, SEM_NU)) == -1) && (errno == EEXIST) && (semReclaim (key) == 1)) {
+        semgid = semCreate (key, SEM_NU);                           /* left over by a simulation whose region is gone */
     }
-    if (semUp (semgid, sh->waiterRequestPossible) == -1) {                   /* enabling access to critical region */
-        perror ("error on executing the up operation for semaphore access");
-        exit (EXIT_FAILURE);
-    }
-    if (semUp (semgid, sh->receptionistRequestPossible) == -1) {                   /* enabling access to critical region */
-        perror ("error on executing the up operation for semaphore access");
+    if (semgid == -1) { 
+        perror ("error on creating the semaphore set");
         exit (EXIT_FAILURE);
     }
+    semgidAtExit = semgid;
+    resetSemaphores (sh, semgid);
+    logOrder (&sh->log, !globalLock);                         /* with -g, saveState is called holding the mutex */
+    clockInit (&sh->clock, virtualTime, 1+nWaiters+nChefs+nGroups, semgid, SHARRAY(sh, offClock, void));
 
     /* generation of intervening entities processes */                            
     /* group processes */
-    strcpy (nFicErr + 6, "GR");
+    lErr = strlen (nFicErr);
+    strcpy (nFicErr + lErr, "GR");
     for (g = 0; g < sh->fSt.nGroups; g++) {           
-        if ((pidGR[g] = fork ()) < 0) {
-            perror ("error on the fork operation for the group");
+        sprintf(num[0],"%d",g);
+        sprintf(nFicErr+lErr+2,"%02d",g); 
+        if (launchEntity (GROUP, (char *[]) { GROUP, num[0], nFic, num[1], nFicErr, NULL }) < 0) {
+            perror ("error on the generation of the group process");
             exit (EXIT_FAILURE);
         }
-        sprintf(num[0],"%d",g);
-        sprintf(nFicErr+8,"%02d",g); 
-        if (pidGR[g] == 0)
-            if (execl (GROUP, GROUP, num[0], nFic, num[1], nFicErr, NULL) < 0) { 
-                perror ("error on the generation of the group process");
-                exit (EXIT_FAILURE);
-            }
-    }
-    /* waiter process */
-    strcpy (nFicErr + 6, "WT");
-    if ((pidWT = fork ()) < 0)  {                            
-        perror ("error on the fork operation for the waiter");
-        exit (EXIT_FAILURE);
     }
-    if (pidWT == 0) {
-        if (execl (WAITER, WAITER, nFic, num[1], nFicErr, NULL) < 0) {
+    /* waiter processes */
+    strcpy (nFicErr + lErr, "WT");
+    for (w = 0; w < nWaiters; w++) {
+        sprintf(num[0],"%d",w);
+        if (nWaiters > 1) {                                                      /* a single one keeps the plain name */
+            sprintf(nFicErr+lErr+2,"%02d",w);
+        }
+        if (launchEntity (WAITER, (char *[]) { WAITER, num[0], nFic, num[1], nFicErr, NULL }) < 0) {
             perror ("error on the generation of the waiter process");
             exit (EXIT_FAILURE);
         }
     }
-    /* chef process */
-    strcpy (nFicErr + 6, "CH");
-    if ((pidCH = fork ()) < 0) {               
-        perror ("error on the fork operation for the chef");
-        exit (EXIT_FAILURE);
-    }
-    if (pidCH == 0)
-        if (execl (CHEF, CHEF, nFic, num[1], nFicErr, NULL) < 0) { 
+    /* chef processes */
+    strcpy (nFicErr + lErr, "CH");
+    for (c = 0; c < nChefs; c++) {
+        sprintf(num[0],"%d",c);
+        if (nChefs > 1) {                                                        /* a single one keeps the plain name */
+            sprintf(nFicErr+lErr+2,"%02d",c);
+        }
+        if (launchEntity (CHEF, (char *[]) { CHEF, num[0], nFic, num[1], nFicErr, NULL }) < 0) {
             perror ("error on the generation of the chef process");
             exit (EXIT_FAILURE);
         }
+    }
 
     /* receptionist process */
-    strcpy (nFicErr + 6, "RT");
-    if ((pidRT = fork ()) < 0) {               
-        perror ("error on the fork operation for the chef");
+    strcpy (nFicErr + lErr, "RT");
+    if (launchEntity (RECEPTIONIST, (char *[]) { RECEPTIONIST, nFic, num[1], nFicErr, NULL }) < 0) {
+        perror ("error on the generation of the receptionist process");
         exit (EXIT_FAILURE);
     }
-    if (pidRT == 0)
-        if (execl (RECEPTIONIST, RECEPTIONIST, nFic, num[1], nFicErr, NULL) < 0) { 
-            perror ("error on the generation of the receptionist process");
+
+    /* clock task */
+    if (virtualTime) {
+        if ((pidCK = launchTask (ticker, sh)) < 0) {
+            perror ("error on launching the clock task");
             exit (EXIT_FAILURE);
         }
+    }
 
     /* signaling start of operations */
     if (semSignal (semgid) == -1) {
@@ -213,18 +732,121 @@ int main (int argc, char *argv[])
         exit (EXIT_FAILURE);
     }
 
+    /* runs: at the end of each one the logging file is completed and, if another run follows, the full state,
+       the semaphores, the log, the seed and the clock are reset in place and the entities are released again */
+    for (r = 0; r < runs; r++) {
+        while (!runWait (&sh->run, SUPERVISEPERIOD)) {
+            supervise ();
+        }
+
+        if (virtualTime && (waitTask (pidCK) == -1)) {
+            perror ("error on waiting for the clock task");
+            exit (EXIT_FAILURE);
+        }
+
+        /* flushing the log buffer or truncating the memory mapped log file */
+        if ((logMode == LOGBUFFERED) || (logMode == LOGMAPPED)) {
+            logClose (&sh->log);
+        }
+        if (logMode == LOGBUFFERED) {
+            if (waitTask (pidLG) == -1) {
+                perror ("error on waiting for the log drainer");
+                exit (EXIT_FAILURE);
+            }
+        }
+        logSummary (nFic, &sh->log);                                              /* only at the summary logging level */
+        if (r == runs - 1) {
+            break;
+        }
+
+        runLogName (nFic, nFicBase, runs, r + 1);
+        resetState (sh);
+        resetSemaphores (sh, semgid);
+        sh->seed = seed + r + 1;
+        logInit (&sh->log, logMode, nGroups, SHARRAY(sh, offLog, void));
+        createLog (nFic, &sh->fSt);
+        saveState (nFic, &sh->fSt);
+        logOrder (&sh->log, !globalLock);
+        if ((logMode == LOGBUFFERED) && ((pidLG = launchTask (drainer, &sh->log)) < 0)) {
+            perror ("error on launching the log drainer");
+            exit (EXIT_FAILURE);
+        }
+        clockInit (&sh->clock, virtualTime, 1+nWaiters+nChefs+nGroups, semgid, SHARRAY(sh, offClock, void));
+        if (virtualTime && ((pidCK = launchTask (ticker, sh)) < 0)) {
+            perror ("error on launching the clock task");
+            exit (EXIT_FAILURE);
+        }
+        runStart (&sh->run, r + 1, nFic);
+    }
+
     /* waiting for the termination of the intervening entities processes */
-    m = 0;
-    do {
-        info = wait (&status);
+    for (m = nEnded; m < 1+nWaiters+nChefs+sh->fSt.nGroups; m++) {
+        info = waitEntity (&status);
         if (info == -1) { 
             perror ("error on aiting for an intervening process");
             exit (EXIT_FAILURE);
         }
-        m += 1;
-    } while (m < 3+sh->fSt.nGroups);
+    }
+
+    /* writing of the latency report */
+    if (nLatReport != NULL) {
+        if ((fpLat = fopen (nLatReport, "w")) == NULL) {
+            perror ("error on opening the latency report");
+            exit (EXIT_FAILURE);
+        }
+        fprintf (fpLat, "seed %llu\n", seed);
+        latReport (fpLat, &sh->lat);
+        if (fclose (fpLat) == EOF) {
+            perror ("error on writing the latency report");
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    /* saving of the recorded trace, or checking that the whole trace was replayed */
+    if (replayMode == REPLAY_RECORD) {
+        if (sh->replay.overflow) {
+            fprintf (stderr, "The trace does not fit %u events: it was not saved!\n", sh->replay.capacity);
+            exit (EXIT_FAILURE);
+        }
+        rh.seed = seed;
+        rh.nGroups = nGroups;
+        rh.nTables = nTables;
+        rh.nWaiters = nWaiters;
+        rh.nChefs = nChefs;
+        rh.runs = runs;
+        if (replaySave (nTrace, &rh, &sh->replay) == -1) {
+            perror ("error on saving the trace");
+            exit (EXIT_FAILURE);
+        }
+        fprintf (stderr, "trace %s: %u events recorded\n", nTrace, sh->replay.nEvents);
+    }
+    else if (replayMode == REPLAY_PLAY) {
+        if (sh->replay.next != sh->replay.nEvents) {
+            fprintf (stderr, "The replay ended at event %u of %u!\n", sh->replay.next, sh->replay.nEvents);
+            exit (EXIT_FAILURE);
+        }
+        fprintf (stderr, "trace %s: %u events replayed\n", nTrace, sh->replay.nEvents);
+    }
+
+    /* writing of the profiling spans */
+    if (sh->prof.nSpans > sh->prof.capacity) {
+        fprintf (stderr, "%u profiling spans did not fit and were dropped!\n", sh->prof.nSpans - sh->prof.capacity);
+    }
+    if ((nProfTrace != NULL) && (profTrace (nProfTrace, &sh->prof) == -1)) {
+        perror ("error on writing the profiling trace");
+        exit (EXIT_FAILURE);
+    }
+    if ((nProfFolded != NULL) && (profFolded (nProfFolded, &sh->prof) == -1)) {
+        perror ("error on writing the profiling folded stacks");
+        exit (EXIT_FAILURE);
+    }
+    if (sh->prof.capacity > 0) {
+        fprintf (stderr, "profile: %u spans\n", (sh->prof.nSpans < sh->prof.capacity) ? sh->prof.nSpans
+                                                                                        : sh->prof.capacity);
+    }
 
     /* destruction of semaphore set and shared region */
+    semgidAtExit = shmidAtExit = -1;
     if (semDestroy (semgid) == -1) {
         perror ("error on destructing the semaphore set");
         exit (EXIT_FAILURE);
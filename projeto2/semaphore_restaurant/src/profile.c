@@ -0,0 +1,298 @@
+/**
+ *  \file profile.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Profiling of the life cycle operations of the entities.
+ *
+ *  Defined operations:
+ *     \li size of the area that holds the spans
+ *     \li profiling data initialization
+ *     \li binding of an entity to the profiling data
+ *     \li start of a span
+ *     \li end of a span
+ *     \li writing of the spans as a trace of Chrome trace events
+ *     \li writing of the spans as folded stacks.
+ */
+
+#define _GNU_SOURCE                                                                             /* RUSAGE_THREAD */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "profile.h"
+
+/** \brief spans of the profiling data p */
+#define  SPANS(p)           SHARRAY(p, (p)->offSpan, PROF_SPAN)
+
+/** \brief names of the entity kinds */
+static const char *kindName[] = { "generator", "group", "waiter", "chef", "receptionist" };
+
+/** \brief names of the profiling spans */
+static const char *spanName[PROFSPANS] = {
+    "goToRestaurant", "checkInAtReception", "orderFood", "waitFood", "eat", "checkOutAtReception",
+    "waitForClientOrChef", "informChef", "takeFoodToTable", "waitForOrder", "processOrder",
+    "waitForGroup", "provideTableOrWaitingRoom", "receivePayment", "serveRequests"
+};
+
+/** \brief profiling data the calling entity is bound to (NULL if none, or if the entities are not profiled) */
+static __thread PROF_SHARED *prof = NULL;
+
+/** \brief span of the calling entity that is open (its fields as at the start) */
+static __thread PROF_SPAN cur;
+
+/** \brief the calling entity has a span open */
+static __thread bool curOpen = false;
+
+/* internal functions */
+
+/** \brief monotonic clock (in ns) */
+static unsigned long long nowNs (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/** \brief times and context switches of the calling thread, so far */
+static void sample (PROF_SPAN *s)
+{
+    struct rusage ru;
+
+    getrusage (RUSAGE_THREAD, &ru);
+    s->user = (unsigned long long) ru.ru_utime.tv_sec * 1000000000ULL + ru.ru_utime.tv_usec * 1000ULL;
+    s->sys = (unsigned long long) ru.ru_stime.tv_sec * 1000000000ULL + ru.ru_stime.tv_usec * 1000ULL;
+    s->nvcsw = (unsigned int) ru.ru_nvcsw;
+    s->nivcsw = (unsigned int) ru.ru_nivcsw;
+}
+
+/** \brief number of spans kept */
+static unsigned int kept (PROF_SHARED *p)
+{
+    return (p->nSpans < p->capacity) ? p->nSpans : p->capacity;
+}
+
+/** \brief name of the thread of an entity, as a metadata event of the trace */
+static void threadName (FILE *fp, unsigned int run, unsigned int id)
+{
+    fprintf (fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+             run + 1, id, kindName[ENTITYKIND(id)], ENTITYIDX(id));
+}
+
+/* external functions */
+
+/**
+ *  \brief Size of the area that holds the spans.
+ *
+ *  \param capacity number of spans
+ *
+ *  \return size in bytes, multiple of CACHELINE
+ */
+size_t profSize (unsigned int capacity)
+{
+    return capacity * sizeof (PROF_SPAN);
+}
+
+/**
+ *  \brief Profiling data initialization.
+ *
+ *  Must be called by the generator before any entity is launched. The area must be in the same shared region as
+ *  the profiling data.
+ *
+ *  \param p pointer to the profiling data
+ *  \param nWaiters number of waiters
+ *  \param nChefs number of chefs
+ *  \param nGroups number of groups
+ *  \param runs number of runs
+ *  \param area pointer to a location with profSize(capacity) bytes
+ *  \param capacity room for spans (0 if the entities are not to be profiled)
+ */
+void profInit (PROF_SHARED *p, int nWaiters, int nChefs, int nGroups, unsigned int runs, void *area,
+               unsigned int capacity)
+{
+    p->capacity = capacity;
+    p->offSpan = (char *) area - (char *) p;
+    p->nWaiters = nWaiters;
+    p->nChefs = nChefs;
+    p->nGroups = nGroups;
+    p->runs = runs;
+    p->nSpans = 0;
+}
+
+/**
+ *  \brief Binding of the calling entity to the profiling data, for a run.
+ *
+ *  \param p pointer to the profiling data
+ *  \param id id of the calling entity (see ENTITYID)
+ *  \param run run (0 .. runs - 1)
+ */
+void profAttach (PROF_SHARED *p, unsigned int id, unsigned int run)
+{
+    prof = (p->capacity == 0) ? NULL : p;
+    cur.who = id;
+    cur.run = run;
+    curOpen = false;
+}
+
+/**
+ *  \brief Start of a span of the calling entity.
+ *
+ *  Has no effect if the entity is not bound, or the entities are not profiled.
+ *
+ *  \param span profiling span
+ */
+void profBegin (unsigned int span)
+{
+    if (prof == NULL) {
+        return;
+    }
+    cur.span = span;
+    sample (&cur);
+    cur.start = nowNs ();
+    curOpen = true;
+}
+
+/**
+ *  \brief End of the span of the calling entity that is open, which is stored.
+ *
+ *  Has no effect if there is none.
+ */
+void profEnd (void)
+{
+    PROF_SPAN now;
+    unsigned int i;
+
+    if (!curOpen) {
+        return;
+    }
+    now.wall = nowNs ();
+    sample (&now);
+    curOpen = false;
+    if ((i = __atomic_fetch_add (&prof->nSpans, 1, __ATOMIC_RELAXED)) >= prof->capacity) {
+        return;                                                                          /* counted, not kept */
+    }
+    SPANS(prof)[i] = cur;
+    SPANS(prof)[i].wall = now.wall - cur.start;
+    SPANS(prof)[i].user = now.user - cur.user;
+    SPANS(prof)[i].sys = now.sys - cur.sys;
+    SPANS(prof)[i].nvcsw = now.nvcsw - cur.nvcsw;
+    SPANS(prof)[i].nivcsw = now.nivcsw - cur.nivcsw;
+}
+
+/**
+ *  \brief Writing of the spans as a trace of Chrome trace events (JSON object format).
+ *
+ *  Each run is a process (pid 1 .. runs) and each entity a thread of it (tid its entity id); each span is a
+ *  complete event, timed in us from the start of the earliest span of its run, with its user and system time
+ *  and its context switches as arguments. The trace opens in chrome://tracing or Perfetto.
+ *
+ *  \param path name of the trace file
+ *  \param p pointer to the profiling data
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int profTrace (char path[], PROF_SHARED *p)
+{
+    unsigned long long origin[p->runs];
+    PROF_SPAN *s;
+    FILE *fp;
+    unsigned int i, r;
+    int e;
+
+    for (r = 0; r < p->runs; r++) {
+        origin[r] = ~0ULL;
+    }
+    for (i = 0; i < kept (p); i++) {
+        s = &SPANS(p)[i];
+        if (s->start < origin[s->run]) {
+            origin[s->run] = s->start;
+        }
+    }
+
+    if ((fp = fopen (path, "w")) == NULL) {
+        return -1;
+    }
+    fprintf (fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf (fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"run 1\"}}");
+    for (r = 0; r < p->runs; r++) {
+        if (r > 0) {
+            fprintf (fp, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"run %u\"}}",
+                     r + 1, r + 1);
+        }
+        threadName (fp, r, ENTITYID(ENT_RECEPTIONIST, 0));
+        for (e = 0; e < p->nWaiters; e++) {
+            threadName (fp, r, ENTITYID(ENT_WAITER, e));
+        }
+        for (e = 0; e < p->nChefs; e++) {
+            threadName (fp, r, ENTITYID(ENT_CHEF, e));
+        }
+        for (e = 0; e < p->nGroups; e++) {
+            threadName (fp, r, ENTITYID(ENT_GROUP, e));
+        }
+    }
+    for (i = 0; i < kept (p); i++) {
+        s = &SPANS(p)[i];
+        fprintf (fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                 "\"args\":{\"user_us\":%.3f,\"sys_us\":%.3f,\"nvcsw\":%u,\"nivcsw\":%u}}",
+                 spanName[s->span], kindName[ENTITYKIND(s->who)], s->run + 1, s->who,
+                 (s->start - origin[s->run]) / 1000.0, s->wall / 1000.0, s->user / 1000.0, s->sys / 1000.0,
+                 s->nvcsw, s->nivcsw);
+    }
+    fprintf (fp, "\n]}\n");
+    return (fclose (fp) == EOF) ? -1 : 0;
+}
+
+/**
+ *  \brief Writing of the spans as folded stacks.
+ *
+ *  Lines <tt>kind;span;time value</tt>, where time is <tt>user</tt>, <tt>system</tt> or <tt>off-cpu</tt> (the
+ *  elapsed time spent neither in user mode nor in system calls: blocked, sleeping or waiting to be scheduled) and
+ *  value its total over every span of every entity of that kind, in us. The file is the input of flamegraph.pl.
+ *
+ *  \param path name of the folded stacks file
+ *  \param p pointer to the profiling data
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int profFolded (char path[], PROF_SHARED *p)
+{
+    static const char *timeName[3] = { "user", "system", "off-cpu" };
+    unsigned long long total[ENT_RECEPTIONIST+1][PROFSPANS][3];                                         /* in ns */
+    PROF_SPAN *s;
+    FILE *fp;
+    unsigned int i, k, n, t;
+
+    memset (total, 0, sizeof (total));
+    for (i = 0; i < kept (p); i++) {
+        s = &SPANS(p)[i];
+        k = ENTITYKIND(s->who);
+        total[k][s->span][0] += s->user;
+        total[k][s->span][1] += s->sys;
+        if (s->wall > s->user + s->sys) {                         /* the CPU times are sampled with less precision */
+            total[k][s->span][2] += s->wall - s->user - s->sys;
+        }
+    }
+
+    if ((fp = fopen (path, "w")) == NULL) {
+        return -1;
+    }
+    for (k = 0; k <= ENT_RECEPTIONIST; k++) {
+        for (n = 0; n < PROFSPANS; n++) {
+            for (t = 0; t < 3; t++) {
+                if (total[k][n][t] >= 1000) {
+                    fprintf (fp, "%s;%s;%s %llu\n", kindName[k], spanName[n], timeName[t], total[k][n][t] / 1000);
+                }
+            }
+        }
+    }
+    return (fclose (fp) == EOF) ? -1 : 0;
+}
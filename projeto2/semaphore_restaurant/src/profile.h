@@ -0,0 +1,115 @@
+/**
+ *  \file profile.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Profiling of the life cycle operations of the entities.
+ *
+ *  Defined operations:
+ *     \li size of the area that holds the spans
+ *     \li profiling data initialization
+ *     \li binding of an entity to the profiling data
+ *     \li start of a span
+ *     \li end of a span
+ *     \li writing of the spans as a trace of Chrome trace events
+ *     \li writing of the spans as folded stacks.
+ *
+ *  A span is a call of a life cycle operation by an entity (see PROFSPANS). Its elapsed time is measured with the
+ *  monotonic clock and its user time, system time and context switches are sampled with <tt>getrusage</tt> at
+ *  both ends, for the calling thread only (the entity, in both engines). Spans do not nest: an entity has at most
+ *  one open at a time.
+ *
+ *  Every entity stores the spans it ends in the same area of the shared region, with an atomic increment, so that
+ *  no lock is taken and the spans of the whole simulation are merged as they are stored. Spans that do not fit the
+ *  area are counted, not kept.
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stddef.h>
+
+#include "probDataStruct.h"
+
+/**
+ *  \brief Size of the area that holds the spans.
+ *
+ *  \param capacity number of spans
+ *
+ *  \return size in bytes, multiple of CACHELINE
+ */
+extern size_t profSize (unsigned int capacity);
+
+/**
+ *  \brief Profiling data initialization.
+ *
+ *  Must be called by the generator before any entity is launched. The area must be in the same shared region as
+ *  the profiling data.
+ *
+ *  \param p pointer to the profiling data
+ *  \param nWaiters number of waiters
+ *  \param nChefs number of chefs
+ *  \param nGroups number of groups
+ *  \param runs number of runs
+ *  \param area pointer to a location with profSize(capacity) bytes
+ *  \param capacity room for spans (0 if the entities are not to be profiled)
+ */
+extern void profInit (PROF_SHARED *p, int nWaiters, int nChefs, int nGroups, unsigned int runs, void *area,
+                      unsigned int capacity);
+
+/**
+ *  \brief Binding of the calling entity to the profiling data, for a run.
+ *
+ *  \param p pointer to the profiling data
+ *  \param id id of the calling entity (see ENTITYID)
+ *  \param run run (0 .. runs - 1)
+ */
+extern void profAttach (PROF_SHARED *p, unsigned int id, unsigned int run);
+
+/**
+ *  \brief Start of a span of the calling entity.
+ *
+ *  Has no effect if the entity is not bound, or the entities are not profiled.
+ *
+ *  \param span profiling span
+ */
+extern void profBegin (unsigned int span);
+
+/**
+ *  \brief End of the span of the calling entity that is open, which is stored.
+ *
+ *  Has no effect if there is none.
+ */
+extern void profEnd (void);
+
+/**
+ *  \brief Writing of the spans as a trace of Chrome trace events (JSON object format).
+ *
+ *  Each run is a process (pid 1 .. runs) and each entity a thread of it (tid its entity id); each span is a
+ *  complete event, timed in us from the start of the earliest span of its run, with its user and system time
+ *  and its context switches as arguments. The trace opens in chrome://tracing or Perfetto.
+ *
+ *  \param path name of the trace file
+ *  \param p pointer to the profiling data
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int profTrace (char path[], PROF_SHARED *p);
+
+/**
+ *  \brief Writing of the spans as folded stacks.
+ *
+ *  Lines <tt>kind;span;time value</tt>, where time is <tt>user</tt>, <tt>system</tt> or <tt>off-cpu</tt> (the
+ *  elapsed time spent neither in user mode nor in system calls: blocked, sleeping or waiting to be scheduled) and
+ *  value its total over every span of every entity of that kind, in us. The file is the input of flamegraph.pl.
+ *
+ *  \param path name of the folded stacks file
+ *  \param p pointer to the profiling data
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int profFolded (char path[], PROF_SHARED *p);
+
+#endif /* PROFILE_H_ */
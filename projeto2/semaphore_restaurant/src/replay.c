@@ -0,0 +1,496 @@
+/**
+ *  \file replay.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Replay engine: recording and enforcement of the order of the semaphore grants.
+ *
+ *  Defined operations:
+ *     \li size of the area that holds the events
+ *     \li replay engine initialization
+ *     \li setting of its semaphores to their initial value
+ *     \li binding of an entity to the replay engine
+ *     \li <em>down</em> of a semaphore, recorded or replayed
+ *     \li <em>down</em> of a semaphore only if it does not block, recorded or replayed
+ *     \li batch of semaphore operations, recorded or replayed
+ *     \li atomic addition to a shared counter, recorded or replayed
+ *     \li bracketing of any other race (start, recorded outcome and end)
+ *     \li checking whether the next event is the one of the calling entity
+ *     \li loading and saving of a trace.
+ *
+ *  Entity slots: 0 is the clock task, 1 the receptionist, then the waiters, the chefs and the groups.
+ *
+ *  A grant is recorded after it is obtained, so that the trace is in causal order: the <em>up</em> a grant waited
+ *  for comes after the events its entity recorded before it. Two grants of the same semaphore may be recorded in
+ *  the reverse order of the grants, which is replayed as the same simulation since they are not told apart.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "replay.h"
+#include "semaphore.h"
+
+/** \brief events of the control data r */
+#define  EVENTS(r)           SHARRAY(r, (r)->offEvent, REPLAY_EVENT)
+
+/** \brief event field what of a kind of event on an object */
+#define  WHAT(kind,obj)      (((kind) << 24) | ((obj) & 0xFFFFFF))
+
+/** \brief control data the calling entity is bound to (NULL if none, or if the replay engine is off) */
+static __thread REPLAY_SHARED *rep = NULL;
+
+/** \brief semaphore set identifier of the calling entity */
+static __thread int repSemgid;
+
+/** \brief entity slot of the calling entity */
+static __thread unsigned int repSlot;
+
+/** \brief event field what of the race being carried out by the calling entity */
+static __thread unsigned int repWhat;
+
+/* internal functions */
+
+/** \brief reporting of a divergence from the trace: the calling entity fails */
+static void diverge (char *why)
+{
+    fprintf (stderr, "Replay diverged at event %u of %u (entity slot %u): %s!\n", rep->next, rep->nEvents, repSlot,
+             why);
+    exit (EXIT_FAILURE);
+}
+
+/** \brief <em>down</em> or <em>up</em> of a semaphore of the replay engine */
+static void turnOp (unsigned int sindex, bool take)
+{
+    if ((take ? semDown (repSemgid, sindex) : semUp (repSemgid, sindex)) == -1) {
+        perror ("error on the operation for replay turn access");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/** \brief start of an event: the recording lock is taken or, in replay mode, the turn is waited for */
+static void enter (unsigned int what)
+{
+    repWhat = what;
+    if (rep->mode == REPLAY_RECORD) {
+        turnOp (rep->lock, true);
+        return;
+    }
+    if (__atomic_load_n (&rep->next, __ATOMIC_ACQUIRE) < rep->nEvents) {
+        turnOp (rep->turn + repSlot, true);
+    }
+    if (rep->next >= rep->nEvents) {                                   /* woken up at the end of the trace */
+        diverge ("the trace is over");
+    }
+    if (EVENTS(rep)[rep->next].what != what) {
+        diverge ("another event was recorded");
+    }
+}
+
+/** \brief end of an event: it is appended to the trace or, in replay mode, checked and the turn handed on */
+static void leave (long long value)
+{
+    REPLAY_EVENT *e;
+    unsigned int next;
+    int s;
+
+    if (rep->mode == REPLAY_RECORD) {
+        if (rep->nEvents < rep->capacity) {
+            e = &EVENTS(rep)[rep->nEvents++];
+            e->who = repSlot;
+            e->what = repWhat;
+            e->value = value;
+        }
+        else rep->overflow = true;
+        turnOp (rep->lock, false);
+        return;
+    }
+    if (EVENTS(rep)[rep->next].value != value) {
+        diverge ("another outcome was recorded");
+    }
+    next = rep->next + 1;
+    __atomic_store_n (&rep->next, next, __ATOMIC_RELEASE);
+    if (next < rep->nEvents) {
+        turnOp (rep->turn + EVENTS(rep)[next].who, false);
+    }
+    else {
+        for (s = 0; s < rep->nSlots; s++) {                    /* entities still waiting find the trace is over */
+            turnOp (rep->turn + s, false);
+        }
+    }
+}
+
+/* external functions */
+
+/**
+ *  \brief Size of the area that holds the events.
+ *
+ *  \param capacity number of events
+ *
+ *  \return size in bytes, multiple of CACHELINE
+ */
+size_t replaySize (unsigned int capacity)
+{
+    return ALIGNCL(capacity * sizeof (REPLAY_EVENT));
+}
+
+/**
+ *  \brief Replay engine initialization.
+ *
+ *  Must be called by the generator before the semaphore set is created, which must have the semaphores given by
+ *  REPLAYSEMS from <tt>lock</tt> on. The area must be in the same shared region as the control data.
+ *
+ *  \param rp pointer to the control data
+ *  \param mode REPLAY_OFF, REPLAY_RECORD or REPLAY_PLAY
+ *  \param nWaiters number of waiters
+ *  \param nChefs number of chefs
+ *  \param nGroups number of groups
+ *  \param lock recording lock semaphore, followed by the turn semaphore of every entity slot
+ *  \param area pointer to a location with replaySize(capacity) bytes
+ *  \param capacity room for events (record mode) or number of events to be replayed (replay mode)
+ *  \param event events to be replayed (replay mode)
+ */
+void replayInit (REPLAY_SHARED *rp, unsigned int mode, int nWaiters, int nChefs, int nGroups, unsigned int lock,
+                 void *area, unsigned int capacity, REPLAY_EVENT event[])
+{
+    rp->mode = mode;
+    rp->lock = lock;
+    rp->turn = lock + 1;
+    rp->nSlots = REPLAYSLOTS(nWaiters, nChefs, nGroups);
+    rp->nWaiters = nWaiters;
+    rp->nChefs = nChefs;
+    rp->capacity = capacity;
+    rp->offEvent = (char *) area - (char *) rp;
+    rp->nEvents = 0;
+    rp->overflow = false;
+    rp->next = 0;
+    if (mode == REPLAY_PLAY) {
+        memcpy (area, event, capacity * sizeof (REPLAY_EVENT));
+        rp->nEvents = capacity;
+    }
+}
+
+/**
+ *  \brief Setting of the semaphores of the replay engine to their initial value.
+ *
+ *  Must be called after every other semaphore of the set is reset: the recording lock is free, or the entity of
+ *  the next event has the turn.
+ *
+ *  \param rp pointer to the control data
+ *  \param semgid semaphore set identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int replayReset (REPLAY_SHARED *rp, int semgid)
+{
+    if (rp->mode == REPLAY_RECORD) {
+        return semSet (semgid, rp->lock, 1);
+    }
+    if ((rp->mode == REPLAY_PLAY) && (rp->next < rp->nEvents)) {
+        return semSet (semgid, rp->turn + EVENTS(rp)[rp->next].who, 1);
+    }
+    return 0;
+}
+
+/**
+ *  \brief Binding of the calling entity to the replay engine.
+ *
+ *  \param rp pointer to the control data
+ *  \param semgid semaphore set identifier
+ *  \param id id of the calling entity (see ENTITYID; the clock task has the id of the generator)
+ */
+void replayAttach (REPLAY_SHARED *rp, int semgid, unsigned int id)
+{
+    rep = (rp->mode == REPLAY_OFF) ? NULL : rp;
+    repSemgid = semgid;
+    switch (ENTITYKIND(id)) {
+        case ENT_GENERATOR:
+            repSlot = 0;
+            break;
+        case ENT_RECEPTIONIST:
+            repSlot = 1;
+            break;
+        case ENT_WAITER:
+            repSlot = 2 + ENTITYIDX(id);
+            break;
+        case ENT_CHEF:
+            repSlot = 2 + rp->nWaiters + ENTITYIDX(id);
+            break;
+        default:
+            repSlot = 2 + rp->nWaiters + rp->nChefs + ENTITYIDX(id);
+    }
+}
+
+/**
+ *  \brief <em>Down</em> of a semaphore, recorded or replayed.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sindex semaphore index
+ *
+ *  \return as <tt>semDown</tt>
+ */
+int replayDown (int semgid, unsigned int sindex)
+{
+    if (rep == NULL) {
+        return semDown (semgid, sindex);
+    }
+    if (rep->mode == REPLAY_RECORD) {
+        if (semDown (semgid, sindex) == -1) {
+            return -1;
+        }
+        enter (WHAT(REPLAY_DOWN, sindex));
+    }
+    else {
+        enter (WHAT(REPLAY_DOWN, sindex));
+        if (semDown (semgid, sindex) == -1) {
+            return -1;
+        }
+    }
+    leave (0);
+    return 0;
+}
+
+/**
+ *  \brief <em>Down</em> of a semaphore only if it does not block, recorded or replayed.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sindex semaphore index
+ *
+ *  \return as <tt>semTryDown</tt>
+ */
+int replayTryDown (int semgid, unsigned int sindex)
+{
+    long long got;
+    int stat;
+
+    if (rep == NULL) {
+        return semTryDown (semgid, sindex);
+    }
+    enter (WHAT(REPLAY_TRYDOWN, sindex));
+    if (replayPlaying (&got)) {
+        if (got == 0) {
+            stat = -1;                                                   /* failed when recorded: not attempted */
+            errno = EAGAIN;
+        }
+        else if ((stat = semDown (semgid, sindex)) == -1) {                    /* the up may not have taken place */
+            return -1;
+        }
+    }
+    else if (((stat = semTryDown (semgid, sindex)) == -1) && (errno != EAGAIN)) {
+        return -1;
+    }
+    leave (stat == 0);
+    if (stat == -1) {
+        errno = EAGAIN;
+    }
+    return stat;
+}
+
+/**
+ *  \brief Batch of semaphore operations (see semOps), recorded or replayed if it has a <em>down</em>.
+ *
+ *  The <em>ups</em> that follow the last <em>down</em> are carried out after the grant is recorded and, when
+ *  replaying, the ones that precede the first <em>down</em> before the turn is waited for, as they may be needed by
+ *  the events before it: the batch is not atomic, as in the futex implementation of the semaphores.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param ops operations
+ *  \param n number of operations
+ *
+ *  \return as <tt>semOps</tt>
+ */
+int replayOps (int semgid, SEM_OP ops[], unsigned int n)
+{
+    unsigned int f, l;                                                                 /* first and last down */
+
+    for (f = 0; (f < n) && (ops[f].op > 0); f++) ;
+    if ((rep == NULL) || (f == n)) {
+        return semOps (semgid, ops, n);
+    }
+    for (l = n - 1; ops[l].op > 0; l--) ;
+    if (rep->mode == REPLAY_RECORD) {
+        if (semOps (semgid, ops, l + 1) == -1) {
+            return -1;
+        }
+        enter (WHAT(REPLAY_DOWN, ops[f].sindex));
+    }
+    else {
+        if ((f > 0) && (semOps (semgid, ops, f) == -1)) {        /* the ups may be waited for by earlier events */
+            return -1;
+        }
+        enter (WHAT(REPLAY_DOWN, ops[f].sindex));
+        if (semOps (semgid, ops + f, l + 1 - f) == -1) {
+            return -1;
+        }
+    }
+    leave (0);
+    return (l + 1 < n) ? semOps (semgid, ops + l + 1, n - l - 1) : 0;      /* the ups that follow the grant */
+}
+
+/**
+ *  \brief Atomic addition to a shared counter, recorded or replayed.
+ *
+ *  \param counter pointer to the counter
+ *  \param add value added (0 to read the counter)
+ *
+ *  \return value of the counter before the addition
+ */
+int replayFetchAdd (int *counter, int add)
+{
+    int v;
+
+    if (rep == NULL) {
+        return (add == 0) ? __atomic_load_n (counter, __ATOMIC_ACQUIRE) :
+                            __atomic_fetch_add (counter, add, __ATOMIC_ACQ_REL);
+    }
+    replayEnter (REPLAY_COUNTER, counter);
+    v = __atomic_fetch_add (counter, add, __ATOMIC_ACQ_REL);
+    replayLeave (v);
+    return v;
+}
+
+/**
+ *  \brief Start of any other race, in the shared region.
+ *
+ *  The race must not block: it is either carried out with the recording lock held or, in replay mode, with the
+ *  turn. It ends with <tt>replayLeave</tt>.
+ *
+ *  \param kind kind of event
+ *  \param object pointer to the object the race takes place on
+ */
+void replayEnter (unsigned int kind, void *object)
+{
+    if (rep != NULL) {
+        enter (WHAT(kind, (unsigned int) ((char *) object - (char *) rep)));
+    }
+}
+
+/**
+ *  \brief Outcome of the race being replayed.
+ *
+ *  \param value pointer to the location where its recorded outcome is stored (replay mode)
+ *
+ *  \return \c true, in replay mode: the race must have the recorded outcome
+ *  \return \c false, if it is carried out freely
+ */
+bool replayPlaying (long long *value)
+{
+    if ((rep == NULL) || (rep->mode != REPLAY_PLAY)) {
+        return false;
+    }
+    *value = EVENTS(rep)[rep->next].value;
+    return true;
+}
+
+/**
+ *  \brief End of a race started by <tt>replayEnter</tt>, with its outcome.
+ *
+ *  \param value outcome of the race
+ */
+void replayLeave (long long value)
+{
+    if (rep != NULL) {
+        leave (value);
+    }
+}
+
+/**
+ *  \brief Checking whether the next event to be replayed is one of the calling entity.
+ *
+ *  \return \c true, if so, or if nothing is being replayed
+ *  \return \c false, otherwise
+ */
+bool replayTurn (void)
+{
+    unsigned int next;
+
+    if ((rep == NULL) || (rep->mode != REPLAY_PLAY)) {
+        return true;
+    }
+    next = __atomic_load_n (&rep->next, __ATOMIC_ACQUIRE);
+    return (next < rep->nEvents) && (EVENTS(rep)[next].who == repSlot);
+}
+
+/**
+ *  \brief Loading of a trace file.
+ *
+ *  \param path name of the trace file
+ *  \param hd pointer to the location where the header is stored
+ *  \param event pointer to the location where a pointer to the events, allocated with malloc, is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the file could not be read or is wrong (the error is reported on stderr)
+ */
+int replayLoad (char path[], REPLAY_HEADER *hd, REPLAY_EVENT **event)
+{
+    FILE *fp;
+    unsigned int i, nSlots;
+
+    if ((fp = fopen (path, "r")) == NULL) {
+        perror ("Could not open trace file");
+        return -1;
+    }
+    if ((fread (hd, sizeof (REPLAY_HEADER), 1, fp) != 1) || (memcmp (hd->magic, REPLAYMAGIC, sizeof (hd->magic)) != 0)) {
+        fprintf (stderr, "%s: not a trace file!\n", path);
+        fclose (fp);
+        return -1;
+    }
+    if ((hd->nEvents < 1) || (hd->nEvents > REPLAYMAXEVENTS)) {
+        fprintf (stderr, "%s: number of events must be in 1 .. %d!\n", path, REPLAYMAXEVENTS);
+        fclose (fp);
+        return -1;
+    }
+    if ((*event = malloc (hd->nEvents * sizeof (REPLAY_EVENT))) == NULL) {
+        perror ("error on allocating the events of the trace");
+        fclose (fp);
+        return -1;
+    }
+    if ((fread (*event, sizeof (REPLAY_EVENT), hd->nEvents, fp) != hd->nEvents) || (fgetc (fp) != EOF)) {
+        fprintf (stderr, "%s: the size of the trace file does not match its number of events!\n", path);
+        free (*event);
+        fclose (fp);
+        return -1;
+    }
+    fclose (fp);
+    nSlots = REPLAYSLOTS(hd->nWaiters, hd->nChefs, hd->nGroups);
+    for (i = 0; i < hd->nEvents; i++) {
+        if ((*event)[i].who >= nSlots) {
+            fprintf (stderr, "%s: event %u took place at no entity!\n", path, i);
+            free (*event);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ *  \brief Saving of the recorded events as a trace file.
+ *
+ *  \param path name of the trace file
+ *  \param hd pointer to the header (its number of events is set)
+ *  \param rp pointer to the control data
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+int replaySave (char path[], REPLAY_HEADER *hd, REPLAY_SHARED *rp)
+{
+    FILE *fp;
+
+    memcpy (hd->magic, REPLAYMAGIC, sizeof (hd->magic));
+    hd->nEvents = rp->nEvents;
+    if ((fp = fopen (path, "w")) == NULL) {
+        return -1;
+    }
+    if ((fwrite (hd, sizeof (REPLAY_HEADER), 1, fp) != 1) ||
+        (fwrite (EVENTS(rp), sizeof (REPLAY_EVENT), rp->nEvents, fp) != rp->nEvents)) {
+        fclose (fp);
+        return -1;
+    }
+    return (fclose (fp) == EOF) ? -1 : 0;
+}
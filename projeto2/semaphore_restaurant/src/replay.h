@@ -0,0 +1,245 @@
+/**
+ *  \file replay.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Replay engine: recording and enforcement of the order of the semaphore grants.
+ *
+ *  Defined operations:
+ *     \li size of the area that holds the events
+ *     \li replay engine initialization
+ *     \li setting of its semaphores to their initial value
+ *     \li binding of an entity to the replay engine
+ *     \li <em>down</em> of a semaphore, recorded or replayed
+ *     \li <em>down</em> of a semaphore only if it does not block, recorded or replayed
+ *     \li batch of semaphore operations, recorded or replayed
+ *     \li atomic addition to a shared counter, recorded or replayed
+ *     \li bracketing of any other race (start, recorded outcome and end)
+ *     \li checking whether the next event is the one of the calling entity
+ *     \li loading and saving of a trace.
+ *
+ *  Given the seed and the configuration, the entities only behave differently from one simulation to the next
+ *  because of races: which entity is granted a semaphore first, which ticket it takes from a request queue, the
+ *  outcome of a <em>down</em> or a retrieval that does not block, the value of a claim counter and, in virtual time
+ *  mode, how far the clock jumps. Each of them is an event.
+ *
+ *  In record mode the events are appended to a trace in shared memory, in the order they take place: a grant is
+ *  appended after it is obtained, the other events are carried out with the recording lock held. In replay mode
+ *  each entity waits for its turn, on a semaphore of its own, before each event (the order of the trace), carries
+ *  it out, checks that its outcome is the recorded one and hands the turn to the entity of the next event; a down
+ *  or a retrieval that failed when recorded fails again without being attempted, one that succeeded is retried
+ *  until it succeeds. An outcome that differs is a divergence: it is reported on stderr and the entity fails.
+ *
+ *  An entity that is not bound (see replayAttach), or bound with the engine off, carries out every operation
+ *  directly.
+ */
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "probDataStruct.h"
+#include "semaphore.h"
+
+/** \brief first bytes of a trace file */
+#define  REPLAYMAGIC        "RSTRPLY1"
+
+/** \brief event: <em>down</em> of a semaphore (alone or in a batch) */
+#define  REPLAY_DOWN        1
+/** \brief event: <em>down</em> of a semaphore only if it does not block */
+#define  REPLAY_TRYDOWN     2
+/** \brief event: atomic addition to a shared counter (queue tickets and claim counters) */
+#define  REPLAY_COUNTER     3
+/** \brief event: retrieval of a request only if there is one */
+#define  REPLAY_TRYGET      4
+/** \brief event: jump of the virtual time */
+#define  REPLAY_TICK        5
+
+/** \brief number of entity slots for nw waiters, nc chefs and ng groups (the clock task and the receptionist too) */
+#define  REPLAYSLOTS(nw,nc,ng)   (2 + (nw) + (nc) + (ng))
+
+/** \brief number of semaphores of the replay engine in a given mode, for ns entity slots (lock and turns) */
+#define  REPLAYSEMS(mode,ns)     (((mode) == REPLAY_OFF) ? 0 : 1 + (ns))
+
+/**
+ *  \brief Definition of the header of a trace file.
+ *
+ *  It is followed by the events, in the byte order of the machine.
+ */
+typedef struct {
+    /** \brief REPLAYMAGIC, without the terminating null character */
+    char magic[8];
+    /** \brief seed of the pseudo random number generators of the entities (first run) */
+    unsigned long long seed;
+    /** \brief number of groups */
+    int nGroups;
+    /** \brief number of tables */
+    int nTables;
+    /** \brief number of waiters */
+    int nWaiters;
+    /** \brief number of chefs */
+    int nChefs;
+    /** \brief number of runs */
+    unsigned int runs;
+    /** \brief number of events */
+    unsigned int nEvents;
+} REPLAY_HEADER;
+
+/**
+ *  \brief Size of the area that holds the events.
+ *
+ *  \param capacity number of events
+ *
+ *  \return size in bytes, multiple of CACHELINE
+ */
+extern size_t replaySize (unsigned int capacity);
+
+/**
+ *  \brief Replay engine initialization.
+ *
+ *  Must be called by the generator before the semaphore set is created, which must have the semaphores given by
+ *  REPLAYSEMS from <tt>lock</tt> on. The area must be in the same shared region as the control data.
+ *
+ *  \param rp pointer to the control data
+ *  \param mode REPLAY_OFF, REPLAY_RECORD or REPLAY_PLAY
+ *  \param nWaiters number of waiters
+ *  \param nChefs number of chefs
+ *  \param nGroups number of groups
+ *  \param lock recording lock semaphore, followed by the turn semaphore of every entity slot
+ *  \param area pointer to a location with replaySize(capacity) bytes
+ *  \param capacity room for events (record mode) or number of events to be replayed (replay mode)
+ *  \param event events to be replayed (replay mode)
+ */
+extern void replayInit (REPLAY_SHARED *rp, unsigned int mode, int nWaiters, int nChefs, int nGroups, unsigned int lock,
+                        void *area, unsigned int capacity, REPLAY_EVENT event[]);
+
+/**
+ *  \brief Setting of the semaphores of the replay engine to their initial value.
+ *
+ *  Must be called after every other semaphore of the set is reset: the recording lock is free, or the entity of
+ *  the next event has the turn.
+ *
+ *  \param rp pointer to the control data
+ *  \param semgid semaphore set identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int replayReset (REPLAY_SHARED *rp, int semgid);
+
+/**
+ *  \brief Binding of the calling entity to the replay engine.
+ *
+ *  \param rp pointer to the control data
+ *  \param semgid semaphore set identifier
+ *  \param id id of the calling entity (see ENTITYID; the clock task has the id of the generator)
+ */
+extern void replayAttach (REPLAY_SHARED *rp, int semgid, unsigned int id);
+
+/**
+ *  \brief <em>Down</em> of a semaphore, recorded or replayed.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sindex semaphore index
+ *
+ *  \return as <tt>semDown</tt>
+ */
+extern int replayDown (int semgid, unsigned int sindex);
+
+/**
+ *  \brief <em>Down</em> of a semaphore only if it does not block, recorded or replayed.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param sindex semaphore index
+ *
+ *  \return as <tt>semTryDown</tt>
+ */
+extern int replayTryDown (int semgid, unsigned int sindex);
+
+/**
+ *  \brief Batch of semaphore operations (see semOps), recorded or replayed if it has a <em>down</em>.
+ *
+ *  The batch is not atomic: the <em>ups</em> that precede the first <em>down</em> may be carried out before it
+ *  and the ones that follow the last <em>down</em> after it.
+ *
+ *  \param semgid semaphore set identifier
+ *  \param ops operations
+ *  \param n number of operations
+ *
+ *  \return as <tt>semOps</tt>
+ */
+extern int replayOps (int semgid, SEM_OP ops[], unsigned int n);
+
+/**
+ *  \brief Atomic addition to a shared counter, recorded or replayed.
+ *
+ *  \param counter pointer to the counter
+ *  \param add value added (0 to read the counter)
+ *
+ *  \return value of the counter before the addition
+ */
+extern int replayFetchAdd (int *counter, int add);
+
+/**
+ *  \brief Start of any other race, in the shared region.
+ *
+ *  The race must not block: it is either carried out with the recording lock held or, in replay mode, with the
+ *  turn. It ends with <tt>replayLeave</tt>.
+ *
+ *  \param kind kind of event
+ *  \param object pointer to the object the race takes place on
+ */
+extern void replayEnter (unsigned int kind, void *object);
+
+/**
+ *  \brief Outcome of the race being replayed.
+ *
+ *  \param value pointer to the location where its recorded outcome is stored (replay mode)
+ *
+ *  \return \c true, in replay mode: the race must have the recorded outcome
+ *  \return \c false, if it is carried out freely
+ */
+extern bool replayPlaying (long long *value);
+
+/**
+ *  \brief End of a race started by <tt>replayEnter</tt>, with its outcome.
+ *
+ *  \param value outcome of the race
+ */
+extern void replayLeave (long long value);
+
+/**
+ *  \brief Checking whether the next event to be replayed is one of the calling entity.
+ *
+ *  \return \c true, if so, or if nothing is being replayed
+ *  \return \c false, otherwise
+ */
+extern bool replayTurn (void);
+
+/**
+ *  \brief Loading of a trace file.
+ *
+ *  \param path name of the trace file
+ *  \param hd pointer to the location where the header is stored
+ *  \param event pointer to the location where a pointer to the events, allocated with malloc, is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the file could not be read or is wrong (the error is reported on stderr)
+ */
+extern int replayLoad (char path[], REPLAY_HEADER *hd, REPLAY_EVENT **event);
+
+/**
+ *  \brief Saving of the recorded events as a trace file.
+ *
+ *  \param path name of the trace file
+ *  \param hd pointer to the header (its number of events is set)
+ *  \param rp pointer to the control data
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int replaySave (char path[], REPLAY_HEADER *hd, REPLAY_SHARED *rp);
+
+#endif /* REPLAY_H_ */
@@ -0,0 +1,182 @@
+/**
+ *  \file requestQueue.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Bounded request queues in shared memory (many producers, many consumers).
+ *
+ *  Defined operations:
+ *     \li queue initialization
+ *     \li insertion of a request at the end of the queue
+ *     \li retrieval of the request at the head of the queue
+ *     \li retrieval of the request at the head of the queue, if there is one
+ *     \li number of requests in the queue.
+ *
+ *  Each slot carries a sequence number: producer with ticket t may fill slot t%size when its sequence number
+ *  is t and the consumer with ticket t may empty it when it is t+1. A slot may still be being filled or emptied when the
+ *  counting semaphores already allow its use; in that case the caller yields until it is released. The tickets and the
+ *  outcome of the retrievals that do not block are recorded or replayed by the replay engine (see replay.h).
+ */
+
+#include <stdbool.h>
+#include <sched.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "requestQueue.h"
+#include "replay.h"
+
+/** \brief slots of queue q */
+#define  SLOTS(q)   SHARRAY(q, (q)->offSlot, REQ_SLOT)
+
+/* internal functions */
+
+/** \brief ticket of a producer or a consumer */
+static unsigned int takeTicket (unsigned int *counter)
+{
+    unsigned int t;
+
+    replayEnter (REPLAY_COUNTER, counter);
+    t = __atomic_fetch_add (counter, 1, __ATOMIC_ACQ_REL);
+    replayLeave (t);
+    return t;
+}
+
+/** \brief retrieval of the request at the head of the queue, if there is one (see queueTryGet) */
+static bool tryGet (REQ_QUEUE *q, request *req)
+{
+    unsigned int t = __atomic_load_n (&q->tail, __ATOMIC_ACQUIRE);
+    REQ_SLOT *slot;
+    int d;
+
+    while (true) {
+        slot = &SLOTS(q)[t % q->size];
+        d = (int) (__atomic_load_n (&slot->seq, __ATOMIC_ACQUIRE) - (t + 1));
+        if (d < 0) {                                                                   /* not yet filled: empty */
+            return false;
+        }
+        if ((d == 0) && __atomic_compare_exchange_n (&q->tail, &t, t + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        if (d > 0) {                                                   /* ticket taken by another consumer */
+            t = __atomic_load_n (&q->tail, __ATOMIC_ACQUIRE);
+        }
+    }
+    *req = slot->req;
+    __atomic_store_n (&slot->seq, t + q->size, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/* external functions */
+
+/**
+ *  \brief Queue initialization.
+ *
+ *  The slots must be located in the same shared region as the queue.
+ *
+ *  \param q pointer to the queue
+ *  \param size number of slots (>= 1)
+ *  \param slots pointer to the storage of the slots
+ */
+void queueInit (REQ_QUEUE *q, unsigned int size, REQ_SLOT *slots)
+{
+    unsigned int i;
+
+    q->size = size;
+    q->head = 0;
+    q->tail = 0;
+    q->offSlot = (unsigned int) ((char *) slots - (char *) q);
+    for (i = 0; i < size; i++) {
+        slots[i].seq = i;
+    }
+}
+
+/**
+ *  \brief Insertion of a request at the end of the queue.
+ *
+ *  A slot is reserved with an atomic increment, so producers do not exclude each other.
+ *
+ *  \param q pointer to the queue
+ *  \param req request to be inserted
+ */
+void queuePut (REQ_QUEUE *q, request req)
+{
+    unsigned int t = takeTicket (&q->head);
+    REQ_SLOT *slot = &SLOTS(q)[t % q->size];
+
+    while (__atomic_load_n (&slot->seq, __ATOMIC_ACQUIRE) != t) {
+        sched_yield ();
+    }
+    slot->req = req;
+    __atomic_store_n (&slot->seq, t + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ *  \brief Retrieval of the request at the head of the queue.
+ *
+ *  A slot is reserved with an atomic increment, so consumers do not exclude each other.
+ *
+ *  \param q pointer to the queue
+ *
+ *  \return request at the head of the queue
+ */
+request queueGet (REQ_QUEUE *q)
+{
+    unsigned int t = takeTicket (&q->tail);
+    REQ_SLOT *slot = &SLOTS(q)[t % q->size];
+    request req;
+
+    while (__atomic_load_n (&slot->seq, __ATOMIC_ACQUIRE) != t + 1) {
+        sched_yield ();
+    }
+    req = slot->req;
+    __atomic_store_n (&slot->seq, t + q->size, __ATOMIC_RELEASE);
+
+    return req;
+}
+
+/**
+ *  \brief Retrieval of the request at the head of the queue, if there is one.
+ *
+ *  Unlike <tt>queueGet</tt>, does not rely on a counting semaphore: a consumer that was allowed to take a request
+ *  from one of several queues tries each of them in turn. The queue must not be emptied by <tt>queueGet</tt> as well.
+ *
+ *  \param q pointer to the queue
+ *  \param req pointer to the location where the request is stored
+ *
+ *  \return \c true, if a request was retrieved
+ *  \return \c false, if the queue is empty (or its head request is still being inserted)
+ */
+bool queueTryGet (REQ_QUEUE *q, request *req)
+{
+    long long got;
+    bool found;
+
+    replayEnter (REPLAY_TRYGET, &q->tail);
+    if (replayPlaying (&got)) {
+        if ((found = (got != 0))) {                         /* the head request may still be being inserted */
+            while (!tryGet (q, req)) {
+                sched_yield ();
+            }
+        }
+    }
+    else found = tryGet (q, req);
+    replayLeave (found);
+
+    return found;
+}
+
+/**
+ *  \brief Number of requests in the queue.
+ *
+ *  Only a snapshot: requests may be inserted and retrieved meanwhile.
+ *
+ *  \param q pointer to the queue
+ *
+ *  \return number of requests inserted (or being inserted) and not yet retrieved
+ */
+unsigned int queueDepth (REQ_QUEUE *q)
+{
+    return __atomic_load_n (&q->head, __ATOMIC_RELAXED) - __atomic_load_n (&q->tail, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,83 @@
+/**
+ *  \file requestQueue.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Bounded request queues in shared memory (many producers, many consumers).
+ *
+ *  Defined operations:
+ *     \li queue initialization
+ *     \li insertion of a request at the end of the queue
+ *     \li retrieval of the request at the head of the queue
+ *     \li retrieval of the request at the head of the queue, if there is one
+ *     \li number of requests in the queue.
+ *
+ *  Operations do not block on the queue state: producers must first make sure there is a free slot and the
+ *  consumers that there is a pending request (a counting semaphore for each is the intended use).
+ */
+
+#ifndef REQUESTQUEUE_H_
+#define REQUESTQUEUE_H_
+
+#include <stdbool.h>
+
+#include "probDataStruct.h"
+
+/**
+ *  \brief Queue initialization.
+ *
+ *  The slots must be located in the same shared region as the queue.
+ *
+ *  \param q pointer to the queue
+ *  \param size number of slots (>= 1)
+ *  \param slots pointer to the storage of the slots
+ */
+extern void queueInit (REQ_QUEUE *q, unsigned int size, REQ_SLOT *slots);
+
+/**
+ *  \brief Insertion of a request at the end of the queue.
+ *
+ *  A slot is reserved with an atomic increment, so producers do not exclude each other.
+ *
+ *  \param q pointer to the queue
+ *  \param req request to be inserted
+ */
+extern void queuePut (REQ_QUEUE *q, request req);
+
+/**
+ *  \brief Retrieval of the request at the head of the queue.
+ *
+ *  A slot is reserved with an atomic increment, so consumers do not exclude each other.
+ *
+ *  \param q pointer to the queue
+ *
+ *  \return request at the head of the queue
+ */
+extern request queueGet (REQ_QUEUE *q);
+
+/**
+ *  \brief Retrieval of the request at the head of the queue, if there is one.
+ *
+ *  Unlike <tt>queueGet</tt>, does not rely on a counting semaphore: a consumer that was allowed to take a request
+ *  from one of several queues tries each of them in turn. The queue must not be emptied by <tt>queueGet</tt> as well.
+ *
+ *  \param q pointer to the queue
+ *  \param req pointer to the location where the request is stored
+ *
+ *  \return \c true, if a request was retrieved
+ *  \return \c false, if the queue is empty (or its head request is still being inserted)
+ */
+extern bool queueTryGet (REQ_QUEUE *q, request *req);
+
+/**
+ *  \brief Number of requests in the queue.
+ *
+ *  Only a snapshot: requests may be inserted and retrieved meanwhile.
+ *
+ *  \param q pointer to the queue
+ *
+ *  \return number of requests inserted (or being inserted) and not yet retrieved
+ */
+extern unsigned int queueDepth (REQ_QUEUE *q);
+
+#endif /* REQUESTQUEUE_H_ */
@@ -0,0 +1,124 @@
+/**
+ *  \file runControl.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Control of the runs of the server mode.
+ *
+ *  Defined operations:
+ *     \li control data initialization
+ *     \li start of a run (generator)
+ *     \li waiting for the start of a run and signalling its end (entities)
+ *     \li waiting for the end of a run (generator).
+ *
+ *  The present run number and the number of entities that finished it are futex words: entities wait for the
+ *  first to reach their run, the generator for the second to reach the number of entities.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "probDataStruct.h"
+#include "runControl.h"
+
+/* internal functions */
+
+static long futex (int *addr, int op, int val)
+{
+    return syscall (SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+/* external functions */
+
+/**
+ *  \brief Control data initialization; the first run is the present one.
+ *
+ *  Must be called by the generator before any entity is launched.
+ *
+ *  \param r pointer to the control data
+ *  \param runs number of runs
+ *  \param nEntities number of entities
+ *  \param nFic name of the logging file of the first run
+ */
+void runInit (RUN_CONTROL *r, unsigned int runs, int nEntities, char nFic[])
+{
+    r->runs = runs;
+    r->nEntities = nEntities;
+    strncpy (r->logName, nFic, sizeof (r->logName) - 1);
+    r->logName[sizeof (r->logName) - 1] = '\0';
+    r->run = 0;
+    r->done = 0;
+}
+
+/**
+ *  \brief Start of a run, releasing the entities that wait for it.
+ *
+ *  \param r pointer to the control data
+ *  \param run run number (1 .. runs-1)
+ *  \param nFic name of the logging file of the run
+ */
+void runStart (RUN_CONTROL *r, unsigned int run, char nFic[])
+{
+    strncpy (r->logName, nFic, sizeof (r->logName) - 1);
+    r->logName[sizeof (r->logName) - 1] = '\0';
+    __atomic_store_n (&r->done, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n (&r->run, (int) run, __ATOMIC_SEQ_CST);
+    futex (&r->run, FUTEX_WAKE, __INT_MAX__);
+}
+
+/**
+ *  \brief Waiting for the start of a run.
+ *
+ *  \param r pointer to the control data
+ *  \param run run number (0 .. runs-1)
+ *  \param nFic pointer to the location where the name of the logging file of the run is stored
+ */
+void runBegin (RUN_CONTROL *r, unsigned int run, char nFic[])
+{
+    int now;
+
+    while ((now = __atomic_load_n (&r->run, __ATOMIC_SEQ_CST)) != (int) run) {
+        futex (&r->run, FUTEX_WAIT, now);                           /* returns on wake up, EAGAIN or EINTR */
+    }
+    strcpy (nFic, r->logName);
+}
+
+/**
+ *  \brief Signalling that the calling entity has finished the present run.
+ *
+ *  \param r pointer to the control data
+ */
+void runEnd (RUN_CONTROL *r)
+{
+    if (__atomic_add_fetch (&r->done, 1, __ATOMIC_SEQ_CST) == r->nEntities) {
+        futex (&r->done, FUTEX_WAKE, __INT_MAX__);
+    }
+}
+
+/**
+ *  \brief Waiting until every entity has finished the present run, for a limited time.
+ *
+ *  Allows the generator to check the entities while a run goes on.
+ *
+ *  \param r pointer to the control data
+ *  \param ms longest time to wait (in ms)
+ *
+ *  \return true, if every entity finished the run; false, if the time elapsed first
+ */
+bool runWait (RUN_CONTROL *r, unsigned int ms)
+{
+    struct timespec tmo = { ms / 1000, (ms % 1000) * 1000000L };
+    int done;
+
+    while ((done = __atomic_load_n (&r->done, __ATOMIC_SEQ_CST)) < r->nEntities) {
+        if ((syscall (SYS_futex, &r->done, FUTEX_WAIT, done, &tmo, NULL, 0) == -1) && (errno == ETIMEDOUT)) {
+            return __atomic_load_n (&r->done, __ATOMIC_SEQ_CST) == r->nEntities;
+        }
+    }
+    return true;
+}
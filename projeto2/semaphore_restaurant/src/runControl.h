@@ -0,0 +1,76 @@
+/**
+ *  \file runControl.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Control of the runs of the server mode.
+ *
+ *  Defined operations:
+ *     \li control data initialization
+ *     \li start of a run (generator)
+ *     \li waiting for the start of a run and signalling its end (entities)
+ *     \li waiting for the end of a run (generator).
+ *
+ *  In server mode the entities are launched once and carry out several simulations back to back. Between two
+ *  runs they wait for the generator, that resets the full state and the semaphores in place. The waits use
+ *  futexes on the control data, not semaphores of the set, so that they are not taken as blocked entities by the
+ *  virtual time clock.
+ */
+
+#ifndef RUNCONTROL_H_
+#define RUNCONTROL_H_
+
+#include <stdbool.h>
+
+#include "probDataStruct.h"
+
+/**
+ *  \brief Control data initialization; the first run is the present one.
+ *
+ *  Must be called by the generator before any entity is launched.
+ *
+ *  \param r pointer to the control data
+ *  \param runs number of runs
+ *  \param nEntities number of entities
+ *  \param nFic name of the logging file of the first run
+ */
+extern void runInit (RUN_CONTROL *r, unsigned int runs, int nEntities, char nFic[]);
+
+/**
+ *  \brief Start of a run, releasing the entities that wait for it.
+ *
+ *  \param r pointer to the control data
+ *  \param run run number (1 .. runs-1)
+ *  \param nFic name of the logging file of the run
+ */
+extern void runStart (RUN_CONTROL *r, unsigned int run, char nFic[]);
+
+/**
+ *  \brief Waiting for the start of a run.
+ *
+ *  \param r pointer to the control data
+ *  \param run run number (0 .. runs-1)
+ *  \param nFic pointer to the location where the name of the logging file of the run is stored
+ */
+extern void runBegin (RUN_CONTROL *r, unsigned int run, char nFic[]);
+
+/**
+ *  \brief Signalling that the calling entity has finished the present run.
+ *
+ *  \param r pointer to the control data
+ */
+extern void runEnd (RUN_CONTROL *r);
+
+/**
+ *  \brief Waiting until every entity has finished the present run, for a limited time.
+ *
+ *  Allows the generator to check the entities while a run goes on.
+ *
+ *  \param r pointer to the control data
+ *  \param ms longest time to wait (in ms)
+ *
+ *  \return true, if every entity finished the run; false, if the time elapsed first
+ */
+extern bool runWait (RUN_CONTROL *r, unsigned int ms);
+
+#endif /* RUNCONTROL_H_ */
@@ -0,0 +1,53 @@
+/**
+ *  \file schedCompiler.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  Compiler of configuration files into binary schedules.
+ *
+ *  Loads a configuration file as the generator does (see config.h) and saves it as a binary schedule, from
+ *  which the generator takes the start and eat times of the groups with no parsing (option -f). A generated
+ *  workload becomes the schedule it generates.
+ *
+ *  Upon execution, two parameters are accepted:
+ *    \li name of the configuration file (config.txt if missing)
+ *    \li name of the binary schedule (config.bin if missing).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+
+/**
+ *  \brief Main program.
+ */
+int main (int argc, char *argv[])
+{
+    char *nCfg = "config.txt",                                                        /* configuration file name */
+         *nSched = "config.bin";                                                         /* binary schedule name */
+    CONFIG cf;
+
+    if (argc > 3) {
+        fprintf (stderr, "USAGE: %s [configfile [schedulefile]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > 1) {
+        nCfg = argv[1];
+    }
+    if (argc > 2) {
+        nSched = argv[2];
+    }
+
+    if (configLoad (nCfg, &cf) == -1) {
+        return EXIT_FAILURE;
+    }
+    if (configSave (nSched, &cf) == -1) {
+        perror ("error on saving the binary schedule");
+        return EXIT_FAILURE;
+    }
+    printf ("%s: %d groups, %d tables\n", nSched, cf.nGroups, cf.nTables);
+    configFree (&cf);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,332 @@
+/**
+ *  \file semBench.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  Microbenchmarks of the synchronization primitives used by the simulation.
+ *  The semaphore implementation is the one the binary is built with (see SEM in the Makefile).
+ *
+ *  Benchmarks:
+ *    \li sem_uncontended: <em>down</em> and <em>up</em> of a free lock by a single process
+ *    \li sem_contended: the same by several processes sharing the lock
+ *    \li request_handoff: a producer and a consumer process exchanging requests through a one slot request
+ *        queue, as orderFood and waitForClientOrChef do
+ *    \li savestate_file and savestate_stdout: saveState of the full state of a restaurant in text mode
+ *    \li savestate_mmap: the same in memory mapped mode.
+ *
+ *  Results are written one per line, in CSV format: benchmark,config,ops,ns_per_op,ops_per_sec.
+ *
+ *  Upon execution, the name of the results file is requested (stdout if absent; the savestate_stdout
+ *  benchmark writes on stdout as well).
+ *
+ *  Options:
+ *    \li -n number number of operations of each benchmark (default 100000; saveState benchmarks do a tenth)
+ *    \li -p number number of processes of sem_contended (default 4)
+ *    \li -g number number of groups of the saveState benchmarks (default 16).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+
+#include "probConst.h"
+#include "probDataStruct.h"
+#include "logging.h"
+#include "semaphore.h"
+#include "sharedMemory.h"
+#include "requestQueue.h"
+
+/** \brief number of semaphores of the benchmark set */
+#define  BENCHSEMS         3
+
+/** \brief lock semaphore id */
+#define  BLOCK             1
+/** \brief pending requests semaphore id */
+#define  BREQ              2
+/** \brief free request queue slots semaphore id */
+#define  BREQPOSSIBLE      3
+
+/** \brief name of the logging file of the savestate_file and savestate_mmap benchmarks */
+#define  BENCHLOG          "bench_log.txt"
+
+/**
+ *  \brief Definition of the shared region of the benchmarks.
+ */
+typedef struct {
+    /** \brief request queue of request_handoff */
+    REQ_QUEUE q;
+    /** \brief its single slot */
+    REQ_SLOT slot[1];
+    /** \brief storage of the semaphore values (futex implementation) */
+    SEM_WORD words[BENCHSEMS + SEM_EXTRA];
+} BENCH_SHARED;
+
+/** \brief access key to shared memory and semaphore set */
+static int key;
+
+/** \brief semaphore set access identifier */
+static int semgid;
+
+/** \brief pointer to shared memory region */
+static BENCH_SHARED *sh;
+
+/* internal functions */
+
+/** \brief monotonic clock (in ns) */
+static unsigned long long nowNs (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/** \brief printing of a result line */
+static void report (FILE *fp, char *bench, char *config, long ops, unsigned long long ns)
+{
+    fprintf (fp, "%s,%s,%ld,%.1f,%.0f\n", bench, config, ops, (double) ns / ops, ops * 1e9 / ns);
+    fflush (fp);
+}
+
+static void semCheck (int stat)
+{
+    if (stat == -1) {
+        perror ("error on the operation for semaphore access");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/** \brief lock and unlock cycles */
+static void lockTask (int p, long n)
+{
+    long i;
+
+    for (i = 0; i < n; i++) {
+        semCheck (semDown (semgid, BLOCK));
+        semCheck (semUp (semgid, BLOCK));
+    }
+}
+
+/** \brief request handoff: process 0 produces the requests, process 1 consumes them */
+static void handoffTask (int p, long n)
+{
+    request req = { FOODREQ, 0 };
+    long i;
+
+    for (i = 0; i < n; i++) {
+        if (p == 0) {
+            semCheck (semDown (semgid, BREQPOSSIBLE));
+            req.reqGroup = i & 0xFFF;
+            queuePut (&sh->q, req);
+            semCheck (semUp (semgid, BREQ));
+        }
+        else {
+            semCheck (semDown (semgid, BREQ));
+            req = queueGet (&sh->q);
+            semCheck (semUp (semgid, BREQPOSSIBLE));
+        }
+    }
+}
+
+/**
+ *  \brief Running of a semaphore benchmark.
+ *
+ *  A fresh semaphore set is created, with the lock and one free queue slot, and the processes are released at the
+ *  same time by the start of operations signal.
+ *
+ *  \return elapsed time (in ns)
+ */
+static unsigned long long runBench (int nProc, void (*task) (int, long), long n)
+{
+    unsigned long long t0;
+    int p, status;
+
+    semBind (sh->words, BENCHSEMS + SEM_EXTRA);
+    if ((semgid = semCreate (key, BENCHSEMS)) == -1) {
+        perror ("error on creating the semaphore set");
+        exit (EXIT_FAILURE);
+    }
+    semCheck (semUp (semgid, BLOCK));
+    semCheck (semUp (semgid, BREQPOSSIBLE));
+    queueInit (&sh->q, 1, sh->slot);
+
+    for (p = 0; p < nProc; p++) {
+        switch (fork ()) {
+            case -1:
+                perror ("error on the generation of the benchmark process");
+                exit (EXIT_FAILURE);
+            case 0:
+                semCheck (semConnect (key));                                /* waits for the start of operations */
+                task (p, n);
+                exit (EXIT_SUCCESS);
+        }
+    }
+
+    t0 = nowNs ();
+    semCheck (semSignal (semgid));
+    for (p = 0; p < nProc; p++) {
+        if ((wait (&status) == -1) || !WIFEXITED (status) || (WEXITSTATUS (status) != EXIT_SUCCESS)) {
+            fprintf (stderr, "A benchmark process failed!\n");
+            exit (EXIT_FAILURE);
+        }
+    }
+    t0 = nowNs () - t0;
+
+    semCheck (semDestroy (semgid));
+    return t0;
+}
+
+/**
+ *  \brief Running of a saveState benchmark.
+ *
+ *  \param mode logging mode (LOGTEXT or LOGMAPPED)
+ *
+ *  \return elapsed time (in ns)
+ */
+static unsigned long long runSaveState (char nFic[], int nGroups, long n, unsigned int mode)
+{
+    size_t ctlSize = ALIGNCL(sizeof (LOG_SHARED)),
+           fStSize = ALIGNCL(sizeof (FULL_STAT) + (4 + 4 * nGroups) * sizeof (int));       /* packed group arrays */
+    LOG_SHARED *ctl;                                                              /* private logging control data */
+    FULL_STAT *fSt;
+    unsigned long long t0;
+    long i;
+    int g, errFd, nullFd;
+
+    if ((fSt = aligned_alloc (CACHELINE, fStSize)) == NULL) {
+        perror ("error on allocating the full state");
+        exit (EXIT_FAILURE);
+    }
+    memset (fSt, 0, fStSize);
+    fSt->nGroups = nGroups;
+    fSt->nTables = DEFTABLES;
+    fSt->offGroupStat = sizeof (FULL_STAT);
+    fSt->stride = sizeof (unsigned int);
+    fSt->offSeq = fSt->offGroupStat + nGroups * sizeof (unsigned int);
+    fSt->offAssignedTable = fSt->offSeq + (2 + nGroups) * sizeof (unsigned int);
+    for (g = 0; g < nGroups; g++) {
+        GROUPSTAT(fSt,g) = GOTOREST;
+        ASSIGNEDTABLE(fSt)[g] = -1;
+    }
+    if ((ctl = aligned_alloc (CACHELINE, ctlSize + logSize (nGroups))) == NULL) {
+        perror ("error on allocating the logging control data");
+        exit (EXIT_FAILURE);
+    }
+    logInit (ctl, mode, nGroups, (char *) ctl + ctlSize);
+
+    /* openLog reports every opening of a log file on stderr */
+    fflush (stderr);
+    if (((errFd = dup (STDERR_FILENO)) == -1) || ((nullFd = open ("/dev/null", O_WRONLY)) == -1) ||
+        (dup2 (nullFd, STDERR_FILENO) == -1)) {
+        perror ("error on redirecting stderr");
+        exit (EXIT_FAILURE);
+    }
+    createLog (nFic, fSt);
+    t0 = nowNs ();
+    for (i = 0; i < n; i++) {
+        GROUPSTAT(fSt,i % nGroups) = 1 + i % LEAVING;
+        saveState (nFic, fSt);
+    }
+    t0 = nowNs () - t0;
+    logClose (ctl);
+    fflush (stderr);
+    dup2 (errFd, STDERR_FILENO);
+    close (errFd);
+    close (nullFd);
+
+    free (ctl);
+    free (fSt);
+    return t0;
+}
+
+/**
+ *  \brief Main program.
+ */
+int main (int argc, char *argv[])
+{
+    FILE *res = stdout;                                                                             /* results file */
+    long n = 100000;                                                                     /* operations per benchmark */
+    int nProc = 4,                                                                 /* processes of sem_contended */
+        nGroups = 16;                                                       /* groups of the saveState benchmarks */
+    int shmid, opt;
+    char *tinp;                                                                /* numerical parameters test flag */
+    char config[32];
+
+    while ((opt = getopt (argc, argv, "n:p:g:")) != -1) {
+        switch (opt) {
+            case 'n':
+                n = strtol (optarg, &tinp, 0);
+                if ((*tinp != '\0') || (n < 10)) {
+                    fprintf (stderr, "Number of operations must be at least 10!\n");
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'p':
+                nProc = (int) strtol (optarg, &tinp, 0);
+                if ((*tinp != '\0') || (nProc < 2)) {
+                    fprintf (stderr, "Number of processes must be at least 2!\n");
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'g':
+                nGroups = (int) strtol (optarg, &tinp, 0);
+                if ((*tinp != '\0') || (nGroups < 1) || (nGroups > MAXGROUPS)) {
+                    fprintf (stderr, "Number of groups must be in 1 .. %d!\n", MAXGROUPS);
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            default:
+                fprintf (stderr, "USAGE: %s [-n ops] [-p processes] [-g groups] [resultsfile]\n", argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if ((optind == argc - 1) && ((res = fopen (argv[optind], "w")) == NULL)) {
+        perror ("error on opening the results file");
+        exit (EXIT_FAILURE);
+    }
+
+    if ((key = ftok (".", 'b')) == -1) {
+        perror ("error on generating the key");
+        exit (EXIT_FAILURE);
+    }
+    if ((shmid = shmemCreate (key, sizeof (BENCH_SHARED))) == -1) {
+        perror ("error on creating the shared memory region");
+        exit (EXIT_FAILURE);
+    }
+    if (shmemAttach (shmid, (void **) &sh) == -1) {
+        perror ("error on mapping the shared region on the process address space");
+        exit (EXIT_FAILURE);
+    }
+
+    fprintf (res, "benchmark,config,ops,ns_per_op,ops_per_sec\n");
+    fflush (res);                                                  /* not to be repeated by the benchmark processes */
+    report (res, "sem_uncontended", "processes=1", n, runBench (1, lockTask, n));
+    sprintf (config, "processes=%d", nProc);
+    report (res, "sem_contended", config, n * nProc, runBench (nProc, lockTask, n));
+    report (res, "request_handoff", "processes=2", n, runBench (2, handoffTask, n));
+    sprintf (config, "groups=%d", nGroups);
+    report (res, "savestate_file", config, n / 10, runSaveState (BENCHLOG, nGroups, n / 10, LOGTEXT));
+    report (res, "savestate_mmap", config, n / 10, runSaveState (BENCHLOG, nGroups, n / 10, LOGMAPPED));
+    unlink (BENCHLOG);
+    report (res, "savestate_stdout", config, n / 10, runSaveState ("", nGroups, n / 10, LOGTEXT));
+
+    if (shmemDettach (sh) == -1) {
+        perror ("error on unmapping the shared region off the process address space");
+        exit (EXIT_FAILURE);
+    }
+    if (shmemDestroy (shmid) == -1) {
+        perror ("error on destructing the shared region");
+        exit (EXIT_FAILURE);
+    }
+    if (res != stdout) {
+        fclose (res);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -6,7 +6,7 @@
  *  Synchronization based on semaphores and shared memory.
  *  Implementation with SVIPC.
  *
- *  Definition of the operations carried out by the chef:
+ *  Definition of the operations carried out by the chefs:
  *     \li waitOrder
  *     \li processOrder
  *
@@ -30,22 +30,36 @@
 #include "sharedDataSync.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "requestQueue.h"
+#include "simClock.h"
+#include "latency.h"
+#include "replay.h"
+#include "profile.h"
+#include "liveStats.h"
+#include "runControl.h"
+#include "prng.h"
 
 
 /** \brief logging file name */
-static char nFic[51];
+static __thread char nFic[51];
 
 /** \brief shared memory block access identifier */
-static int shmid;
+static __thread int shmid;
 
 /** \brief semaphore set access identifier */
-static int semgid;
+static __thread int semgid;
+
+/** \brief chef id */
+static __thread int id;
 
 /** \brief group that requested cooking food */
-static int lastGroup;
+static __thread int lastGroup;
 
 /** \brief pointer to shared memory region */
-static SHARED_DATA *sh;
+static __thread SHARED_DATA *sh;
+
+/** \brief random generator of the chef */
+static __thread PRNG rng;
 
 static void waitForOrder ();
 static void processOrder ();
@@ -53,37 +67,41 @@ static void processOrder ();
 /**
  *  \brief Main program.
  *
- *  Its role is to generate the life cycle of one of intervening entities in the problem: the chef.
+ *  Its role is to generate the life cycle of one of intervening entities in the problem: a chef.
  */
 int main (int argc, char *argv[])
 {
     int key;                                          /*access key to shared memory and semaphore set */
     char *tinp;                                                     /* numerical parameters test flag */
+    unsigned int run;                                                                   /* run number */
 
     /* validation of command line parameters */
 
-    if (argc != 4) { 
+    if (argc != 5) { 
         freopen ("error_CH", "a", stderr);
         fprintf (stderr, "Number of parameters is incorrect!\n");
         return EXIT_FAILURE;
     }
     else {
-       freopen (argv[3], "w", stderr);
+#ifndef ENGINE_THREADS
+       freopen (argv[4], "w", stderr);                           /* threads share the stderr of the generator */
+#endif
        setbuf(stderr,NULL);
     }
-    strcpy (nFic, argv[1]);
-    key = (unsigned int) strtol (argv[2], &tinp, 0);
+    id = (unsigned int) strtol (argv[1], &tinp, 0);
+    if ((*tinp != '\0') || (id >= MAXGROUPS)) {
+        fprintf (stderr, "Chef process identification is wrong!\n");
+        return EXIT_FAILURE;
+    }
+    strcpy (nFic, argv[2]);
+    key = (unsigned int) strtol (argv[3], &tinp, 0);
     if (*tinp != '\0') {
         fprintf (stderr, "Error on the access key communication!\n");
         return EXIT_FAILURE;
     }
 
-    /* connection to the semaphore set and the shared memory region and mapping the shared region onto the
-       process address space */
-    if ((semgid = semConnect (key)) == -1) { 
-        perror ("error on connecting to the semaphore set");
-        return EXIT_FAILURE;
-    }
+    /* connection to the shared memory region, mapping the shared region onto the process address space and
+       connection to the semaphore set */
     if ((shmid = shmemConnect (key)) == -1) { 
         perror ("error on connecting to the shared memory region");
         return EXIT_FAILURE;
@@ -92,18 +110,37 @@ int main (int argc, char *argv[])
         perror ("error on mapping the shared region on the process address space");
         return EXIT_FAILURE;
     }
+    semBind (SEMWORDS, SEM_SLOTS);
+    if ((semgid = semConnect (key)) == -1) { 
+        perror ("error on connecting to the semaphore set");
+        return EXIT_FAILURE;
+    }
+    /* life cycles of the entity, one per run of the simulation (see runControl.h) */
+    for (run = 0; run < sh->run.runs; run++) {
+        runBegin (&sh->run, run, nFic);
+        logAttach (&sh->log, ENTITYID(ENT_CHEF, id));
+        clockAttach (&sh->clock);
+        latAttach (&sh->lat);
+        replayAttach (&sh->replay, semgid, ENTITYID(ENT_CHEF, id));
+        profAttach (&sh->prof, ENTITYID(ENT_CHEF, id), run);
 
-    /* initialize random generator */
-    srandom ((unsigned int) getpid ());                                      
+        /* initialize random generator */
+        prngSeed (&rng, sh->seed, ENTITYID(ENT_CHEF, id));
 
-    /* simulation of the life cycle of the chef */
+        /* simulation of the life cycle of the chef: there is one order per group and a chef claims one of them
+           before waiting for it */
 
-    int nOrders=0;
-    while(nOrders < sh->fSt.nGroups) {
-       waitForOrder();
-       processOrder();
+        while (replayFetchAdd (&sh->fSt.chefClaims, 1) < sh->fSt.nGroups) {
+           profBegin (PROF_WAITFORORDER);
+           waitForOrder();
+           profEnd ();
+           profBegin (PROF_PROCESSORDER);
+           processOrder();
+           profEnd ();
+        }
 
-       nOrders++;
+        clockDetach ();
+        runEnd (&sh->run);
     }
 
     /* unmapping the shared region off the process address space */
@@ -119,36 +156,38 @@ int main (int argc, char *argv[])
 /**
  *  \brief chefs wait for a food order.
  *
- *  The chef waits for the food request that will be provided by the waiter.
+ *  The chef waits for the food request that will be provided by the waiter and takes it from the order
+ *  queue, releasing its slot.
  *  Updates its state and saves internal state.
- *  Received order should be acknowledged.
  */
 static void waitForOrder () {
 
     //TODO insert your code here
-    if (semDown (semgid, sh->waitOrder) == -1) {                                                      
+    if (latDown (semgid, sh->waitOrder, LAT_WAITORDER) == -1) {                                                      
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                      
+    lastGroup = queueGet (&sh->fSt.orderRequest).reqGroup;
+
+    if (semUp (semgid, sh->orderRequestPossible) == -1) {
+        perror ("error on the up operation for semaphore access (PT)");
+        exit (EXIT_FAILURE);
+    }
+
+    if (latDown (semgid, sh->kitchenLock, LAT_KITCHENLOCK) == -1) {                                                      
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
     //TODO insert your code here
 
-    lastGroup = sh->fSt.foodGroup;
-    sh->fSt.foodOrder = 0;
+    stateBegin (&sh->fSt, DOM_KITCHEN);
     sh->fSt.st.chefStat = COOK;
+    stateEnd (&sh->fSt, DOM_KITCHEN);
     saveState(nFic, &sh->fSt);
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                      
-        perror ("error on the up operation for semaphore access (PT)");
-        exit (EXIT_FAILURE);
-    }
-
-    if (semUp (semgid, sh->orderReceived) == -1) {                                                      
+    if (latUp (semgid, sh->kitchenLock, LAT_HOLD_WAITFORORDER) == -1) {                                                      
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
@@ -160,43 +199,53 @@ static void waitForOrder () {
  *  \brief chef cooks, then delivers the food to the waiter 
  *
  *  The chef takes some time to cook and signals the waiter that food is 
- *  ready (this may only happen when waiter is available)
+ *  ready (this may only happen when there is room in the waiter queue, unless the kitchen is pipelined:
+ *  then the dish goes to the ready queue, that is never full)
  *  then updates its state.
  *  The internal state should be saved.
  */
 static void processOrder ()
 {
-    usleep((unsigned int) floor ((MAXCOOK * random ()) / RAND_MAX + 100.0));
+    request req;
+
+    clockSleep ((unsigned int) floor (MAXCOOK * prngUniform (&rng) + 100.0));
 
     //TODO insert your code here
 
-    if (semDown (semgid, sh->waiterRequestPossible) == -1) {                                                      
+    if (!sh->pipelined && (latDown (semgid, sh->waiterRequestPossible, LAT_WAITERREQUESTPOSSIBLE) == -1)) {                                                      
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                      
+    if (latDown (semgid, sh->kitchenLock, LAT_KITCHENLOCK) == -1) {                                                      
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
     //TODO insert your code here
-    sh->fSt.waiterRequest.reqType = FOODREADY;
-    sh->fSt.waiterRequest.reqGroup = lastGroup;
+    req.reqType = FOODREADY;
+    req.reqGroup = lastGroup;
+    if (sh->pipelined) {
+        queuePut (&sh->fSt.readyRequest, req);
+        latDepth (LAT_DEPTH_READY, queueDepth (&sh->fSt.readyRequest));
+    }
+    else {
+        queuePut (&sh->fSt.waiterRequest, req);
+        latDepth (LAT_DEPTH_WAITER, queueDepth (&sh->fSt.waiterRequest));
+    }
+    stateBegin (&sh->fSt, DOM_KITCHEN);
     sh->fSt.st.chefStat = WAIT_FOR_ORDER;
+    stateEnd (&sh->fSt, DOM_KITCHEN);
 
     saveState(nFic, &sh->fSt);
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                      
-        perror ("error on the up operation for semaphore access (PT)");
-        exit (EXIT_FAILURE);
-    }
-
-    if (semUp (semgid, sh->waiterRequest) == -1) {                                                      
+    if (latOps (semgid, (SEM_OP []) { { sh->kitchenLock, 1 }, { sh->waiterRequest, 1 } }, 2,
+                LAT_HOLD_PROCESSORDER, LAT_NONE) == -1) {      /* exit critical region, signal waiter */
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
+    liveAdd (&sh->live, LIVE_CHEF, 1);
 
 }
 
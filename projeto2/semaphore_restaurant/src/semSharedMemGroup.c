@@ -31,18 +31,29 @@
 #include "sharedDataSync.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "requestQueue.h"
+#include "simClock.h"
+#include "latency.h"
+#include "replay.h"
+#include "profile.h"
+#include "liveStats.h"
+#include "runControl.h"
+#include "prng.h"
 
 /** \brief logging file name */
-static char nFic[51];
+static __thread char nFic[51];
 
 /** \brief shared memory block access identifier */
-static int shmid;
+static __thread int shmid;
 
 /** \brief semaphore set access identifier */
-static int semgid;
+static __thread int semgid;
 
 /** \brief pointer to shared memory region */
-static SHARED_DATA *sh;
+static __thread SHARED_DATA *sh;
+
+/** \brief random generator of the group */
+static __thread PRNG rng;
 
 static void goToRestaurant (int id);
 static void checkInAtReception (int id);
@@ -61,6 +72,7 @@ int main (int argc, char *argv[])
 {
     int key;                                         /*access key to shared memory and semaphore set */
     char *tinp;                                                    /* numerical parameters test flag */
+    unsigned int run;                                                                  /* run number */
     int n;
 
     /* validation of command line parameters */
@@ -86,12 +98,8 @@ int main (int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    /* connection to the semaphore set and the shared memory region and mapping the shared region onto the
-       process address space */
-    if ((semgid = semConnect (key)) == -1) { 
-        perror ("error on connecting to the semaphore set");
-        return EXIT_FAILURE;
-    }
+    /* connection to the shared memory region, mapping the shared region onto the process address space and
+       connection to the semaphore set */
     if ((shmid = shmemConnect (key)) == -1) { 
         perror ("error on connecting to the shared memory region");
         return EXIT_FAILURE;
@@ -100,18 +108,51 @@ int main (int argc, char *argv[])
         perror ("error on mapping the shared region on the process address space");
         return EXIT_FAILURE;
     }
-
-    /* initialize random generator */
-    srandom ((unsigned int) getpid ());                                                 
-
-
-    /* simulation of the life cycle of the group */
-    goToRestaurant(n);
-    checkInAtReception(n);
-    orderFood(n);
-    waitFood(n);
-    eat(n);
-    checkOutAtReception(n);
+    if (n >= sh->fSt.nGroups) {
+        fprintf (stderr, "Group process identification is wrong!\n");
+        return EXIT_FAILURE;
+    }
+    semBind (SEMWORDS, SEM_SLOTS);
+    if ((semgid = semConnect (key)) == -1) { 
+        perror ("error on connecting to the semaphore set");
+        return EXIT_FAILURE;
+    }
+    /* life cycles of the entity, one per run of the simulation (see runControl.h) */
+    for (run = 0; run < sh->run.runs; run++) {
+        runBegin (&sh->run, run, nFic);
+        logAttach (&sh->log, ENTITYID(ENT_GROUP, n));
+        clockAttach (&sh->clock);
+        latAttach (&sh->lat);
+        replayAttach (&sh->replay, semgid, ENTITYID(ENT_GROUP, n));
+        profAttach (&sh->prof, ENTITYID(ENT_GROUP, n), run);
+
+        /* initialize random generator */
+        prngSeed (&rng, sh->seed, ENTITYID(ENT_GROUP, n));
+
+
+        /* simulation of the life cycle of the group, each operation a profiling span */
+        profBegin (PROF_GOTORESTAURANT);
+        goToRestaurant(n);
+        profEnd ();
+        profBegin (PROF_CHECKIN);
+        checkInAtReception(n);
+        profEnd ();
+        profBegin (PROF_ORDERFOOD);
+        orderFood(n);
+        profEnd ();
+        profBegin (PROF_WAITFOOD);
+        waitFood(n);
+        profEnd ();
+        profBegin (PROF_EAT);
+        eat(n);
+        profEnd ();
+        profBegin (PROF_CHECKOUT);
+        checkOutAtReception(n);
+        profEnd ();
+
+        clockDetach ();
+        runEnd (&sh->run);
+    }
 
     /* unmapping the shared region off the process address space */
     if (shmemDettach (sh) == -1) {
@@ -122,26 +163,6 @@ int main (int argc, char *argv[])
     return EXIT_SUCCESS;
 }
 
-/**
- *  \brief normal distribution generator with zero mean and stddev deviation. 
- *
- *  Generates random number according to normal distribution.
- * 
- *  \param stddev controls standard deviation of distribution
- */
-static double normalRand(double stddev)
-{
-   int i;
-
-   double r=0.0;
-   for (i=0;i<12;i++) {
-       r += random()/(RAND_MAX+1.0);
-   }
-   r -= 6.0;
-
-   return r*stddev;
-}
-
 /**
  *  \brief group goes to restaurant 
  *
@@ -151,10 +172,10 @@ static double normalRand(double stddev)
  */
 static void goToRestaurant (int id)
 {
-    double startTime = sh->fSt.startTime[id] + normalRand(STARTDEV);
+    double startTime = STARTTIME(&sh->fSt)[id] + prngNormal (&rng, STARTDEV);
     
     if (startTime > 0.0) {
-        usleep((unsigned int) startTime );
+        clockSleep ((unsigned int) startTime);
     }
 }
 
@@ -167,17 +188,17 @@ static void goToRestaurant (int id)
  */
 static void eat (int id)
 {
-    double eatTime = sh->fSt.eatTime[id] + normalRand(EATDEV);
+    double eatTime = EATTIME(&sh->fSt)[id] + prngNormal (&rng, EATDEV);
     
     if (eatTime > 0.0) {
-        usleep((unsigned int) eatTime );
+        clockSleep ((unsigned int) eatTime);
     }
 }
 
 /**
  *  \brief group checks in at reception
  *
- *  Group should, as soon as receptionist is available, ask for a table,
+ *  Group should, as soon as there is room in the receptionist queue, ask for a table,
  *  signaling receptionist of the request.  
  *  Group may have to wait for a table in this method.
  *  The internal state should be saved.
@@ -188,34 +209,34 @@ static void eat (int id)
  */
 static void checkInAtReception(int id)
 {
-    
-    if (semDown (semgid, sh->receptionistRequestPossible) == -1) {                                                 
+    request req;
+
+    if (latDown (semgid, sh->receptionistRequestPossible, LAT_RECEPTIONISTREQUESTPOSSIBLE) == -1) {                                                 
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                  
+    if (latDown (semgid, GROUPLOCKSEM(id), LAT_GROUPLOCK) == -1) {                                                  
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    sh->fSt.st.groupStat[id] = ATRECEPTION;
+    stateBegin (&sh->fSt, DOM_GROUP(id));
+    GROUPSTAT(&sh->fSt,id) = ATRECEPTION;
+    stateEnd (&sh->fSt, DOM_GROUP(id));
     saveState(nFic, &sh->fSt);    
 
-    sh->fSt.receptionistRequest.reqType = TABLEREQ;
-    sh->fSt.receptionistRequest.reqGroup = id;
+    req.reqType = TABLEREQ;
+    req.reqGroup = id;
+    queuePut (&sh->fSt.receptionistRequest, req);
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                      /* exit critical region */
+    if (latOps (semgid, (SEM_OP []) { { GROUPLOCKSEM(id), 1 }, { sh->receptionistReq, 1 } }, 2,
+                LAT_HOLD_CHECKIN, LAT_NONE) == -1) {   /* exit critical region, signal receptionist */
         perror ("error on the up operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semUp (semgid, sh->receptionistReq) == -1) {                                           
-        perror ("error on the up operation for semaphore access (PT)");
-        exit (EXIT_FAILURE);
-    }
-
-    if (semDown (semgid, sh->waitForTable[id]) == -1) {
+    if (latDown (semgid, WAITFORTABLESEM(id), LAT_WAITFORTABLE) == -1) {
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
@@ -225,8 +246,7 @@ static void checkInAtReception(int id)
 /**
  *  \brief group orders food.
  *
- *  The group should update its state, request food to the waiter and 
- *  wait for the waiter to receive the request.
+ *  The group should update its state and queue a food request to the waiter.
  *  
  *  The internal state should be saved.
  *
@@ -234,33 +254,34 @@ static void checkInAtReception(int id)
  */
 static void orderFood (int id)
 {
+    request req;
 
-    if (semDown (semgid, sh->waiterRequestPossible) == -1) {
+    if (latDown (semgid, sh->waiterRequestPossible, LAT_WAITERREQUESTPOSSIBLE) == -1) {
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                  
+    if (latDown (semgid, GROUPLOCKSEM(id), LAT_GROUPLOCK) == -1) {                                                  
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    sh->fSt.st.groupStat[id] = FOOD_REQUEST;
+    stateBegin (&sh->fSt, DOM_GROUP(id));
+    GROUPSTAT(&sh->fSt,id) = FOOD_REQUEST;
+    stateEnd (&sh->fSt, DOM_GROUP(id));
     saveState(nFic, &sh->fSt);
 
-    sh->fSt.waiterRequest.reqType = FOODREQ;
-    sh->fSt.waiterRequest.reqGroup = id;
+    req.reqType = FOODREQ;
+    req.reqGroup = id;
+    queuePut (&sh->fSt.waiterRequest, req);
+    latDepth (LAT_DEPTH_WAITER, queueDepth (&sh->fSt.waiterRequest));
 
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                     /* exit critical region */
+    if (latOps (semgid, (SEM_OP []) { { GROUPLOCKSEM(id), 1 }, { sh->waiterRequest, 1 } }, 2,
+                LAT_HOLD_ORDERFOOD, LAT_NONE) == -1) {   /* exit critical region, signal waiter */
         perror ("error on the up operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
-    
-    if (semUp (semgid, sh->waiterRequest) == -1) {
-        perror ("error on the up operation for semaphore access (PT)");
-        exit (EXIT_FAILURE);
-    }
 }
 
 /**
@@ -274,35 +295,39 @@ static void orderFood (int id)
  */
 static void waitFood (int id)
 {
-    if (semDown (semgid, sh->mutex) == -1) {                                                  
+    if (latDown (semgid, GROUPLOCKSEM(id), LAT_GROUPLOCK) == -1) {                                                  
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    sh->fSt.st.groupStat[id] = WAIT_FOR_FOOD;
+    stateBegin (&sh->fSt, DOM_GROUP(id));
+    GROUPSTAT(&sh->fSt,id) = WAIT_FOR_FOOD;
+    stateEnd (&sh->fSt, DOM_GROUP(id));
     saveState(nFic, &sh->fSt);
 
-    int tableId = sh->fSt.assignedTable[id]; 
+    int tableId = ASSIGNEDTABLE(&sh->fSt)[id]; 
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                  
+    if (latUp (semgid, GROUPLOCKSEM(id), LAT_HOLD_WAITFOOD) == -1) {                                                  
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->foodArrived[tableId]) == -1) {
+    if (latDown (semgid, FOODARRIVEDSEM(tableId), LAT_FOODARRIVED) == -1) {
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                  
+    if (latDown (semgid, GROUPLOCKSEM(id), LAT_GROUPLOCK) == -1) {                                                  
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    sh->fSt.st.groupStat[id] = EAT;
+    stateBegin (&sh->fSt, DOM_GROUP(id));
+    GROUPSTAT(&sh->fSt,id) = EAT;
+    stateEnd (&sh->fSt, DOM_GROUP(id));
     saveState(nFic, &sh->fSt);
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                  
+    if (latUp (semgid, GROUPLOCKSEM(id), LAT_HOLD_WAITFOOD) == -1) {                                                  
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
@@ -311,8 +336,8 @@ static void waitFood (int id)
 /**
  *  \brief group check out at reception. 
  *
- *  The group, as soon as receptionist is available, updates its state and 
- *  sends a payment request to the receptionist.
+ *  The group, as soon as there is room in the receptionist queue, updates its state and 
+ *  queues a payment request to the receptionist.
  *  Group waits for receptionist to acknowledge payment. 
  *  Group should update its state to LEAVING, after acknowledge.
  *  The internal state should be saved twice.
@@ -321,50 +346,53 @@ static void waitFood (int id)
  */
 static void checkOutAtReception (int id)
 {
+    request req;
 
-    if (semDown (semgid, sh->receptionistRequestPossible) == -1) {
+    if (latDown (semgid, sh->receptionistRequestPossible, LAT_RECEPTIONISTREQUESTPOSSIBLE) == -1) {
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                  
+    if (latDown (semgid, GROUPLOCKSEM(id), LAT_GROUPLOCK) == -1) {                                                  
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    sh->fSt.st.groupStat[id] = CHECKOUT;
+    stateBegin (&sh->fSt, DOM_GROUP(id));
+    GROUPSTAT(&sh->fSt,id) = CHECKOUT;
+    stateEnd (&sh->fSt, DOM_GROUP(id));
     saveState(nFic, &sh->fSt);
 
-    sh->fSt.receptionistRequest.reqType = BILLREQ;
-    sh->fSt.receptionistRequest.reqGroup = id;
-
-    int tableId = sh->fSt.assignedTable[id];
+    int tableId = ASSIGNEDTABLE(&sh->fSt)[id];                       /* before the receptionist may release it */
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                  
-        perror ("error on the down operation for semaphore access (CT)");
-        exit (EXIT_FAILURE);
-    }
+    req.reqType = BILLREQ;
+    req.reqGroup = id;
+    queuePut (&sh->fSt.receptionistRequest, req);
 
-    if (semUp (semgid, sh->receptionistReq) == -1) {
-        perror ("error on the up operation for semaphore access (PT)");
+    if (latOps (semgid, (SEM_OP []) { { GROUPLOCKSEM(id), 1 }, { sh->receptionistReq, 1 } }, 2,
+                LAT_HOLD_CHECKOUT, LAT_NONE) == -1) {  /* exit critical region, signal receptionist */
+        perror ("error on the up operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->tableDone[tableId]) == -1) {
+    if (latDown (semgid, TABLEDONESEM(tableId), LAT_TABLEDONE) == -1) {
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                  
+    if (latDown (semgid, GROUPLOCKSEM(id), LAT_GROUPLOCK) == -1) {                                                  
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
 
-    sh->fSt.st.groupStat[id] = LEAVING;
+    stateBegin (&sh->fSt, DOM_GROUP(id));
+    GROUPSTAT(&sh->fSt,id) = LEAVING;
+    stateEnd (&sh->fSt, DOM_GROUP(id));
     saveState(nFic, &sh->fSt);
+    liveAdd (&sh->live, LIVE_LEFT, 1);
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                  
+    if (latUp (semgid, GROUPLOCKSEM(id), LAT_HOLD_CHECKOUT) == -1) {                                                  
         perror ("error on the down operation for semaphore access (CT)");
         exit (EXIT_FAILURE);
     }
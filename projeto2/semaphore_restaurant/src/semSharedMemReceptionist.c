@@ -22,6 +22,7 @@
 #include <string.h>
 #include <math.h>
 #include <assert.h>
+#include <errno.h>
 
 #include "probConst.h"
 #include "probDataStruct.h"
@@ -29,18 +30,25 @@
 #include "sharedDataSync.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "requestQueue.h"
+#include "simClock.h"
+#include "latency.h"
+#include "replay.h"
+#include "profile.h"
+#include "liveStats.h"
+#include "runControl.h"
 
 /** \brief logging file name */
-static char nFic[51];
+static __thread char nFic[51];
 
 /** \brief shared memory block access identifier */
-static int shmid;
+static __thread int shmid;
 
 /** \brief semaphore set access identifier */
-static int semgid;
+static __thread int semgid;
 
 /** \brief pointer to shared memory region */
-static SHARED_DATA *sh;
+static __thread SHARED_DATA *sh;
 
 /* constants for groupRecord */
 #define TOARRIVE 0
@@ -49,7 +57,26 @@ static SHARED_DATA *sh;
 #define DONE     3
 
 /** \brief receptioninst view on each group evolution (useful to decide table binding) */
-static int groupRecord[MAXGROUPS];
+static __thread int *groupRecord;
+
+/** \brief vacant tables, in the order they were vacated (the last one at freeTable[nFree-1]) */
+static __thread int *freeTable;
+/** \brief number of vacant tables */
+static __thread int nFree;
+
+/** \brief waiting groups, in arrival order (a group waits at most once in a run, so it never wraps around) */
+static __thread int *waitQueue;
+/** \brief position of the first waiting group in waitQueue */
+static __thread int waitHead;
+
+/** \brief groups seated when a table gets vacant (or in a burst, event loop) */
+static __thread int *seated;
+
+/** \brief tables vacated in a burst (event loop) */
+static __thread int *vacated;
+
+/** \brief requests taken in a single wake up (event loop) */
+static __thread request *burst;
 
 
 /** \brief receptionist waits for next request */
@@ -61,6 +88,12 @@ static void provideTableOrWaitingRoom (int n);
 /** \brief receptionist receives payment */
 static void receivePayment (int n);
 
+/** \brief receptionist takes every pending request (event loop) */
+static int waitForRequests ();
+
+/** \brief receptionist serves a burst of requests (event loop) */
+static void serveRequests (int n);
+
 
 
 /**
@@ -72,6 +105,7 @@ int main (int argc, char *argv[])
 {
     int key;                                            /*access key to shared memory and semaphore set */
     char *tinp;                                                       /* numerical parameters test flag */
+    unsigned int run;                                                                     /* run number */
 
     /* validation of command line parameters */
     if (argc != 4) { 
@@ -80,7 +114,9 @@ int main (int argc, char *argv[])
         return EXIT_FAILURE;
     }
     else { 
-        freopen (argv[3], "w", stderr);
+#ifndef ENGINE_THREADS
+        freopen (argv[3], "w", stderr);                          /* threads share the stderr of the generator */
+#endif
         setbuf(stderr,NULL);
     }
 
@@ -91,12 +127,8 @@ int main (int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    /* connection to the semaphore set and the shared memory region and mapping the shared region onto the
-       process address space */
-    if ((semgid = semConnect (key)) == -1) { 
-        perror ("error on connecting to the semaphore set");
-        return EXIT_FAILURE;
-    }
+    /* connection to the shared memory region, mapping the shared region onto the process address space and
+       connection to the semaphore set */
     if ((shmid = shmemConnect (key)) == -1) { 
         perror ("error on connecting to the shared memory region");
         return EXIT_FAILURE;
@@ -105,30 +137,77 @@ int main (int argc, char *argv[])
         perror ("error on mapping the shared region on the process address space");
         return EXIT_FAILURE;
     }
-
-    /* initialize random generator */
-    srandom ((unsigned int) getpid ());              
-
-    /* initialize internal receptionist memory */
-    int g;
-    for (g=0; g < sh->fSt.nGroups; g++) {
-       groupRecord[g] = TOARRIVE;
+    semBind (SEMWORDS, SEM_SLOTS);
+    if ((semgid = semConnect (key)) == -1) { 
+        perror ("error on connecting to the semaphore set");
+        return EXIT_FAILURE;
+    }
+    /* allocate internal receptionist memory */
+    int g, t;
+    if (((groupRecord = malloc (sh->fSt.nGroups * sizeof (int))) == NULL) ||
+        ((waitQueue = malloc (sh->fSt.nGroups * sizeof (int))) == NULL) ||
+        ((freeTable = malloc (sh->fSt.nTables * sizeof (int))) == NULL) ||
+        ((seated = malloc (sh->fSt.nTables * sizeof (int))) == NULL) ||
+        ((vacated = malloc (sh->fSt.nTables * sizeof (int))) == NULL) ||
+        ((burst = malloc (sh->fSt.nGroups * sizeof (request))) == NULL)) {
+        perror ("error on allocating the receptionist memory");
+        return EXIT_FAILURE;
     }
 
-    /* simulation of the life cycle of the receptionist */
-    int nReq=0;
-    request req;
-    while( nReq < sh->fSt.nGroups*2 ) {
-        req = waitForGroup();
-        switch(req.reqType) {
-            case TABLEREQ:
-                   provideTableOrWaitingRoom(req.reqGroup); //TODO param should be groupid
-                   break;
-            case BILLREQ:
-                   receivePayment(req.reqGroup);
-                   break;
+    /* life cycles of the entity, one per run of the simulation (see runControl.h) */
+    for (run = 0; run < sh->run.runs; run++) {
+        runBegin (&sh->run, run, nFic);
+        logAttach (&sh->log, ENTITYID(ENT_RECEPTIONIST, 0));
+        clockAttach (&sh->clock);
+        latAttach (&sh->lat);
+        replayAttach (&sh->replay, semgid, ENTITYID(ENT_RECEPTIONIST, 0));
+        profAttach (&sh->prof, ENTITYID(ENT_RECEPTIONIST, 0), run);
+
+        /* initialize internal receptionist memory */
+        for (g=0; g < sh->fSt.nGroups; g++) {
+           groupRecord[g] = TOARRIVE;
+        }
+        nFree = 0;
+        for (t = sh->fSt.nTables - 1; t >= 0; t--) {                              /* table 0 is the first to be used */
+           freeTable[nFree++] = t;
+        }
+        waitHead = 0;
+
+        /* simulation of the life cycle of the receptionist */
+        int nReq=0, n;
+        request req;
+        while( !sh->eventLoop && (nReq < sh->fSt.nGroups*2) ) {
+            profBegin (PROF_WAITFORGROUP);
+            req = waitForGroup();
+            profEnd ();
+            switch(req.reqType) {
+                case TABLEREQ:
+                       profBegin (PROF_PROVIDETABLE);
+                       provideTableOrWaitingRoom(req.reqGroup); //TODO param should be groupid
+                       profEnd ();
+                       break;
+                case BILLREQ:
+                       profBegin (PROF_RECEIVEPAYMENT);
+                       receivePayment(req.reqGroup);
+                       profEnd ();
+                       break;
+            }
+            liveAdd (&sh->live, LIVE_RECEPTION, 1);
+            nReq++;
+        }
+        while( sh->eventLoop && (nReq < sh->fSt.nGroups*2) ) {
+            profBegin (PROF_WAITFORGROUP);
+            n = waitForRequests();
+            profEnd ();
+            profBegin (PROF_SERVEREQUESTS);
+            serveRequests(n);
+            profEnd ();
+            liveAdd (&sh->live, LIVE_RECEPTION, n);
+            nReq += n;
         }
-        nReq++;
+
+        clockDetach ();
+        runEnd (&sh->run);
     }
 
     /* unmapping the shared region off the process address space */
@@ -140,35 +219,62 @@ int main (int argc, char *argv[])
     return EXIT_SUCCESS;
 }
 
+/**
+ *  \brief finds the vacant table that best fits group n.
+ *
+ *  It is the table with the fewest seats that holds the group; among tables with the same seats, the one vacated
+ *  last.
+ *
+ *  \return position of the table in freeTable or -1 (if no vacant table holds the group)
+ */
+static int bestFit(int n)
+{
+    int i, best = -1;
+
+    for (i = nFree - 1; i >= 0; i--) {
+        if ((TABLECAP(&sh->fSt)[freeTable[i]] >= GROUPSIZE(&sh->fSt)[n]) &&
+            ((best == -1) || (TABLECAP(&sh->fSt)[freeTable[i]] < TABLECAP(&sh->fSt)[freeTable[best]]))) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**
+ *  \brief takes the vacant table at position i of freeTable.
+ *
+ *  \return table id
+ */
+static int takeTable(int i)
+{
+    int t = freeTable[i];
+
+    memmove (&freeTable[i], &freeTable[i+1], (nFree - i - 1) * sizeof (int));
+    nFree--;
+    return t;
+}
+
 /**
  *  \brief decides table to occupy for group n or if it must wait.
  *
- *  Checks current state of tables and groups in order to decide table or wait.
+ *  Takes the vacant table that best fits the group, if there is one and no group is waiting (or seating ahead is
+ *  on); otherwise the group joins the end of the waiting queue.
  *
  *  \return table id or -1 (in case of wait decision)
  */
 static int decideTableOrWait(int n)
 {
-    int tableId = 0;
-    int num_tables = 0;
-
-    for (int i = 0; i < MAXGROUPS; i++) {
-        if (sh->fSt.assignedTable[i] == 1 || sh->fSt.assignedTable[i] == 0) {
-            if (num_tables == 0) {
-                tableId = 0;
-                num_tables++;
-            } else {
-                tableId = -1;
-                break;
-            }
-        }
-    }
+    int i = -1;
 
-    if (tableId != -1) {
+    if ((sh->fSt.groupsWaiting == 0) || sh->seatAhead) {
+        i = bestFit (n);
+    }
+    if (i != -1) {
         groupRecord[n] = ATTABLE;
-        return tableId;
+        return takeTable (i);
     } else {
         groupRecord[n] = WAIT;
+        waitQueue[waitHead + sh->fSt.groupsWaiting] = n;
         sh->fSt.groupsWaiting++;
         return -1;
     }
@@ -177,25 +283,35 @@ static int decideTableOrWait(int n)
 
 /**
  *  \brief called when a table gets vacant and there are waiting groups 
- *         to decide which group (if any) should occupy it.
+ *         to decide which group (if any) should occupy a vacant table.
+ *
+ *  The group that has been waiting for longer is chosen, if a vacant table holds it; with seating ahead, the
+ *  next waiting groups are tried in arrival order until one fits. The group takes the vacant table that best
+ *  fits it.
  *
- *  Checks current state of tables and groups in order to decide group.
+ *  \param table pointer to the location where the table of the group is stored
  *
  *  \return group id or -1 (in case of wait decision)
  */
-static int decideNextGroup()
+static int decideNextGroup(int *table)
 {
-
-    if (sh->fSt.groupsWaiting == 0) {
-        return -1;
-    }
-    else{
-        for (int g = 0; g < MAXGROUPS; g++) {
-            if (groupRecord[g] == WAIT) {
-                groupRecord[g] = ATTABLE;
-                sh->fSt.groupsWaiting--;
-                return g;
+    int k, i, g;
+
+    for (k = 0; k < sh->fSt.groupsWaiting; k++) {
+        g = waitQueue[waitHead + k];
+        if ((i = bestFit (g)) != -1) {
+            *table = takeTable (i);
+            if (k == 0) {
+                waitHead++;
             }
+            else memmove (&waitQueue[waitHead + k], &waitQueue[waitHead + k + 1],
+                          (sh->fSt.groupsWaiting - k - 1) * sizeof (int));
+            groupRecord[g] = ATTABLE;
+            sh->fSt.groupsWaiting--;
+            return g;
+        }
+        if (!sh->seatAhead) {
+            break;                                                        /* groups are seated in arrival order */
         }
     }
     return -1;
@@ -204,8 +320,8 @@ static int decideNextGroup()
 /**
  *  \brief receptionist waits for next request 
  *
- *  Receptionist updates state and waits for request from group, then reads request,
- *  and signals availability for new request.
+ *  Receptionist updates state and waits for request from group, then takes it from the queue,
+ *  and signals the slot is free for a new request.
  *  The internal state should be saved.
  *
  *  \return request submitted by group
@@ -214,36 +330,28 @@ static request waitForGroup()
 {
     request req; 
 
-    if (semDown (semgid, sh->mutex) == -1)  {                                                  
+    if (latDown (semgid, sh->receptionLock, LAT_RECEPTIONLOCK) == -1)  {                                                  
         perror ("error on the up operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
+    stateBegin (&sh->fSt, DOM_RECEPTION);
     sh->fSt.st.receptionistStat = WAIT_FOR_REQUEST;
+    stateEnd (&sh->fSt, DOM_RECEPTION);
     saveState(nFic, &sh->fSt);
     
-    if (semUp (semgid, sh->mutex) == -1)      {                                             
+    if (latUp (semgid, sh->receptionLock, LAT_HOLD_WAITFORGROUP) == -1)      {                                             
         perror ("error on the down operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->receptionistReq) == -1)
+    if (latDown (semgid, sh->receptionistReq, LAT_RECEPTIONISTREQ) == -1)
     {
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->mutex) == -1)  {                                                  
-        perror ("error on the up operation for semaphore access (WT)");
-        exit (EXIT_FAILURE);
-    }
-
-    req = sh->fSt.receptionistRequest; 
-
-    if (semUp (semgid, sh->mutex) == -1) {                                                  
-     perror ("error on the down operation for semaphore access (WT)");
-        exit (EXIT_FAILURE);
-    }
+    req = queueGet (&sh->fSt.receptionistRequest);
 
     if (semUp (semgid, sh->receptionistRequestPossible) == -1)
     {
@@ -266,28 +374,34 @@ static request waitForGroup()
  */
 static void provideTableOrWaitingRoom (int n)
 {
-    if (semDown (semgid, sh->mutex) == -1)  {                                                  
+    if (latDown (semgid, sh->receptionLock, LAT_RECEPTIONLOCK) == -1)  {                                                  
         perror ("error on the up operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
+    stateBegin (&sh->fSt, DOM_RECEPTION);
     sh->fSt.st.receptionistStat = ASSIGNTABLE;
+    stateEnd (&sh->fSt, DOM_RECEPTION);
     saveState(nFic, &sh->fSt);
 
+    stateBegin (&sh->fSt, DOM_RECEPTION);
     int tableId = decideTableOrWait(n);
 
     if (tableId != -1) {
+        ASSIGNEDTABLE(&sh->fSt)[n] = tableId;
+        liveAdd (&sh->live, LIVE_TABLES, 1);
+    }
+    stateEnd (&sh->fSt, DOM_RECEPTION);
 
-        sh->fSt.assignedTable[n] = tableId;
-
-        if (semUp(semgid, sh->waitForTable[n]) == -1) {
+    if (tableId != -1) {
+        if (semUp(semgid, WAITFORTABLESEM(n)) == -1) {
             perror("error on the up operation for semaphore access (PT)");
             exit(EXIT_FAILURE);
         }
     }
 
 
-    if (semUp (semgid, sh->mutex) == -1) {                                               
+    if (latUp (semgid, sh->receptionLock, LAT_HOLD_PROVIDETABLE) == -1) {                                               
         perror ("error on the down operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
@@ -299,49 +413,182 @@ static void provideTableOrWaitingRoom (int n)
  *
  *  Receptionist updates its state and receives payment.
  *  If there are waiting groups, receptionist should check if table that just became
- *  vacant should be occupied. Shared (and internal) memory should be updated.
+ *  vacant should be occupied; as the table may be taken by a group that fits it better, the
+ *  groups waiting behind may then fit the vacant tables. Shared (and internal) memory should be updated.
  *  The internal state should be saved.
  *
  */
 
 static void receivePayment (int n)
 {
-    if (semDown (semgid, sh->mutex) == -1)  {                                                  
+    if (latDown (semgid, sh->receptionLock, LAT_RECEPTIONLOCK) == -1)  {                                                  
         perror ("error on the up operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
+    stateBegin (&sh->fSt, DOM_RECEPTION);
     sh ->fSt.st.receptionistStat = RECVPAY;
+    stateEnd (&sh->fSt, DOM_RECEPTION);
     saveState(nFic, &sh->fSt);
 
-    int tableId = sh->fSt.assignedTable[n];
-    int groupId = decideNextGroup();
+    int tableId = ASSIGNEDTABLE(&sh->fSt)[n];
 
-    if (groupId != -1)
+    stateBegin (&sh->fSt, DOM_RECEPTION);
+    freeTable[nFree++] = tableId;                                         /* vacant until a waiting group takes it */
+    int groupId, t, nSeated = 0;
+
+    while ((groupId = decideNextGroup (&t)) != -1)
     {
-         sh->fSt.assignedTable[groupId] = tableId;
-         groupRecord[n] = DONE;
+         ASSIGNEDTABLE(&sh->fSt)[groupId] = t;
+         seated[nSeated++] = groupId;
+    }
+    liveAdd (&sh->live, LIVE_TABLES, nSeated - 1);
+    groupRecord[n] = DONE;
     
-        if (semUp (semgid, sh->waitForTable[groupId]) == -1)
+    ASSIGNEDTABLE(&sh->fSt)[n] = -1;
+    stateEnd (&sh->fSt, DOM_RECEPTION);
+
+    for (t = 0; t < nSeated; t++)
+    {
+        if (semUp (semgid, WAITFORTABLESEM(seated[t])) == -1)
         {
             perror ("error on the up operation for semaphore access (PT)");
             exit (EXIT_FAILURE);
         }
-  
     }
-    
-    sh->fSt.assignedTable[n] = -1;
 
-    if (semUp (semgid, sh->mutex) == -1)  {                                                  
-     perror ("error on the down operation for semaphore access (WT)");
+    if (latOps (semgid, (SEM_OP []) { { sh->receptionLock, 1 }, { TABLEDONESEM(tableId), 1 } }, 2,
+                LAT_HOLD_RECEIVEPAYMENT, LAT_NONE) == -1) {   /* exit critical region, payment done */
+        perror ("error on the up operation for semaphore access (PT)");
+        exit (EXIT_FAILURE);
+    }
+
+}
+
+/**
+ *  \brief receptionist takes every pending request, in the event loop.
+ *
+ *  Receptionist updates state and waits for a request from a group (as waitForGroup does), then takes every other
+ *  request pending at that time as well: a group has at most one pending request, so there are at most nGroups.
+ *  The slots of the requests taken are signalled free.
+ *
+ *  \return number of requests stored in burst
+ */
+static int waitForRequests ()
+{
+    int n = 0;
+
+    if (latDown (semgid, sh->receptionLock, LAT_RECEPTIONLOCK) == -1)  {
+        perror ("error on the up operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semUp (semgid, sh->tableDone[tableId]) == -1)
+    stateBegin (&sh->fSt, DOM_RECEPTION);
+    sh->fSt.st.receptionistStat = WAIT_FOR_REQUEST;
+    stateEnd (&sh->fSt, DOM_RECEPTION);
+    saveState(nFic, &sh->fSt);
+
+    if (latUp (semgid, sh->receptionLock, LAT_HOLD_WAITFORGROUP) == -1)      {
+        perror ("error on the down operation for semaphore access (WT)");
+        exit (EXIT_FAILURE);
+    }
+
+    if (latDown (semgid, sh->receptionistReq, LAT_RECEPTIONISTREQ) == -1)
     {
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
+    do {
+        burst[n++] = queueGet (&sh->fSt.receptionistRequest);
+        if (semUp (semgid, sh->receptionistRequestPossible) == -1)
+        {
+            perror ("error on the up operation for semaphore access (PT)");
+            exit (EXIT_FAILURE);
+        }
+    } while (replayTryDown (semgid, sh->receptionistReq) != -1);
+    if (errno != EAGAIN) {                                                       /* no other request is pending */
+        perror ("error on the down operation for semaphore access (PT)");
+        exit (EXIT_FAILURE);
+    }
+
+    return n;
 }
 
+/**
+ *  \brief receptionist serves a burst of requests, in the event loop.
+ *
+ *  Receptionist receives the payments first, so that the tables vacated are assigned together with the others:
+ *  the waiting groups are seated as in receivePayment, then the groups that check in as in
+ *  provideTableOrWaitingRoom. Every group seated and every group that paid is only informed afterwards, all in
+ *  the same critical region. The internal state is saved once for the payments and once for the table
+ *  assignments.
+ *
+ *  \param n number of requests in burst
+ */
+static void serveRequests (int n)
+{
+    int i, g, t, nVacated = 0, nSeated = 0;
+
+    if (latDown (semgid, sh->receptionLock, LAT_RECEPTIONLOCK) == -1)  {
+        perror ("error on the up operation for semaphore access (WT)");
+        exit (EXIT_FAILURE);
+    }
+
+    for (i = 0; i < n; i++) {
+        if (burst[i].reqType != BILLREQ) {
+            continue;
+        }
+        if (nVacated == 0) {
+            stateBegin (&sh->fSt, DOM_RECEPTION);
+            sh->fSt.st.receptionistStat = RECVPAY;
+            stateEnd (&sh->fSt, DOM_RECEPTION);
+            saveState(nFic, &sh->fSt);
+        }
+        g = burst[i].reqGroup;
+        stateBegin (&sh->fSt, DOM_RECEPTION);
+        vacated[nVacated++] = freeTable[nFree++] = ASSIGNEDTABLE(&sh->fSt)[g];
+        groupRecord[g] = DONE;
+        ASSIGNEDTABLE(&sh->fSt)[g] = -1;
+        stateEnd (&sh->fSt, DOM_RECEPTION);
+    }
+
+    if (nVacated < n) {
+        stateBegin (&sh->fSt, DOM_RECEPTION);
+        sh->fSt.st.receptionistStat = ASSIGNTABLE;
+        stateEnd (&sh->fSt, DOM_RECEPTION);
+        saveState(nFic, &sh->fSt);
+    }
+
+    stateBegin (&sh->fSt, DOM_RECEPTION);
+    while ((g = decideNextGroup (&t)) != -1) {                       /* the waiting groups came before the new ones */
+        ASSIGNEDTABLE(&sh->fSt)[g] = t;
+        seated[nSeated++] = g;
+    }
+    for (i = 0; i < n; i++) {
+        if ((burst[i].reqType == TABLEREQ) && ((t = decideTableOrWait (burst[i].reqGroup)) != -1)) {
+            ASSIGNEDTABLE(&sh->fSt)[burst[i].reqGroup] = t;
+            seated[nSeated++] = burst[i].reqGroup;
+        }
+    }
+    liveAdd (&sh->live, LIVE_TABLES, nSeated - nVacated);
+    stateEnd (&sh->fSt, DOM_RECEPTION);
+
+    for (i = 0; i < nSeated; i++) {
+        if (semUp (semgid, WAITFORTABLESEM(seated[i])) == -1) {
+            perror ("error on the up operation for semaphore access (PT)");
+            exit (EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < nVacated; i++) {                                                                 /* payment done */
+        if (semUp (semgid, TABLEDONESEM(vacated[i])) == -1) {
+            perror ("error on the up operation for semaphore access (PT)");
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    if (latUp (semgid, sh->receptionLock, (nVacated > 0) ? LAT_HOLD_RECEIVEPAYMENT : LAT_HOLD_PROVIDETABLE) == -1) {
+        perror ("error on the down operation for semaphore access (WT)");
+        exit (EXIT_FAILURE);
+    }
+}
@@ -6,7 +6,7 @@
  *  Synchronization based on semaphores and shared memory.
  *  Implementation with SVIPC.
  *
- *  Definition of the operations carried out by the waiter:
+ *  Definition of the operations carried out by the waiters:
  *     \li waitForClientOrChef
  *     \li informChef
  *     \li takeFoodToTable
@@ -22,6 +22,8 @@
 #include <string.h>
 #include <math.h>
 #include <assert.h>
+#include <sched.h>
+#include <errno.h>
 
 #include "probConst.h"
 #include "probDataStruct.h"
@@ -29,63 +31,80 @@
 #include "sharedDataSync.h"
 #include "semaphore.h"
 #include "sharedMemory.h"
+#include "requestQueue.h"
+#include "simClock.h"
+#include "latency.h"
+#include "replay.h"
+#include "profile.h"
+#include "liveStats.h"
+#include "runControl.h"
 
 /** \brief logging file name */
-static char nFic[51];
+static __thread char nFic[51];
+
+/** \brief waiter id */
+static __thread int id;
 
 /** \brief shared memory block access identifier */
-static int shmid;
+static __thread int shmid;
 
 /** \brief semaphore set access identifier */
-static int semgid;
+static __thread int semgid;
 
 /** \brief pointer to shared memory region */
-static SHARED_DATA *sh;
+static __thread SHARED_DATA *sh;
 
 /** \brief waiter waits for next request */
 static request waitForClientOrChef ();
 
-/** \brief waiter takes food order to chef */
-static void informChef(int group);
+/** \brief waiter serves every pending request (batched dispatch) */
+static bool serveBatch ();
+
+/** \brief waiter takes food orders to chef */
+static void informChef(int group[], int n);
 
-/** \brief waiter takes food to table */
-static void takeFoodToTable (int group);
+/** \brief waiter takes food to tables */
+static void takeFoodToTable (int group[], int n);
 
 
 /**
  *  \brief Main program.
  *
- *  Its role is to generate the life cycle of one of intervening entities in the problem: the waiter.
+ *  Its role is to generate the life cycle of one of intervening entities in the problem: a waiter.
  */
 int main (int argc, char *argv[])
 {
     int key;                                            /*access key to shared memory and semaphore set */
     char *tinp;                                                       /* numerical parameters test flag */
+    unsigned int run;                                                                     /* run number */
 
     /* validation of command line parameters */
-    if (argc != 4) { 
+    if (argc != 5) { 
         freopen ("error_WT", "a", stderr);
         fprintf (stderr, "Number of parameters is incorrect!\n");
         return EXIT_FAILURE;
     }
     else { 
-        freopen (argv[3], "w", stderr);
+#ifndef ENGINE_THREADS
+        freopen (argv[4], "w", stderr);                          /* threads share the stderr of the generator */
+#endif
         setbuf(stderr,NULL);
     }
 
-    strcpy (nFic, argv[1]);
-    key = (unsigned int) strtol (argv[2], &tinp, 0);
+    id = (unsigned int) strtol (argv[1], &tinp, 0);
+    if ((*tinp != '\0') || (id >= MAXGROUPS)) {
+        fprintf (stderr, "Waiter process identification is wrong!\n");
+        return EXIT_FAILURE;
+    }
+    strcpy (nFic, argv[2]);
+    key = (unsigned int) strtol (argv[3], &tinp, 0);
     if (*tinp != '\0') {
         fprintf (stderr, "Error on the access key communication!\n");
         return EXIT_FAILURE;
     }
 
-    /* connection to the semaphore set and the shared memory region and mapping the shared region onto the
-       process address space */
-    if ((semgid = semConnect (key)) == -1) { 
-        perror ("error on connecting to the semaphore set");
-        return EXIT_FAILURE;
-    }
+    /* connection to the shared memory region, mapping the shared region onto the process address space and
+       connection to the semaphore set */
     if ((shmid = shmemConnect (key)) == -1) { 
         perror ("error on connecting to the shared memory region");
         return EXIT_FAILURE;
@@ -94,24 +113,45 @@ int main (int argc, char *argv[])
         perror ("error on mapping the shared region on the process address space");
         return EXIT_FAILURE;
     }
+    semBind (SEMWORDS, SEM_SLOTS);
+    if ((semgid = semConnect (key)) == -1) { 
+        perror ("error on connecting to the semaphore set");
+        return EXIT_FAILURE;
+    }
 
-    /* initialize random generator */
-    srandom ((unsigned int) getpid ());              
-
-    /* simulation of the life cycle of the waiter */
-    int nReq=0;
-    request req;
-    while( nReq < sh->fSt.nGroups*2 ) {
-        req = waitForClientOrChef();
-        switch(req.reqType) {
-            case FOODREQ:
-                   informChef(req.reqGroup);
-                   break;
-            case FOODREADY:
-                   takeFoodToTable(req.reqGroup);
-                   break;
+    /* life cycles of the entity, one per run of the simulation (see runControl.h) */
+    for (run = 0; run < sh->run.runs; run++) {
+        runBegin (&sh->run, run, nFic);
+        logAttach (&sh->log, ENTITYID(ENT_WAITER, id));
+        clockAttach (&sh->clock);
+        latAttach (&sh->lat);
+        replayAttach (&sh->replay, semgid, ENTITYID(ENT_WAITER, id));
+        profAttach (&sh->prof, ENTITYID(ENT_WAITER, id), run);
+
+        /* simulation of the life cycle of the waiter: every group issues a food request and the chefs a food ready
+           for each of them; a waiter claims one of those requests before waiting for it */
+        request req;
+        while (!sh->batched && (replayFetchAdd (&sh->fSt.waiterClaims, 1) < sh->fSt.nGroups*2)) {
+            profBegin (PROF_WAITFORCLIENT);
+            req = waitForClientOrChef();
+            profEnd ();
+            switch(req.reqType) {
+                case FOODREQ:
+                       profBegin (PROF_INFORMCHEF);
+                       informChef(&req.reqGroup, 1);
+                       profEnd ();
+                       break;
+                case FOODREADY:
+                       profBegin (PROF_TAKEFOOD);
+                       takeFoodToTable(&req.reqGroup, 1);
+                       profEnd ();
+                       break;
+            }
         }
-        nReq++;
+        while (sh->batched && serveBatch ()) ;
+
+        clockDetach ();
+        runEnd (&sh->run);
     }
 
     /* unmapping the shared region off the process address space */
@@ -123,11 +163,50 @@ int main (int argc, char *argv[])
     return EXIT_SUCCESS;
 }
 
+/**
+ *  \brief waiter tries to take a request, in the pipelined kitchen or in batched dispatch.
+ *
+ *  The waiter request semaphore counts the requests of the waiter request queue and of the ready queue. Ready
+ *  dishes are taken first; a slot of the waiter request queue is signalled free when one of its requests is taken.
+ *
+ *  \return \c true, if a request submitted by group or chef was taken
+ */
+static bool tryTakeRequest (request *req)
+{
+    if (sh->pipelined && queueTryGet (&sh->fSt.readyRequest, req)) {
+        return true;
+    }
+    if (queueTryGet (&sh->fSt.waiterRequest, req)) {
+        if (semUp (semgid, sh->waiterRequestPossible) == -1) {
+            perror ("error on the up operation for semaphore access (PT)");
+            exit (EXIT_FAILURE);
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ *  \brief waiter takes a request, in the pipelined kitchen.
+ *
+ *  \return request submitted by group or chef
+ */
+static request takeRequest ()
+{
+    request req;
+
+    while (!tryTakeRequest (&req)) {
+        sched_yield ();                                               /* the request is still being inserted */
+    }
+    return req;
+}
+
 /**
  *  \brief waiter waits for next request 
  *
- *  Waiter updates state and waits for request from group or from chef, then reads request.
- *  The waiter should signal that new requests are possible.
+ *  Waiter updates state and waits for request from group or from chef, then takes it from the queue
+ *  (requests are shared by all the waiters).
+ *  The waiter should signal that the slot is free for a new request.
  *  The internal state should be saved.
  *
  *  \return request submitted by group or chef
@@ -136,123 +215,249 @@ static request waitForClientOrChef()
 {
     request req;
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                  
+    if (latDown (semgid, sh->kitchenLock, LAT_KITCHENLOCK) == -1) {                                                  
         perror ("error on the up operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
+    stateBegin (&sh->fSt, DOM_KITCHEN);
     sh->fSt.st.waiterStat = WAIT_FOR_REQUEST;
+    stateEnd (&sh->fSt, DOM_KITCHEN);
     saveState(nFic, &sh->fSt); 
 
     
-    if (semUp (semgid, sh->mutex) == -1) {                                             
+    if (latUp (semgid, sh->kitchenLock, LAT_HOLD_WAITFORCLIENT) == -1) {                                             
         perror ("error on the down operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->waiterRequest) == -1) {
+    if (latDown (semgid, sh->waiterRequest, LAT_WAITERREQUEST) == -1) {
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semDown (semgid, sh->mutex) == -1) {                                                  
+    if (sh->pipelined) {
+        return takeRequest ();
+    }
+
+    req = queueGet (&sh->fSt.waiterRequest);
+
+    if (semUp (semgid, sh->waiterRequestPossible) == -1) {
+        perror ("error on the up operation for semaphore access (PT)");
+        exit (EXIT_FAILURE);
+    }
+    
+    return req;
+
+}
+
+/**
+ *  \brief waiter takes the pending requests, in batched dispatch.
+ *
+ *  Waiter updates state and waits for a request from group or from chef (as waitForClientOrChef does), then takes
+ *  every other request pending at that time as well, up to WAITERBATCH.
+ *
+ *  \param ready array where the groups whose food is ready are stored
+ *  \param nReady pointer to the location where their number is stored
+ *  \param orders array where the groups that order food are stored
+ *  \param nOrders pointer to the location where their number is stored
+ *
+ *  \return \c false, if the waiter was woken up because every request of the run has been served
+ */
+static bool waitForRequests (int ready[], int *nReady, int orders[], int *nOrders)
+{
+    request req;
+
+    if (latDown (semgid, sh->kitchenLock, LAT_KITCHENLOCK) == -1) {
         perror ("error on the up operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
-    req = sh->fSt.waiterRequest;
+    stateBegin (&sh->fSt, DOM_KITCHEN);
+    sh->fSt.st.waiterStat = WAIT_FOR_REQUEST;
+    stateEnd (&sh->fSt, DOM_KITCHEN);
+    saveState(nFic, &sh->fSt); 
 
-    if (semUp (semgid, sh->mutex) == -1) {                                                  
+    if (latUp (semgid, sh->kitchenLock, LAT_HOLD_WAITFORCLIENT) == -1) {
         perror ("error on the down operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
-    if (semUp (semgid, sh->waiterRequestPossible) == -1) {
+    if (latDown (semgid, sh->waiterRequest, LAT_WAITERREQUEST) == -1) {
         perror ("error on the up operation for semaphore access (PT)");
         exit (EXIT_FAILURE);
     }
-    
-    return req;
 
+    *nReady = *nOrders = 0;
+    while (true) {
+        while (!tryTakeRequest (&req)) {
+            if (replayFetchAdd (&sh->fSt.waiterClaims, 0) >= sh->fSt.nGroups*2) {
+                return false;                                               /* woken up at the end of the run */
+            }
+            sched_yield ();                                           /* the request is still being inserted */
+        }
+        if (req.reqType == FOODREADY) {
+            ready[(*nReady)++] = req.reqGroup;
+        }
+        else orders[(*nOrders)++] = req.reqGroup;
+
+        if (*nReady + *nOrders == WAITERBATCH) {
+            break;
+        }
+        if (replayTryDown (semgid, sh->waiterRequest) == -1) {               /* no other request is pending */
+            if (errno != EAGAIN) {
+                perror ("error on the down operation for semaphore access (PT)");
+                exit (EXIT_FAILURE);
+            }
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ *  \brief waiter serves every pending request, in batched dispatch.
+ *
+ *  Dishes are taken to their tables first, so that they do not wait behind new orders; the food orders are then
+ *  taken to the chefs in a single trip. The waiter that serves the last request of the run wakes up the other
+ *  waiters, that find no request.
+ *
+ *  \return \c false, once every request of the run has been served
+ */
+static bool serveBatch ()
+{
+    int ready[WAITERBATCH], orders[WAITERBATCH];
+    int nReady, nOrders, w;
+
+    if (replayFetchAdd (&sh->fSt.waiterClaims, 0) >= sh->fSt.nGroups*2) {
+        return false;
+    }
+    profBegin (PROF_WAITFORCLIENT);
+    if (!waitForRequests (ready, &nReady, orders, &nOrders)) {
+        profEnd ();
+        return false;
+    }
+    profEnd ();
+    if (nReady > 0) {
+        profBegin (PROF_TAKEFOOD);
+        takeFoodToTable (ready, nReady);
+        profEnd ();
+    }
+    if (nOrders > 0) {
+        profBegin (PROF_INFORMCHEF);
+        informChef (orders, nOrders);
+        profEnd ();
+    }
+
+    if (replayFetchAdd (&sh->fSt.waiterClaims, nReady + nOrders) + nReady + nOrders == sh->fSt.nGroups*2) {
+        for (w = 1; w < sh->fSt.nWaiters; w++) {
+            if (semUp (semgid, sh->waiterRequest) == -1) {
+                perror ("error on the up operation for semaphore access (PT)");
+                exit (EXIT_FAILURE);
+            }
+        }
+    }
+    return true;
 }
 
 /**
- *  \brief waiter takes food order to chef 
+ *  \brief waiter takes food orders to chef 
  *
- *  Waiter updates state and then takes food request to chef.
- *  Waiter should inform group that request is received.
- *  Waiter should wait for chef receiving request.
+ *  Waiter updates state and then takes the food requests of n groups to chef, in a single trip.
+ *  Waiter should inform the groups that their requests are received.
+ *  The orders are queued for the first chefs available; the waiter does not wait for them to be picked up.
  *  The internal state should be saved.
  *
  */
-static void informChef (int n)
+static void informChef (int group[], int n)
 {
-    if (semDown (semgid, sh->mutex) == -1)  {                                                  
+    int tableId[WAITERBATCH];
+    request req;
+    int i;
+
+    if (latDown (semgid, sh->kitchenLock, LAT_KITCHENLOCK) == -1)  {                                                  
         perror ("error on the up operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
+    stateBegin (&sh->fSt, DOM_KITCHEN);
     sh->fSt.st.waiterStat = INFORM_CHEF;
+    stateEnd (&sh->fSt, DOM_KITCHEN);
 
     saveState(nFic, &sh->fSt); 
 
-    sh->fSt.foodOrder = 1;
-    sh->fSt.foodGroup = n;
-
-    int tableId = sh->fSt.assignedTable[n];
+    for (i = 0; i < n; i++) {
+        tableId[i] = ASSIGNEDTABLE(&sh->fSt)[group[i]];
+    }
 
     
-    if (semUp (semgid, sh->mutex) == -1) {                                                 
-        perror ("error on the down operation for semaphore access (WT)");
+    /* exit critical region, acknowledge the group and take an order queue slot: the slot is always free, as there
+       is at most one order per group, so the atomic batch of the SVIPC implementation never holds the lock */
+    if (latOps (semgid, (SEM_OP []) { { sh->kitchenLock, 1 }, { REQUESTRECEIVEDSEM(tableId[0]), 1 },
+                                      { sh->orderRequestPossible, -1 } }, 3,
+                LAT_HOLD_INFORMCHEF, LAT_ORDERREQUESTPOSSIBLE) == -1) {
+        perror ("error on the operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
-
-    if (semUp (semgid, sh->requestReceived[tableId]) == -1) {
-        perror ("error on the up operation for semaphore access");
-        exit (EXIT_FAILURE);
+    for (i = 1; i < n; i++) {                                                     /* the other groups of the trip */
+        if (latOps (semgid, (SEM_OP []) { { REQUESTRECEIVEDSEM(tableId[i]), 1 }, { sh->orderRequestPossible, -1 } }, 2,
+                    LAT_NONE, LAT_ORDERREQUESTPOSSIBLE) == -1) {
+            perror ("error on the operation for semaphore access (WT)");
+            exit (EXIT_FAILURE);
+        }
     }
 
-    if (semUp (semgid, sh->waitOrder) == -1) {                                               
-        perror ("error on the up operation for semaphore access");
-        exit (EXIT_FAILURE);
+    for (i = 0; i < n; i++) {
+        req.reqType = FOODREQ;
+        req.reqGroup = group[i];
+        queuePut (&sh->fSt.orderRequest, req);
+        latDepth (LAT_DEPTH_ORDER, queueDepth (&sh->fSt.orderRequest));
     }
 
-    if (semDown (semgid, sh->orderReceived) == -1) {                                                  
-        perror ("error on the up operation for semaphore access (WT)");
-        exit (EXIT_FAILURE);
+    for (i = 0; i < n; i++) {                                        /* every order may be cooked at the same time */
+        if (semUp (semgid, sh->waitOrder) == -1) {                                               
+            perror ("error on the up operation for semaphore access");
+            exit (EXIT_FAILURE);
+        }
     }
+    liveAdd (&sh->live, LIVE_WAITER, n);
 
 }
 
 /**
- *  \brief waiter takes food to table 
+ *  \brief waiter takes food to tables 
  *
- *  Waiter updates its state and takes food to table, allowing the meal to start.
- *  Group must be informed that food is available.
+ *  Waiter updates its state and takes the food of n groups to their tables, allowing the meals to start.
+ *  Groups must be informed that food is available.
  *  The internal state should be saved.
  *
  */
 
-static void takeFoodToTable (int n)
+static void takeFoodToTable (int group[], int n)
 {
-    if (semDown (semgid, sh->mutex) == -1)  {                                                  
+    if (latDown (semgid, sh->kitchenLock, LAT_KITCHENLOCK) == -1)  {                                                  
         perror ("error on the up operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
 
+    stateBegin (&sh->fSt, DOM_KITCHEN);
     sh->fSt.st.waiterStat = TAKE_TO_TABLE;
+    stateEnd (&sh->fSt, DOM_KITCHEN);
     saveState(nFic, &sh->fSt); 
 
-    for (int i = 0; i < TABLEREQ; i++) {
-        if (semUp(semgid, sh->foodArrived[sh->fSt.assignedTable[n]]) == -1) {
-            perror("error on the up operation for semaphore access");
-            exit(EXIT_FAILURE);
+    for (int g = 0; g < n; g++) {
+        for (int i = 0; i < TABLEREQ; i++) {
+            if (semUp(semgid, FOODARRIVEDSEM(ASSIGNEDTABLE(&sh->fSt)[group[g]])) == -1) {
+                perror("error on the up operation for semaphore access");
+                exit(EXIT_FAILURE);
+            }
         }
     }
     
-    if (semUp (semgid, sh->mutex) == -1)  {                                                  
+    if (latUp (semgid, sh->kitchenLock, LAT_HOLD_TAKEFOOD) == -1)  {                                                  
         perror ("error on the down operation for semaphore access (WT)");
         exit (EXIT_FAILURE);
     }
+    liveAdd (&sh->live, LIVE_WAITER, n);
 }
-
@@ -7,22 +7,42 @@
  *     \li creation of a set of semaphores
  *     \li connection to a previously created set of semaphores
  *     \li destruction of a previously created set of semaphores
+ *     \li destruction of a set of semaphores left over by programs that terminated
  *     \li signalling start of operations
  *     \li <em>down</em> of a semaphore within the set
- *     \li <em>up</em> of a semaphore within the set.
+ *     \li <em>down</em> of a semaphore within the set, only if it does not block
+ *     \li <em>up</em> of a semaphore within the set
+ *     \li batch of <em>down</em> and <em>up</em> operations on semaphores within the set
+ *     \li setting the value of a semaphore within the set.
  *
  *  \author António Rui Borges - October 1995
  */
 
 #include <stdio.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/sem.h>
 #include <assert.h>
 
+#include "semaphore.h"
+
 /** \brief access permission: user r-w */
 #define  MASK           0600
 
+/**
+ *  \brief Binding of the storage where the semaphore values are kept.
+ *
+ *  Semaphore values are kept by the kernel in SVIPC, so nothing is done.
+ *
+ *  \param words pointer to the storage area
+ *  \param size number of positions of the storage area (set size plus SEM_EXTRA)
+ */
+
+void semBind (SEM_WORD *words, unsigned int size)
+{
+}
+
 /**
  *  \brief Creation of a set of semaphores.
  *
@@ -80,6 +100,27 @@ int semDestroy (int semgid)
   return semctl (semgid, 0, IPC_RMID, NULL);
 }
 
+/**
+ *  \brief Destruction of a set of semaphores left over by programs that terminated without destroying it.
+ *
+ *  The set with a creation key equal to <tt>key</tt>, if there is one, is destroyed; it must no longer be in use.
+ *
+ *  \param key creation key
+ *
+ *  \return \c 1, if a set was destroyed
+ *  \return \c 0, if there is no set with that creation key
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semReclaim (int key)
+{
+  int semgid;
+
+  if ((semgid = semget ((key_t) key, 0, MASK)) == -1)
+     return (errno == ENOENT) ? 0 : -1;
+  return (semctl (semgid, 0, IPC_RMID, NULL) == -1) ? -1 : 1;
+}
+
 /**
  *  \brief Signalling start of operations upon initialization of shared data structures.
  *
@@ -119,6 +160,28 @@ int semDown (int semgid, unsigned int sindex)
   return semop (semgid, &down, 1);
 }
 
+/**
+ *  \brief <em>Down</em> of a semaphore within the set, only if it does not block.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>, or if the
+ *  semaphore is in <em>red state</em> (<tt>errno</tt> set to <tt>EAGAIN</tt>).
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semTryDown (int semgid, unsigned int sindex)
+{
+  struct sembuf down = { 0, -1, IPC_NOWAIT };                                    /* specific non blocking down operation */
+
+  assert(sindex>0);
+  down.sem_num = (unsigned short) sindex;
+  return semop (semgid, &down, 1);
+}
+
 /**
  *  \brief <em>Up</em> of a semaphore within the set.
  *
@@ -139,3 +202,88 @@ int semUp (int semgid, unsigned int sindex)
   up.sem_num = (unsigned short) sindex;
   return semop (semgid, &up, 1);
 }
+
+/**
+ *  \brief Batch of <em>down</em> and <em>up</em> operations on semaphores within the set.
+ *
+ *  SVIPC: the operations are applied atomically, in a single system call; no operation takes place until every
+ *  <em>down</em> can proceed, so a batch should not release a lock it <em>downs</em> a semaphore after.
+ *  Futex implementation: the operations are applied one after the other, in order.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param ops operations (at most SEM_MAXOPS)
+ *  \param n number of operations
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semOps (int semgid, SEM_OP ops[], unsigned int n)
+{
+  struct sembuf batch[SEM_MAXOPS];                                                              /* batch of operations */
+  unsigned int i;
+
+  assert((n>0) && (n<=SEM_MAXOPS));
+  for (i = 0; i < n; i++)
+  { assert(ops[i].sindex>0);
+    batch[i].sem_num = (unsigned short) ops[i].sindex;
+    batch[i].sem_op = (short) ops[i].op;
+    batch[i].sem_flg = 0;
+  }
+  return semop (semgid, batch, n);
+}
+
+/**
+ *  \brief Setting the value of a semaphore within the set.
+ *
+ *  Meant for resetting a set no process is blocked on.
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param val new value (>= 0)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semSet (int semgid, unsigned int sindex, int val)
+{
+  assert(sindex>0);
+  return semctl (semgid, sindex, SETVAL, val);
+}
+
+/**
+ *  \brief Number of processes blocked on the semaphores of the set.
+ *
+ *  Not available on SVIPC.
+ *
+ *  \param semgid set identifier
+ *
+ *  \return -\c 1, with <tt>errno</tt> set to <tt>ENOSYS</tt>
+ */
+
+int semBlocked (int semgid)
+{
+  errno = ENOSYS;
+  return -1;
+}
+
+/**
+ *  \brief Activity counter of the set.
+ *
+ *  Not available on SVIPC: it fails whatever the set.
+ *
+ *  \param semgid set identifier
+ *  \param pEpoch pointer to the location where the counter is stored
+ *
+ *  \return -\c 1, with <tt>errno</tt> set to <tt>ENOSYS</tt>
+ */
+
+int semEpoch (int semgid, unsigned int *pEpoch)
+{
+  errno = ENOSYS;
+  return -1;
+}
@@ -7,9 +7,18 @@
  *     \li creation of a set of semaphores
  *     \li connection to a previously created set of semaphores
  *     \li destruction of a previously created set of semaphores
+ *     \li destruction of a set of semaphores left over by programs that terminated
  *     \li signalling start of operations
  *     \li <em>down</em> of a semaphore within the set
- *     \li <em>up</em> of a semaphore within the set.
+ *     \li <em>down</em> of a semaphore within the set, only if it does not block
+ *     \li <em>up</em> of a semaphore within the set
+ *     \li batch of <em>down</em> and <em>up</em> operations on semaphores within the set
+ *     \li setting the value of a semaphore within the set.
+ *
+ *  Two implementations are available, selected at build time:
+ *     \li semaphore.c - SVIPC semaphore sets
+ *     \li semaphoreFutex.c - semaphore values kept in shared memory, the kernel is only entered (futex
+ *         wait / wake) when a process has to block or a blocked process has to be woken up.
  *
  *  \author António Rui Borges - October 1995
  */
@@ -17,6 +26,49 @@
 #ifndef SEMAPHORE_H_
 #define SEMAPHORE_H_
 
+/** \brief number of positions of the storage area besides the semaphores of the set (futex implementation) */
+#define  SEM_EXTRA      3
+
+/** \brief size of the storage of a semaphore: a cache line, not shared by semaphores of different entities */
+#define  SEM_WORDSIZE   64
+
+/**
+ *  \brief Definition of the storage of a semaphore (futex implementation).
+ */
+typedef struct {
+    /** \brief semaphore value */
+    int val;
+    /** \brief number of processes blocked on the semaphore */
+    int waiters;
+    /** \brief padding up to SEM_WORDSIZE */
+    char pad[SEM_WORDSIZE - 2 * sizeof (int)];
+} SEM_WORD;
+
+/** \brief maximum number of operations of a batch */
+#define  SEM_MAXOPS     8
+
+/**
+ *  \brief Definition of an operation of a batch (see semOps).
+ */
+typedef struct {
+    /** \brief semaphore location in the set (1 .. snum) */
+    unsigned int sindex;
+    /** \brief -1 for a <em>down</em>, 1 for an <em>up</em> */
+    int op;
+} SEM_OP;
+
+/**
+ *  \brief Binding of the storage where the semaphore values are kept.
+ *
+ *  Must be called before <tt>semCreate</tt> or <tt>semConnect</tt>, when the storage is located in a shared memory
+ *  region already mapped on the process address space. It has no effect on the SVIPC implementation.
+ *
+ *  \param words pointer to the storage area
+ *  \param size number of positions of the storage area (set size plus SEM_EXTRA)
+ */
+
+extern void semBind (SEM_WORD *words, unsigned int size);
+
 /**
  *  \brief Creation of a set of semaphores.
  *
@@ -58,6 +110,20 @@ extern int semConnect (int key);
 
 extern int semDestroy (int semgid);
 
+/**
+ *  \brief Destruction of a set of semaphores left over by programs that terminated without destroying it.
+ *
+ *  The set with a creation key equal to <tt>key</tt>, if there is one, is destroyed; it must no longer be in use.
+ *
+ *  \param key creation key
+ *
+ *  \return \c 1, if a set was destroyed
+ *  \return \c 0, if there is no set with that creation key
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semReclaim (int key);
+
 /**
  *  \brief Signalling start of operations upon initialization of shared data structures.
  *
@@ -85,6 +151,21 @@ extern int semSignal (int semgid);
 
 extern int semDown (int semgid, unsigned int sindex);
 
+/**
+ *  \brief <em>Down</em> of a semaphore within the set, only if it does not block.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>, or if the
+ *  semaphore is in <em>red state</em> (<tt>errno</tt> set to <tt>EAGAIN</tt>).
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semTryDown (int semgid, unsigned int sindex);
+
 /**
  *  \brief <em>Up</em> of a semaphore within the set.
  *
@@ -99,4 +180,69 @@ extern int semDown (int semgid, unsigned int sindex);
 
 extern int semUp (int semgid, unsigned int sindex);
 
+/**
+ *  \brief Batch of <em>down</em> and <em>up</em> operations on semaphores within the set.
+ *
+ *  SVIPC: the operations are applied atomically, in a single system call; no operation takes place until every
+ *  <em>down</em> can proceed, so a batch should not release a lock it <em>downs</em> a semaphore after.
+ *  Futex implementation: the operations are applied one after the other, in order.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param ops operations (at most SEM_MAXOPS)
+ *  \param n number of operations
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semOps (int semgid, SEM_OP ops[], unsigned int n);
+
+/**
+ *  \brief Setting the value of a semaphore within the set.
+ *
+ *  Meant for resetting a set no process is blocked on.
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param val new value (>= 0)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+extern int semSet (int semgid, unsigned int sindex, int val);
+
+/**
+ *  \brief Number of processes blocked on the semaphores of the set.
+ *
+ *  Processes that were woken up by an <em>up</em> and have not yet resumed are not counted.
+ *  Only available on the futex implementation (it fails with <tt>ENOSYS</tt> on SVIPC, whatever the set, so that
+ *  the implementation can be told apart before any set is created).
+ *
+ *  \param semgid set identifier
+ *
+ *  \return number of blocked processes, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semBlocked (int semgid);
+
+/**
+ *  \brief Activity counter of the set.
+ *
+ *  Incremented whenever a process blocks on a semaphore of the set or an <em>up</em> wakes up a blocked
+ *  process: two equal readings enclosing <tt>semBlocked</tt> guarantee its result was not changed meanwhile.
+ *  Only available on the futex implementation (it fails with <tt>ENOSYS</tt> on SVIPC).
+ *
+ *  \param semgid set identifier
+ *  \param pEpoch pointer to the location where the counter is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+extern int semEpoch (int semgid, unsigned int *pEpoch);
+
 #endif /* SEMAPHORE_H_ */
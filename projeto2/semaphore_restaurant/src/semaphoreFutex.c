@@ -0,0 +1,414 @@
+/**
+ *  \file semaphoreFutex.c (implementation file)
+ *
+ *  \brief Semaphore management.
+ *
+ *  Operations defined on semaphores:
+ *     \li creation of a set of semaphores
+ *     \li connection to a previously created set of semaphores
+ *     \li destruction of a previously created set of semaphores
+ *     \li destruction of a set of semaphores left over by programs that terminated
+ *     \li signalling start of operations
+ *     \li <em>down</em> of a semaphore within the set
+ *     \li <em>down</em> of a semaphore within the set, only if it does not block
+ *     \li <em>up</em> of a semaphore within the set
+ *     \li batch of <em>down</em> and <em>up</em> operations on semaphores within the set
+ *     \li setting the value of a semaphore within the set.
+ *
+ *  Implementation with futexes: semaphore values are kept in a storage area located in shared memory
+ *  (see <tt>semBind</tt>) and updated with atomic operations. The kernel is only entered when a <em>down</em>
+ *  finds the semaphore in red state, or when an <em>up</em> finds blocked processes.
+ *
+ *  Position 0 of the storage area is the set header (creation key and number of semaphores), position 1 holds the
+ *  activity counter, position 2 is the start of operations semaphore and positions 3 .. snum+2 hold the
+ *  semaphores 1 .. snum of the set.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <assert.h>
+
+#include "semaphore.h"
+
+/** \brief storage area bound to the calling process */
+static SEM_WORD *semWords = NULL;
+
+/** \brief number of positions of the storage area */
+static unsigned int semSize = 0;
+
+/** \brief creation key of the set (0 if none) */
+#define  KEY                (semWords[0].val)
+
+/** \brief number of semaphores in the set */
+#define  SNUM               (semWords[0].waiters)
+
+/** \brief activity counter (see semEpoch) */
+#define  EPOCH              (semWords[1].val)
+
+/** \brief storage of semaphore sindex (0 is the start of operations semaphore) */
+#define  SEM(sindex)        (&semWords[(sindex) + 2])
+
+/** \brief set identifier returned to callers (there is at most one set per process) */
+#define  SEMGID             1
+
+/* internal functions */
+
+static long futex (int *addr, int op, int val)
+{
+  return syscall (SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+static int semValid (int semgid, unsigned int sindex)
+{
+  if ((semgid != SEMGID) || (semWords == NULL) || (sindex > (unsigned int) SNUM))
+     { errno = EINVAL;
+       return -1;
+     }
+  return 0;
+}
+
+static void down (SEM_WORD *s)
+{
+  int v;
+
+  while (true)
+  { v = __atomic_load_n (&s->val, __ATOMIC_SEQ_CST);
+    if (v > 0)
+       { if (__atomic_compare_exchange_n (&s->val, &v, v - 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            return;
+         continue;
+       }
+    __atomic_add_fetch (&s->waiters, 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch (&EPOCH, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n (&s->val, __ATOMIC_SEQ_CST) <= 0)
+      futex (&s->val, FUTEX_WAIT, 0);                               /* returns on wake up, EAGAIN or EINTR */
+    __atomic_sub_fetch (&s->waiters, 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+static void up (SEM_WORD *s)
+{
+  __atomic_add_fetch (&s->val, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n (&s->waiters, __ATOMIC_SEQ_CST) > 0)
+     { __atomic_add_fetch (&EPOCH, 1, __ATOMIC_SEQ_CST);
+       futex (&s->val, FUTEX_WAKE, 1);
+     }
+}
+
+/* external functions */
+
+/**
+ *  \brief Binding of the storage where the semaphore values are kept.
+ *
+ *  Must be called before <tt>semCreate</tt> or <tt>semConnect</tt>, when the storage is located in a shared memory
+ *  region already mapped on the process address space.
+ *
+ *  \param words pointer to the storage area
+ *  \param size number of positions of the storage area (set size plus SEM_EXTRA)
+ */
+
+void semBind (SEM_WORD *words, unsigned int size)
+{
+  semWords = words;
+  semSize = size;
+}
+
+/**
+ *  \brief Creation of a set of semaphores.
+ *
+ *  All semaphores in the set will be in set to <em>red state</em> upon creation.
+ *  The function fails if there is already a semaphore set with a creation key equal to <tt>key</tt>, or if
+ *  the set does not fit in the bound storage area.
+ *
+ *  \param key creation key
+ *  \param snum number of semaphores in the set (>= 1)
+ *
+ *  \return set identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semCreate (int key, unsigned int snum)
+{
+  unsigned int i;
+
+  if ((semWords == NULL) || (snum < 1) || (snum + SEM_EXTRA > semSize))
+     { errno = EINVAL;
+       return -1;
+     }
+  if (KEY == key)
+     { errno = EEXIST;
+       return -1;
+     }
+  for (i = 1; i < snum + SEM_EXTRA; i++)
+  { semWords[i].val = 0;
+    semWords[i].waiters = 0;
+  }
+  SNUM = (int) snum;
+  __atomic_store_n (&KEY, key, __ATOMIC_SEQ_CST);
+  return SEMGID;
+}
+
+/**
+ *  \brief Connection to a previously created set of semaphores.
+ *
+ *  The function fails if there is no semaphore set with a creation key equal to <tt>key</tt>.
+ *  The calling process is blocked until start of operations is signalled.
+ *
+ *  \param key creation key
+ *
+ *  \return set identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semConnect (int key)
+{
+  if ((semWords == NULL) || (__atomic_load_n (&KEY, __ATOMIC_SEQ_CST) != key))
+     { errno = ENOENT;
+       return -1;
+     }
+  down (SEM(0));
+  up (SEM(0));
+  return SEMGID;
+}
+
+/**
+ *  \brief Destruction of a previously created set of semaphores.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semDestroy (int semgid)
+{
+  if (semValid (semgid, 0) == -1)
+     return -1;
+  __atomic_store_n (&KEY, 0, __ATOMIC_SEQ_CST);
+  return 0;
+}
+
+/**
+ *  \brief Destruction of a set of semaphores left over by programs that terminated without destroying it.
+ *
+ *  The set with a creation key equal to <tt>key</tt>, if there is one, is destroyed; it must no longer be in use.
+ *
+ *  The values of the set are kept in the shared region, and go with it, so there is never such a set.
+ *
+ *  \param key creation key
+ *
+ *  \return \c 1, if a set was destroyed
+ *  \return \c 0, if there is no set with that creation key
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semReclaim (int key)
+{
+  return 0;
+}
+
+/**
+ *  \brief Signalling start of operations upon initialization of shared data structures.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semSignal (int semgid)
+{
+  if (semValid (semgid, 0) == -1)
+     return -1;
+  up (SEM(0));
+  return 0;
+}
+
+/**
+ *  \brief <em>Down</em> of a semaphore within the set.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semDown (int semgid, unsigned int sindex)
+{
+  assert(sindex>0);
+  if (semValid (semgid, sindex) == -1)
+     return -1;
+  down (SEM(sindex));
+  return 0;
+}
+
+/**
+ *  \brief <em>Down</em> of a semaphore within the set, only if it does not block.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>, or if the
+ *  semaphore is in <em>red state</em> (<tt>errno</tt> set to <tt>EAGAIN</tt>).
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semTryDown (int semgid, unsigned int sindex)
+{
+  int v;
+
+  assert(sindex>0);
+  if (semValid (semgid, sindex) == -1)
+     return -1;
+  v = __atomic_load_n (&SEM(sindex)->val, __ATOMIC_SEQ_CST);
+  while (v > 0)
+    if (__atomic_compare_exchange_n (&SEM(sindex)->val, &v, v - 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+       return 0;
+  errno = EAGAIN;
+  return -1;
+}
+
+/**
+ *  \brief <em>Up</em> of a semaphore within the set.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semUp (int semgid, unsigned int sindex)
+{
+  assert(sindex>0);
+  if (semValid (semgid, sindex) == -1)
+     return -1;
+  up (SEM(sindex));
+  return 0;
+}
+
+/**
+ *  \brief Batch of <em>down</em> and <em>up</em> operations on semaphores within the set.
+ *
+ *  SVIPC: the operations are applied atomically, in a single system call; no operation takes place until every
+ *  <em>down</em> can proceed, so a batch should not release a lock it <em>downs</em> a semaphore after.
+ *  Futex implementation: the operations are applied one after the other, in order.
+ *
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param ops operations (at most SEM_MAXOPS)
+ *  \param n number of operations
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semOps (int semgid, SEM_OP ops[], unsigned int n)
+{
+  unsigned int i;
+
+  assert((n>0) && (n<=SEM_MAXOPS));
+  for (i = 0; i < n; i++)
+    if (semValid (semgid, ops[i].sindex) == -1)
+       return -1;
+  for (i = 0; i < n; i++)
+    if (ops[i].op < 0)
+       down (SEM(ops[i].sindex));
+       else up (SEM(ops[i].sindex));
+  return 0;
+}
+
+/**
+ *  \brief Setting the value of a semaphore within the set.
+ *
+ *  Meant for resetting a set no process is blocked on.
+ *  The function fails if there is no semaphore set with an identifier equal to <tt>semgid</tt>.
+ *
+ *  \param semgid set identifier
+ *  \param sindex semaphore location in the set (1 .. snum)
+ *  \param val new value (>= 0)
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semSet (int semgid, unsigned int sindex, int val)
+{
+  assert(sindex>0);
+  if (semValid (semgid, sindex) == -1)
+     return -1;
+  if (val < 0)
+     { errno = EINVAL;
+       return -1;
+     }
+  __atomic_store_n (&SEM(sindex)->val, val, __ATOMIC_SEQ_CST);
+  if ((val > 0) && (__atomic_load_n (&SEM(sindex)->waiters, __ATOMIC_SEQ_CST) > 0))
+     { __atomic_add_fetch (&EPOCH, 1, __ATOMIC_SEQ_CST);
+       futex (&SEM(sindex)->val, FUTEX_WAKE, val);
+     }
+  return 0;
+}
+
+/**
+ *  \brief Number of processes blocked on the semaphores of the set.
+ *
+ *  Processes that were woken up by an <em>up</em> and have not yet resumed are not counted.
+ *
+ *  \param semgid set identifier
+ *
+ *  \return number of blocked processes, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semBlocked (int semgid)
+{
+  unsigned int i;
+  int n = 0, w, v;
+
+  if (semValid (semgid, 0) == -1)
+     return -1;
+  for (i = 0; i <= (unsigned int) SNUM; i++)
+  { w = __atomic_load_n (&SEM(i)->waiters, __ATOMIC_SEQ_CST);
+    v = __atomic_load_n (&SEM(i)->val, __ATOMIC_SEQ_CST);
+    if (w > v)                                              /* each unit of a green semaphore releases a waiter */
+       n += (v > 0) ? w - v : w;
+  }
+  return n;
+}
+
+/**
+ *  \brief Activity counter of the set.
+ *
+ *  Incremented whenever a process blocks on a semaphore of the set or an <em>up</em> wakes up a blocked
+ *  process: two equal readings enclosing <tt>semBlocked</tt> guarantee its result was not changed meanwhile.
+ *
+ *  \param semgid set identifier
+ *  \param pEpoch pointer to the location where the counter is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int semEpoch (int semgid, unsigned int *pEpoch)
+{
+  if (semValid (semgid, 0) == -1)
+     return -1;
+  *pEpoch = (unsigned int) __atomic_load_n (&EPOCH, __ATOMIC_SEQ_CST);
+  return 0;
+}
@@ -11,50 +11,147 @@
  *  Both the format of the shared data, which represents the full state of the problem, and the identification of
  *  the different semaphores, which carry out the synchronization among the intervening entities, are provided.
  *
+ *  Lock domains and lock order:
+ *     \li groupLock[g]  - state of group g
+ *     \li receptionLock - receptionist state, groups waiting and assigned tables
+ *     \li kitchenLock   - waiter and chef states
+ *     \li mutex         - global lock (see below).
+ *
+ *  A process holds at most one domain lock at a time. Fields of other domains are either read through the
+ *  sequence counters of the domains (saveState, that takes no lock) or, as the table assigned to a group, only
+ *  after the semaphore handshake that follows their update. With the global lock option of the generator all the
+ *  domain locks are the mutex itself.
+ *
  *  \author Nuno Lau - December 2023
  */
 
 #ifndef SHAREDDATASYNC_H_
 #define SHAREDDATASYNC_H_
 
+#include <stddef.h>
+
 #include "probConst.h"
 #include "probDataStruct.h"
+#include "semaphore.h"
+#include "replay.h"
 
 /**
  *  \brief Definition of <em>shared information</em> data type.
+ *
+ *  The structure is the header of the shared region; it is followed by the arrays of the full state, the
+ *  log buffer and the semaphore storage, whose sizes depend on the number of groups and tables read from the
+ *  configuration file. Its fields are read only after the initialization, except the ones of the full state, the
+ *  control data of logging, clock, latencies, runs and replay, the profiling data and the live counters, which
+ *  keep their changing fields on cache lines of their own (checked below).
  */
 typedef struct
-        { /** \brief full state of the problem */
-          FULL_STAT fSt;
+        { /** \brief total size of the shared region (bytes) */
+          unsigned int size;
+
+          /** \brief logging control data */
+          LOG_SHARED log;
+
+          /** \brief simulation clock */
+          SIM_CLOCK clock;
+
+          /** \brief latency instrumentation data */
+          LAT_SHARED lat;
+
+          /** \brief live counters */
+          LIVE_STATS live;
+
+          /** \brief seed of the pseudo random number generators of the entities (see prng.h) */
+          unsigned long long seed;
+
+          /** \brief control of the runs (server mode) */
+          RUN_CONTROL run;
+
+          /** \brief replay engine control data */
+          REPLAY_SHARED replay;
+
+          /** \brief profiling data */
+          PROF_SHARED prof;
 
           /* semaphores ids */
-          /** \brief identification of critical region protection semaphore – val = 1 */
+          /** \brief identification of critical region protection semaphore (global lock) – val = 1 */
           unsigned int mutex;
+          /** \brief identification of reception domain lock – val = 1 */
+          unsigned int receptionLock;
+          /** \brief identification of kitchen domain lock – val = 1 */
+          unsigned int kitchenLock;
+          /** \brief identification of first group domain lock (see GROUPLOCKSEM) – val = 1 */
+          unsigned int groupLock;
+          /** \brief all the domain locks are the mutex */
+          bool globalLock;
+          /** \brief pipelined kitchen: chefs put the dishes in the ready queue, not in the waiter request queue */
+          bool pipelined;
+          /** \brief batched dispatch: waiters serve every pending request when they wake up, dishes first */
+          bool batched;
+          /** \brief seating ahead: a waiting group that fits a vacant table is seated, even if groups that have been waiting
+                     for longer do not fit it */
+          bool seatAhead;
+          /** \brief event loop: the receptionist serves every pending check in and check out when it wakes up */
+          bool eventLoop;
           /** \brief identification of semaphore used by receptionist to wait for groups - val = 0 */
           unsigned int receptionistReq;
-          /** \brief identification of semaphore used by groups to wait before issuing receptionist request - val = 1 */
+          /** \brief identification of semaphore used by groups to wait for a free receptionist queue slot - val = queue size */
           unsigned int receptionistRequestPossible;
-          /** \brief identification of semaphore used by waiter to wait for requests – val = 0  */
+          /** \brief identification of semaphore used by waiter to wait for requests (of both queues) – val = 0  */
           unsigned int waiterRequest;
-          /** \brief identification of semaphore used by groups and chef to wait before issuing waiter request - val = 1 */
+          /** \brief identification of semaphore used by groups and chef to wait for a free waiter queue slot - val = queue size */
           unsigned int waiterRequestPossible;
-          /** \brief identification of semaphore used by chef to wait for order – val = 0  */
+          /** \brief identification of semaphore used by chefs to wait for orders – val = 0  */
           unsigned int waitOrder;
-          /** \brief identification of semaphore used by waiter to wait for chef – val = 0  */
-          unsigned int orderReceived;
-          /** \brief identification of semaphore used by groups to wait for table – val = 0 */
-          unsigned int waitForTable[MAXGROUPS];
-          /** \brief identification of semaphore used by groups to wait for waiter ackowledge – val = 0  */
-          unsigned int requestReceived[NUMTABLES];
-          /** \brief identification of semaphore used by groups to wait for food – val = 0 */
-          unsigned int foodArrived[NUMTABLES];
-          /** \brief identification of semaphore used by groups to wait for payment completed – val = 0 */
-          unsigned int tableDone[NUMTABLES];
+          /** \brief identification of semaphore used by waiters to wait for a free order queue slot – val = queue size */
+          unsigned int orderRequestPossible;
+          /** \brief identification of first semaphore used by groups to wait for table (one per group) – val = 0 */
+          unsigned int waitForTable;
+          /** \brief identification of first semaphore used by groups to wait for waiter ackowledge (one per table) – val = 0  */
+          unsigned int requestReceived;
+          /** \brief identification of first semaphore used by groups to wait for food (one per table) – val = 0 */
+          unsigned int foodArrived;
+          /** \brief identification of first semaphore used by groups to wait for payment completed (one per table) – val = 0 */
+          unsigned int tableDone;
+
+          /** \brief offset of the storage of the semaphore values (futex implementation) */
+          unsigned int offSemWords;
+
+          /** \brief full state of the problem (last field: its arrays follow the header) */
+          FULL_STAT fSt;
 
         } SHARED_DATA;
 
+/* layout checks: the fields written by different entities or lock domains do not share a cache line */
+_Static_assert (offsetof (FULL_STAT, st) <= CACHELINE, "read only part of FULL_STAT must fit a cache line");
+_Static_assert (sizeof (STAT) == 3 * CACHELINE, "every entity state of STAT must have a cache line of its own");
+_Static_assert ((offsetof (FULL_STAT, waiterClaims) - offsetof (FULL_STAT, groupsWaiting) == CACHELINE) &&
+                (offsetof (FULL_STAT, chefClaims) - offsetof (FULL_STAT, waiterClaims) == CACHELINE),
+                "groupsWaiting and the claim counters must have a cache line of their own");
+_Static_assert ((offsetof (REQ_QUEUE, head) == CACHELINE) && (offsetof (REQ_QUEUE, tail) == 2 * CACHELINE) &&
+                (sizeof (REQ_QUEUE) == 3 * CACHELINE), "request queue counters must have a cache line of their own");
+_Static_assert ((offsetof (LOG_BUFFER, tail) - offsetof (LOG_BUFFER, head)) == CACHELINE,
+                "log buffer counters must have a cache line of their own");
+_Static_assert (sizeof (((LOG_SHARED *) 0)->saved[0]) == CACHELINE,
+                "summary counters of an entity kind must fill a cache line");
+_Static_assert (offsetof (SHARED_DATA, fSt) % CACHELINE == 0, "FULL_STAT must start a cache line");
+_Static_assert (sizeof (LIVE_COUNTER) == CACHELINE, "every live counter must have a cache line of its own");
+_Static_assert ((offsetof (REPLAY_SHARED, nEvents) == CACHELINE) && (offsetof (REPLAY_SHARED, next) == 2 * CACHELINE),
+                "replay counters must have a cache line of their own");
+_Static_assert ((offsetof (PROF_SHARED, nSpans) == CACHELINE) && (sizeof (PROF_SPAN) == CACHELINE),
+                "the span counter and every span must have a cache line of their own");
+_Static_assert (sizeof (SEM_WORD) == CACHELINE, "the storage of a semaphore must be a cache line");
+
+/** \brief number of semaphores in a set for ng groups, nt tables and nr semaphores of the replay engine */
+#define SEM_COUNT(ng,nt,nr)  ( 9 + 2*(ng) + 3*(nt) + (nr) )
+
 /** \brief number of semaphores in the set */
-#define SEM_NU               ( 7 + sh->fSt.nGroups + 3*NUMTABLES )
+#define SEM_NU               SEM_COUNT(sh->fSt.nGroups, sh->fSt.nTables, REPLAYSEMS(sh->replay.mode, sh->replay.nSlots))
+
+/** \brief number of positions of the semaphore storage area (set header and start semaphore included) */
+#define SEM_SLOTS            ( SEM_NU + SEM_EXTRA )
+
+/** \brief storage of the semaphore values */
+#define SEMWORDS             SHARRAY(sh, sh->offSemWords, SEM_WORD)
 
 #define MUTEX                  1
 #define RECEPTIONISTREQ        2
@@ -62,10 +159,25 @@ typedef struct
 #define WAITERREQUEST          4
 #define WAITERREQUESTPOSSIBLE  5
 #define WAITORDER              6
-#define ORDERRECEIVED          7
-#define WAITFORTABLE           8
-#define FOODARRIVED            (WAITFORTABLE+sh->fSt.nGroups)
-#define REQUESTRECEIVED        (FOODARRIVED+NUMTABLES)
-#define TABLEDONE              (REQUESTRECEIVED+NUMTABLES)
+#define ORDERREQUESTPOSSIBLE   7
+#define RECEPTIONLOCK          8
+#define KITCHENLOCK            9
+#define WAITFORTABLE           10
+#define GROUPLOCK              (WAITFORTABLE+sh->fSt.nGroups)
+#define FOODARRIVED            (GROUPLOCK+sh->fSt.nGroups)
+#define REQUESTRECEIVED        (FOODARRIVED+sh->fSt.nTables)
+#define TABLEDONE              (REQUESTRECEIVED+sh->fSt.nTables)
+#define REPLAYLOCK             (TABLEDONE+sh->fSt.nTables)
+
+/** \brief identification of semaphore used by group g to wait for table */
+#define WAITFORTABLESEM(g)     (sh->waitForTable + (g))
+/** \brief identification of domain lock of group g */
+#define GROUPLOCKSEM(g)        (sh->globalLock ? sh->mutex : sh->groupLock + (g))
+/** \brief identification of semaphore used by group at table t to wait for waiter ackowledge */
+#define REQUESTRECEIVEDSEM(t)  (sh->requestReceived + (t))
+/** \brief identification of semaphore used by group at table t to wait for food */
+#define FOODARRIVEDSEM(t)      (sh->foodArrived + (t))
+/** \brief identification of semaphore used by group at table t to wait for payment completed */
+#define TABLEDONESEM(t)        (sh->tableDone + (t))
 
 #endif /* SHAREDDATASYNC_H_ */
@@ -7,6 +7,7 @@
  *      \li creation of a new block
  *      \li connection to a previously created block
  *      \li destruction of a previously created block
+ *      \li destruction of a block left over by programs that terminated
  *      \li mapping of the block previously created on the process address space
  *      \li unmapping of the block off the process address space.
  *
@@ -14,6 +15,7 @@
  */
 
 #include <stdio.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/shm.h>
 
@@ -69,6 +71,36 @@ int shmemDestroy (int shmid)
   return shmctl (shmid, IPC_RMID, (struct shmid_ds *) NULL);
 }
 
+/**
+ *  \brief Destruction of a block left over by programs that terminated without destroying it.
+ *
+ *  The block with a creation key equal to <tt>key</tt>, if there is one, is only destroyed when it is not mapped
+ *  on the address space of any process.
+ *
+ *  \param key creation key
+ *
+ *  \return \c 1, if a block was destroyed
+ *  \return \c 0, if there is no block with that creation key
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>; EBUSY if the block is
+ *          mapped by some process)
+ */
+
+int shmemReclaim (int key)
+{
+  struct shmid_ds ds;
+  int shmid;
+
+  if ((shmid = shmget ((key_t) key, 1, MASK)) == -1)
+     return (errno == ENOENT) ? 0 : -1;
+  if (shmctl (shmid, IPC_STAT, &ds) == -1)
+     return -1;
+  if (ds.shm_nattch != 0)
+     { errno = EBUSY;
+       return -1;
+     }
+  return (shmctl (shmid, IPC_RMID, (struct shmid_ds *) NULL) == -1) ? -1 : 1;
+}
+
 /**
  *  \brief Mapping of the block previously created on the process address space.
  *
@@ -7,9 +7,14 @@
  *      \li creation of a new block
  *      \li connection to a previously created block
  *      \li destruction of a previously created block
+ *      \li destruction of a block left over by programs that terminated
  *      \li mapping of the block previously created on the process address space
  *      \li unmapping of the block off the process address space.
  *
+ *  Two implementations are available, selected at build time:
+ *     \li sharedMemory.c - SVIPC shared memory
+ *     \li sharedMemoryThread.c - memory of the calling process, for entities that are threads of that process.
+ *
  *  \author António Rui Borges - October 1995
  */
 
@@ -56,6 +61,22 @@ extern int shmemConnect (int key);
 
 extern int shmemDestroy (int shmid);
 
+/**
+ *  \brief Destruction of a block left over by programs that terminated without destroying it.
+ *
+ *  The block with a creation key equal to <tt>key</tt>, if there is one, is only destroyed when it is not mapped
+ *  on the address space of any process.
+ *
+ *  \param key creation key
+ *
+ *  \return \c 1, if a block was destroyed
+ *  \return \c 0, if there is no block with that creation key
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>; EBUSY if the block is
+ *          mapped by some process)
+ */
+
+extern int shmemReclaim (int key);
+
 /**
  *  \brief Mapping of the block previously created on the process address space.
  *
@@ -0,0 +1,167 @@
+/**
+ *  \file sharedMemoryThread.c (implementation file)
+ *
+ *  \brief Shared memory management.
+ *
+ *   Operations defined on shared memory:
+ *      \li creation of a new block
+ *      \li connection to a previously created block
+ *      \li destruction of a previously created block
+ *      \li destruction of a block left over by programs that terminated
+ *      \li mapping of the block previously created on the process address space
+ *      \li unmapping of the block off the process address space.
+ *
+ *  Implementation for entities that are threads of the same process: a block is zero filled, page aligned memory of
+ *  the process, shared by all its threads. There is at most one block at a time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/** \brief block identifier returned to callers */
+#define  SHMID          1
+
+/** \brief alignment of the block (a page, as a region mapped by shmat) */
+#define  BLOCKALIGN     4096
+
+/** \brief storage of the block (NULL if none) */
+static void *block = NULL;
+
+/** \brief creation key of the block */
+static int blockKey;
+
+/**
+ *  \brief Creation of a new block.
+ *
+ *  The function fails if there is already a block of shared memory with a creation key equal to <tt>key</tt>.
+ *
+ *  \param key creation key
+ *  \param size block size (in bytes)
+ *
+ *  \return block identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemCreate (int key, unsigned int size)
+{
+  if (block != NULL)
+     { errno = EEXIST;
+       return -1;
+     }
+  if ((errno = posix_memalign (&block, BLOCKALIGN, size)) != 0)
+     { block = NULL;
+       return -1;
+     }
+  memset (block, 0, size);
+  blockKey = key;
+  return SHMID;
+}
+
+/**
+ *  \brief Connection to a previously created block.
+ *
+ *  The function fails if there is no block with a creation key equal to <tt>key</tt>.
+ *
+ *  \param key creation key
+ *
+ *  \return block identifier, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemConnect (int key)
+{
+  if ((block == NULL) || (blockKey != key))
+     { errno = ENOENT;
+       return -1;
+     }
+  return SHMID;
+}
+
+/**
+ *  \brief Destruction of a previously created block.
+ *
+ *  The function fails if there is no block with an identifier equal to <tt>shmid</tt>.
+ *
+ *  \param shmid block identifier
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemDestroy (int shmid)
+{
+  if ((block == NULL) || (shmid != SHMID))
+     { errno = EINVAL;
+       return -1;
+     }
+
+  free (block);
+  block = NULL;
+  return 0;
+}
+
+/**
+ *  \brief Destruction of a block left over by programs that terminated without destroying it.
+ *
+ *  The block with a creation key equal to <tt>key</tt>, if there is one, is only destroyed when it is not mapped
+ *  on the address space of any process.
+ *
+ *  The block of a process ends with it, so there is never such a block.
+ *
+ *  \param key creation key
+ *
+ *  \return \c 1, if a block was destroyed
+ *  \return \c 0, if there is no block with that creation key
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>; EBUSY if the block is
+ *          mapped by some process)
+ */
+
+int shmemReclaim (int key)
+{
+  return 0;
+}
+
+/**
+ *  \brief Mapping of the block previously created on the process address space.
+ *
+ *  The function fails if there is no block with an identifier equal to <tt>shmid</tt>.
+ *
+ *  \param shmid block identifier
+ *  \param pAttAdd pointer to the location where the local address of the attached block is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemAttach (int shmid, void **pAttAdd)
+{
+  if ((block == NULL) || (shmid != SHMID))
+     { errno = EINVAL;
+       return -1;
+     }
+  *pAttAdd = block;
+  return 0;
+}
+
+/**
+ *  \brief Unmapping of the block off the process address space.
+ *
+ *  The function fails if the pointer does not locate a region of the address space
+ *  where a mapping took previously place.
+ *
+ *  \param attAdd local address of the attached block
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, when an error occurs (the actual situation is reported in <tt>errno</tt>)
+ */
+
+int shmemDettach (void *attAdd)
+{
+  if ((block == NULL) || (attAdd != block))
+     { errno = EINVAL;
+       return -1;
+     }
+  return 0;
+}
@@ -0,0 +1,232 @@
+/**
+ *  \file simClock.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Simulation clock.
+ *
+ *  Defined operations:
+ *     \li clock initialization
+ *     \li binding of an entity to the clock and its release
+ *     \li sleeping for a given time
+ *     \li reading the present time
+ *     \li advancing virtual time (clock task).
+ *
+ *  Virtual time only advances when the clock task sees, between two equal readings of the activity counters of
+ *  the clock and of the semaphore set, that every live entity is either sleeping until a later time or blocked
+ *  on a semaphore. Sleeping entities wait on the clock tick (futex) and are all woken up when it changes. How far
+ *  it jumps is recorded or replayed by the replay engine (see replay.h): when replaying, it only jumps at its turn.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "probDataStruct.h"
+#include "simClock.h"
+#include "semaphore.h"
+#include "replay.h"
+
+/** \brief polling period of the clock task when some entity is running (in us) */
+#define  CLOCKPOLL          20
+
+/** \brief wake up time of entity slot i (0 if not sleeping) */
+#define  WAKE(c,i)          (SHARRAY(c, (c)->offWake, unsigned long long)[i])
+
+/** \brief clock the calling entity is bound to (NULL if none) */
+static __thread SIM_CLOCK *clk = NULL;
+
+/** \brief entity slot of the calling entity */
+static __thread int slot = -1;
+
+/* internal functions */
+
+static long futex (int *addr, int op, int val)
+{
+    return syscall (SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+/** \brief monotonic clock (in ns) */
+static unsigned long long nowNs (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* external functions */
+
+/**
+ *  \brief Size of the area that holds the wake up times of the entities.
+ *
+ *  \param nEntities number of entities
+ *
+ *  \return size in bytes, multiple of 8
+ */
+size_t clockSize (int nEntities)
+{
+    return nEntities * sizeof (unsigned long long);
+}
+
+/**
+ *  \brief Clock initialization.
+ *
+ *  Must be called by the generator, after the semaphore set is created and before any entity is launched.
+ *  The area must be in the same shared region as the clock.
+ *
+ *  \param c pointer to the clock
+ *  \param virtualTime virtual time mode
+ *  \param nEntities number of entities that will bind to the clock
+ *  \param semgid semaphore set used by the entities
+ *  \param area pointer to a location with clockSize(nEntities) bytes
+ */
+void clockInit (SIM_CLOCK *c, bool virtualTime, int nEntities, int semgid, void *area)
+{
+    c->virtualTime = virtualTime;
+    c->semgid = semgid;
+    c->t0 = nowNs ();
+    c->now = 0;
+    c->tick = 0;
+    c->epoch = 0;
+    c->live = nEntities;                                  /* entities not yet launched count as running */
+    c->nSlots = nEntities;
+    c->nextSlot = 0;
+    c->offWake = (char *) area - (char *) c;
+    memset (area, 0, clockSize (nEntities));
+    clk = c;
+}
+
+/**
+ *  \brief Binding of the calling entity to the clock.
+ *
+ *  \param c pointer to the clock
+ */
+void clockAttach (SIM_CLOCK *c)
+{
+    clk = c;
+    if (c->virtualTime) {
+        slot = __atomic_fetch_add (&c->nextSlot, 1, __ATOMIC_SEQ_CST);
+        if (slot >= c->nSlots) {
+            fprintf (stderr, "Too many entities bound to the clock!\n");
+            exit (EXIT_FAILURE);
+        }
+    }
+}
+
+/**
+ *  \brief Release of the clock by the calling entity, upon termination.
+ */
+void clockDetach (void)
+{
+    if ((clk != NULL) && clk->virtualTime) {
+        __atomic_sub_fetch (&clk->live, 1, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch (&clk->epoch, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+/**
+ *  \brief Sleeping for a given time.
+ *
+ *  \param us time to sleep (in us)
+ */
+void clockSleep (unsigned int us)
+{
+    unsigned long long t;
+    int tick;
+
+    if ((clk == NULL) || !clk->virtualTime || (slot == -1)) {
+        usleep (us);
+        return;
+    }
+    if (us == 0) {
+        return;
+    }
+
+    t = __atomic_load_n (&clk->now, __ATOMIC_SEQ_CST) + us;
+    __atomic_store_n (&WAKE(clk, slot), t, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch (&clk->epoch, 1, __ATOMIC_SEQ_CST);
+    while (true) {
+        tick = __atomic_load_n (&clk->tick, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n (&clk->now, __ATOMIC_SEQ_CST) >= t) {
+            break;
+        }
+        futex (&clk->tick, FUTEX_WAIT, tick);                 /* returns on wake up, EAGAIN or EINTR */
+    }
+    __atomic_store_n (&WAKE(clk, slot), 0, __ATOMIC_SEQ_CST);
+}
+
+/**
+ *  \brief Present time since the start of the simulation.
+ *
+ *  \return time (in us), virtual or real according to the clock mode
+ */
+unsigned long long clockNow (void)
+{
+    if (clk == NULL) {
+        return 0;
+    }
+    if (clk->virtualTime) {
+        return __atomic_load_n (&clk->now, __ATOMIC_SEQ_CST);
+    }
+    return (nowNs () - clk->t0) / 1000;
+}
+
+/**
+ *  \brief Clock task: advancing virtual time.
+ *
+ *  Returns when all the entities have terminated (immediately in real time mode).
+ *
+ *  \param c pointer to the clock
+ */
+void clockRun (SIM_CLOCK *c)
+{
+    unsigned int ce, se, ce2, se2;                                       /* clock and semaphore activity counters */
+    unsigned long long now, w, next;
+    int live, blocked, sleeping, i;
+
+    if (!c->virtualTime) {
+        return;
+    }
+
+    while ((live = __atomic_load_n (&c->live, __ATOMIC_SEQ_CST)) > 0) {
+        ce = __atomic_load_n (&c->epoch, __ATOMIC_SEQ_CST);
+        if ((semEpoch (c->semgid, &se) == -1) || ((blocked = semBlocked (c->semgid)) == -1)) {
+            perror ("error on reading the semaphore set activity");
+            exit (EXIT_FAILURE);
+        }
+        now = __atomic_load_n (&c->now, __ATOMIC_SEQ_CST);
+        sleeping = 0;
+        next = 0;
+        for (i = 0; i < c->nSlots; i++) {
+            w = __atomic_load_n (&WAKE(c, i), __ATOMIC_SEQ_CST);
+            if (w > now) {
+                sleeping += 1;
+                if ((next == 0) || (w < next)) {
+                    next = w;
+                }
+            }
+        }
+        if (semEpoch (c->semgid, &se2) == -1) {
+            perror ("error on reading the semaphore set activity");
+            exit (EXIT_FAILURE);
+        }
+        ce2 = __atomic_load_n (&c->epoch, __ATOMIC_SEQ_CST);
+
+        if ((ce == ce2) && (se == se2) && (sleeping > 0) && (blocked + sleeping >= live) &&
+            (live == __atomic_load_n (&c->live, __ATOMIC_SEQ_CST)) && replayTurn ()) {
+            replayEnter (REPLAY_TICK, &c->now);
+            __atomic_store_n (&c->now, next, __ATOMIC_SEQ_CST);              /* jump to the next wake up time */
+            __atomic_add_fetch (&c->tick, 1, __ATOMIC_SEQ_CST);
+            replayLeave ((long long) next);
+            futex (&c->tick, FUTEX_WAKE, __INT_MAX__);
+        }
+        else {
+            usleep (CLOCKPOLL);
+        }
+    }
+}
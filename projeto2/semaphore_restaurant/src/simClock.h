@@ -0,0 +1,88 @@
+/**
+ *  \file simClock.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Simulation clock.
+ *
+ *  Defined operations:
+ *     \li clock initialization
+ *     \li binding of an entity to the clock and its release
+ *     \li sleeping for a given time
+ *     \li reading the present time
+ *     \li advancing virtual time (clock task).
+ *
+ *  In real time mode sleeping is <tt>usleep</tt>. In virtual time mode sleeping entities are blocked until the
+ *  clock task advances virtual time to their wake up time, which only happens when every entity is either
+ *  sleeping or blocked on a semaphore: virtual time then jumps straight to the earliest wake up time. The
+ *  order of the events is the one real time would produce with sleeps much longer than the processing.
+ *  Virtual time needs the futex semaphores (see semBlocked).
+ */
+
+#ifndef SIMCLOCK_H_
+#define SIMCLOCK_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "probDataStruct.h"
+
+/**
+ *  \brief Size of the area that holds the wake up times of the entities.
+ *
+ *  \param nEntities number of entities
+ *
+ *  \return size in bytes, multiple of 8
+ */
+extern size_t clockSize (int nEntities);
+
+/**
+ *  \brief Clock initialization.
+ *
+ *  Must be called by the generator, after the semaphore set is created and before any entity is launched.
+ *  The area must be in the same shared region as the clock.
+ *
+ *  \param c pointer to the clock
+ *  \param virtualTime virtual time mode
+ *  \param nEntities number of entities that will bind to the clock
+ *  \param semgid semaphore set used by the entities
+ *  \param area pointer to a location with clockSize(nEntities) bytes
+ */
+extern void clockInit (SIM_CLOCK *c, bool virtualTime, int nEntities, int semgid, void *area);
+
+/**
+ *  \brief Binding of the calling entity to the clock.
+ *
+ *  \param c pointer to the clock
+ */
+extern void clockAttach (SIM_CLOCK *c);
+
+/**
+ *  \brief Release of the clock by the calling entity, upon termination.
+ */
+extern void clockDetach (void);
+
+/**
+ *  \brief Sleeping for a given time.
+ *
+ *  \param us time to sleep (in us)
+ */
+extern void clockSleep (unsigned int us);
+
+/**
+ *  \brief Present time since the start of the simulation.
+ *
+ *  \return time (in us), virtual or real according to the clock mode
+ */
+extern unsigned long long clockNow (void);
+
+/**
+ *  \brief Clock task: advancing virtual time.
+ *
+ *  Returns when all the entities have terminated (immediately in real time mode).
+ *
+ *  \param c pointer to the clock
+ */
+extern void clockRun (SIM_CLOCK *c);
+
+#endif /* SIMCLOCK_H_ */
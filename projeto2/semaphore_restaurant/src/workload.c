@@ -0,0 +1,124 @@
+/**
+ *  \file workload.c (implementation file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Generated workloads.
+ *
+ *  Defined operations:
+ *     \li parsing of a workload specification
+ *     \li generation of the start and eat times and of the sizes of the groups.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+
+#include "probConst.h"
+#include "workload.h"
+#include "prng.h"
+
+/**
+ *  \brief Parsing of a workload specification.
+ *
+ *  \param spec specification line
+ *  \param w pointer to the location where the workload is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the specification is wrong
+ */
+int workloadParse (char *spec, WORKLOAD *w)
+{
+    char arrival[16], eat[16];
+    int n;
+
+    w->maxSize = 1;
+    n = sscanf (spec, "%d %15s %lf %15s %lf %llu %d", &w->nGroups, arrival, &w->rate, eat, &w->eatMean, &w->seed,
+                &w->maxSize);
+    if ((n != 6) && (n != 7)) {
+        return -1;
+    }
+    if ((w->nGroups < 1) || (w->nGroups > MAXGROUPS) || (w->rate <= 0.0) || (w->eatMean < 0.0) || (w->maxSize < 1)) {
+        return -1;
+    }
+
+    w->burst = 1;
+    if (strcmp (arrival, "poisson") == 0) {
+        w->arrival = ARR_POISSON;
+    }
+    else if (strcmp (arrival, "uniform") == 0) {
+        w->arrival = ARR_UNIFORM;
+    }
+    else if ((sscanf (arrival, "burst/%u", &w->burst) == 1) && (w->burst >= 1)) {
+        w->arrival = ARR_BURST;
+    }
+    else return -1;
+
+    if (strcmp (eat, "fixed") == 0) {
+        w->eat = EAT_FIXED;
+    }
+    else if (strcmp (eat, "exp") == 0) {
+        w->eat = EAT_EXP;
+    }
+    else if (strcmp (eat, "uniform") == 0) {
+        w->eat = EAT_UNIFORM;
+    }
+    else if (strcmp (eat, "normal") == 0) {
+        w->eat = EAT_NORMAL;
+    }
+    else return -1;
+
+    return 0;
+}
+
+/**
+ *  \brief Generation of the start and eat times and of the sizes of the groups.
+ *
+ *  The sizes are drawn from a stream of their own: the times do not depend on the largest size.
+ *
+ *  \param w pointer to the workload
+ *  \param startTime array where the start time of each group is stored (in us)
+ *  \param eatTime array where the eat time of each group is stored (in us)
+ *  \param groupSize array where the number of people of each group is stored
+ */
+void workloadSchedule (WORKLOAD *w, int startTime[], int eatTime[], int groupSize[])
+{
+    PRNG r, rs;
+    double gap = 1e6 / w->rate,                                                       /* mean time between arrivals */
+           t = 0.0, e;
+    int g;
+
+    prngSeed (&r, w->seed, ENTITYID(ENT_GENERATOR, 0));
+    prngSeed (&rs, w->seed, ENTITYID(ENT_GENERATOR, 1));
+    for (g = 0; g < w->nGroups; g++) {
+        switch (w->arrival) {
+            case ARR_POISSON:
+                t += prngExp (&r, gap);
+                break;
+            case ARR_UNIFORM:
+                t += gap;
+                break;
+            case ARR_BURST:                                           /* the first group of a burst sets its time */
+                if (g % w->burst == 0) {
+                    t += prngExp (&r, gap * w->burst);
+                }
+                break;
+        }
+        switch (w->eat) {
+            case EAT_FIXED:
+                e = w->eatMean;
+                break;
+            case EAT_EXP:
+                e = prngExp (&r, w->eatMean);
+                break;
+            case EAT_UNIFORM:
+                e = 2.0 * w->eatMean * prngUniform (&r);
+                break;
+            default:
+                e = w->eatMean + prngNormal (&r, w->eatMean / 4.0);
+        }
+        startTime[g] = (t < INT_MAX) ? (int) t : INT_MAX;
+        eatTime[g] = (e <= 0.0) ? 0 : (e < INT_MAX) ? (int) e : INT_MAX;
+        groupSize[g] = 1 + (int) (prngUniform (&rs) * w->maxSize);
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ *  \file workload.h (interface file)
+ *
+ *  \brief Problem name: Restaurant
+ *
+ *  \brief Generated workloads.
+ *
+ *  Defined operations:
+ *     \li parsing of a workload specification
+ *     \li generation of the start and eat times and of the sizes of the groups.
+ *
+ *  A workload specification replaces the list of start and eat times of config.txt by a single line
+ *     <tt>groups arrival rate eat mean seed [size]</tt>
+ *  where
+ *     \li groups is the number of groups
+ *     \li arrival is the arrival process: <tt>poisson</tt>, <tt>uniform</tt> (evenly spaced) or <tt>burst/k</tt>
+ *         (bursts of k groups arriving together, the bursts being a Poisson process)
+ *     \li rate is the mean arrival rate (groups per second)
+ *     \li eat is the eat time distribution: <tt>fixed</tt>, <tt>exp</tt>, <tt>uniform</tt> (0 .. 2*mean) or
+ *         <tt>normal</tt> (standard deviation mean/4)
+ *     \li mean is the mean eat time (in us)
+ *     \li seed is the seed of the schedule
+ *     \li size is the largest number of people of a group (1 if missing); group sizes are uniform in 1 .. size.
+ */
+
+#ifndef WORKLOAD_H_
+#define WORKLOAD_H_
+
+/** \brief Poisson arrivals */
+#define  ARR_POISSON       0
+/** \brief evenly spaced arrivals */
+#define  ARR_UNIFORM       1
+/** \brief bursts of arrivals */
+#define  ARR_BURST         2
+
+/** \brief every group eats for the mean time */
+#define  EAT_FIXED         0
+/** \brief exponential eat times */
+#define  EAT_EXP           1
+/** \brief uniform eat times */
+#define  EAT_UNIFORM       2
+/** \brief normal eat times */
+#define  EAT_NORMAL        3
+
+/**
+ *  \brief Definition of a workload.
+ */
+typedef struct {
+    /** \brief number of groups */
+    int nGroups;
+    /** \brief arrival process */
+    unsigned int arrival;
+    /** \brief number of groups of a burst (ARR_BURST) */
+    unsigned int burst;
+    /** \brief mean arrival rate (groups per second) */
+    double rate;
+    /** \brief eat time distribution */
+    unsigned int eat;
+    /** \brief mean eat time (in us) */
+    double eatMean;
+    /** \brief seed of the schedule */
+    unsigned long long seed;
+    /** \brief largest number of people of a group */
+    int maxSize;
+} WORKLOAD;
+
+/**
+ *  \brief Parsing of a workload specification.
+ *
+ *  \param spec specification line
+ *  \param w pointer to the location where the workload is stored
+ *
+ *  \return \c 0, upon success
+ *  \return -\c 1, if the specification is wrong
+ */
+extern int workloadParse (char *spec, WORKLOAD *w);
+
+/**
+ *  \brief Generation of the start and eat times and of the sizes of the groups.
+ *
+ *  The sizes are drawn from a stream of their own: the times do not depend on the largest size.
+ *
+ *  \param w pointer to the workload
+ *  \param startTime array where the start time of each group is stored (in us)
+ *  \param eatTime array where the eat time of each group is stored (in us)
+ *  \param groupSize array where the number of people of each group is stored
+ */
+extern void workloadSchedule (WORKLOAD *w, int startTime[], int eatTime[], int groupSize[]);
+
+#endif /* WORKLOAD_H_ */